@@ -0,0 +1,2 @@
+cp ../hawkey/yum/tour-4-6.noarch.rpm ../modules/modules/base-runtime-rhel73-1/noarch/kernel-doc-3.10.0-514.noarch.rpm .
+rpmsign --define "_gpg_path ../gpgkey/" --define "_gpg_name libhif test key" --addsign tour-4-6.noarch.rpm kernel-doc-3.10.0-514.noarch.rpm
@@ -256,6 +256,7 @@ class ConfigMain::Impl {
     OptionString color_search_match{"bold,magenta"};
     OptionBool history_record{true};
     OptionStringList history_record_packages{std::vector<std::string>{"dnf", "rpm"}};
+    OptionBool history_relaxed_sync{false};
     OptionString rpmverbosity{"info"};
     OptionBool strict{true}; // :api
     OptionBool skip_broken{false}; // :yum-compatibility
@@ -421,6 +422,7 @@ ConfigMain::Impl::Impl(Config & owner)
     owner.optBinds().add("color_search_match", color_search_match);
     owner.optBinds().add("history_record", history_record);
     owner.optBinds().add("history_record_packages", history_record_packages);
+    owner.optBinds().add("history_relaxed_sync", history_relaxed_sync);
     owner.optBinds().add("rpmverbosity", rpmverbosity);
     owner.optBinds().add("strict", strict);
     owner.optBinds().add("skip_broken", skip_broken);
@@ -553,6 +555,7 @@ OptionString & ConfigMain::color_update_remote() { return pImpl->color_update_re
 OptionString & ConfigMain::color_search_match() { return pImpl->color_search_match; }
 OptionBool & ConfigMain::history_record() { return pImpl->history_record; }
 OptionStringList & ConfigMain::history_record_packages() { return pImpl->history_record_packages; }
+OptionBool & ConfigMain::history_relaxed_sync() { return pImpl->history_relaxed_sync; }
 OptionString & ConfigMain::rpmverbosity() { return pImpl->rpmverbosity; }
 OptionBool & ConfigMain::strict() { return pImpl->strict; }
 OptionBool & ConfigMain::skip_broken() { return pImpl->skip_broken; }
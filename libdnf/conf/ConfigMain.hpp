@@ -111,6 +111,7 @@ public:
     OptionString & color_search_match();
     OptionBool & history_record();
     OptionStringList & history_record_packages();
+    OptionBool & history_relaxed_sync();
     OptionString & rpmverbosity();
     OptionBool & strict(); // :api
     OptionBool & skip_broken(); // :yum-compatibility
@@ -154,6 +154,7 @@ typedef struct
     gboolean         only_trusted;
     gboolean         enable_filelists;
     gboolean         keep_cache;
+    gboolean         reuse_sack;
     gboolean         enrollment_valid;
     gboolean         write_history;
     DnfLock         *lock;
@@ -978,6 +979,23 @@ dnf_context_get_keep_cache(DnfContext *context)
     return priv->keep_cache;
 }
 
+/**
+ * dnf_context_get_reuse_sack:
+ * @context: a #DnfContext instance.
+ *
+ * Gets if the sack is kept after a transaction and on rpmdb changes.
+ *
+ * Returns: %TRUE if only the installed packages are refreshed
+ *
+ * Since: 0.55.0
+ **/
+gboolean
+dnf_context_get_reuse_sack(DnfContext *context)
+{
+    DnfContextPrivate *priv = GET_PRIVATE(context);
+    return priv->reuse_sack;
+}
+
 /**
  * dnf_context_get_only_trusted:
  * @context: a #DnfContext instance.
@@ -1467,6 +1485,27 @@ dnf_context_set_keep_cache(DnfContext *context, gboolean keep_cache)
     priv->keep_cache = keep_cache;
 }
 
+/**
+ * dnf_context_set_reuse_sack:
+ * @context: a #DnfContext instance.
+ * @reuse_sack: %TRUE to refresh only the installed packages
+ *
+ * Enables or disables keeping the sack after dnf_context_run() and on rpmdb
+ * changes. When enabled, only the installed packages are re-read and the
+ * available repos stay loaded, so long running daemons do not have to load
+ * everything again after each transaction. Packages of the previous @System
+ * repo must not be used after a refresh. The #DnfContext::invalidate signal is
+ * not emitted for rpmdb changes which were applied to the sack.
+ *
+ * Since: 0.55.0
+ **/
+void
+dnf_context_set_reuse_sack(DnfContext *context, gboolean reuse_sack)
+{
+    DnfContextPrivate *priv = GET_PRIVATE(context);
+    priv->reuse_sack = reuse_sack;
+}
+
 /**
  * dnf_context_set_enable_filelists:
  * @context: a #DnfContext instance.
@@ -1661,6 +1700,13 @@ dnf_context_rpmdb_changed_cb(GFileMonitor *monitor_,
                              GFileMonitorEvent event_type,
                              DnfContext *context)
 {
+    DnfContextPrivate *priv = GET_PRIVATE(context);
+    if (priv->reuse_sack && priv->sack != NULL) {
+        g_autoptr(GError) error_local = NULL;
+        if (dnf_sack_refresh_system_repo(priv->sack, &error_local))
+            return;
+        g_debug("failed to refresh installed packages: %s", error_local->message);
+    }
     dnf_context_invalidate(context, "rpmdb changed");
 }
 
@@ -2297,6 +2343,17 @@ dnf_context_run(DnfContext *context, GCancellable *cancellable, GError **error)
     if (!ret)
         return FALSE;
 
+    /* refresh the installed packages and keep the available repos */
+    if (priv->reuse_sack && priv->sack != NULL) {
+        g_autoptr(GError) error_local = NULL;
+        if (dnf_sack_refresh_system_repo(priv->sack, &error_local)) {
+            hy_goal_free(priv->goal);
+            priv->goal = hy_goal_create(priv->sack);
+            return dnf_state_done(priv->state, error);
+        }
+        g_debug("failed to refresh installed packages: %s", error_local->message);
+    }
+
     /* this sack is no longer valid */
     g_object_unref(priv->sack);
     priv->sack = NULL;
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __DNF_KEYRING_PRIVATE_HPP
+#define __DNF_KEYRING_PRIVATE_HPP
+
+#include "dnf-keyring.h"
+
+#include <rpm/rpmts.h>
+
+
+gboolean         dnf_keyring_check_untrusted_file_with_ts(rpmts          ts,
+                                                 rpmKeyring              keyring,
+                                                 const gchar            *filename,
+                                                 GError                 **error);
+
+#endif /* __DNF_KEYRING_PRIVATE_HPP */
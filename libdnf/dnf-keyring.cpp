@@ -38,6 +38,7 @@
 #include "catch-error.hpp"
 #include "dnf-types.h"
 #include "dnf-keyring.h"
+#include "dnf-keyring-private.hpp"
 #include "dnf-utils.h"
 
 /**
@@ -212,12 +213,20 @@ dnf_keyring_add_public_keys(rpmKeyring keyring, GError **error) try
 } CATCH_TO_GERROR(FALSE)
 
 /**
- * dnf_keyring_check_untrusted_file:
+ * dnf_keyring_check_untrusted_file_with_ts:
+ * @ts: a #rpmts used to read the package, not shared with other threads.
+ * @keyring: a #rpmKeyring instance.
+ * @filename: the package filename.
+ * @error: a #GError or %NULL.
+ *
+ * Like dnf_keyring_check_untrusted_file(), but reuses @ts so a caller
+ * checking many files creates it only once.
  */
 gboolean
-dnf_keyring_check_untrusted_file(rpmKeyring keyring,
-                                 const gchar *filename,
-                                 GError **error) try
+dnf_keyring_check_untrusted_file_with_ts(rpmts ts,
+                                         rpmKeyring keyring,
+                                         const gchar *filename,
+                                         GError **error) try
 {
     FD_t fd = NULL;
     gboolean ret = FALSE;
@@ -225,7 +234,6 @@ dnf_keyring_check_untrusted_file(rpmKeyring keyring,
     pgpDig dig = NULL;
     rpmRC rc;
     rpmtd td = NULL;
-    rpmts ts = NULL;
 
     /* open the file for reading */
     fd = Fopen(filename, "r.fdio");
@@ -248,7 +256,6 @@ dnf_keyring_check_untrusted_file(rpmKeyring keyring,
     }
 
     /* we don't want to abort on missing keys */
-    ts = rpmtsCreate();
     rpmtsSetVSFlags(ts, _RPMVSF_NOSIGNATURES);
 
     /* read in the file */
@@ -319,11 +326,23 @@ out:
         rpmtdFreeData(td);
         rpmtdFree(td);
     }
-    if (ts != NULL)
-        rpmtsFree(ts);
     if (hdr != NULL)
         headerFree(hdr);
     if (fd != NULL)
         Fclose(fd);
     return ret;
 } CATCH_TO_GERROR(FALSE)
+
+/**
+ * dnf_keyring_check_untrusted_file:
+ */
+gboolean
+dnf_keyring_check_untrusted_file(rpmKeyring keyring,
+                                 const gchar *filename,
+                                 GError **error) try
+{
+    rpmts ts = rpmtsCreate();
+    gboolean ret = dnf_keyring_check_untrusted_file_with_ts(ts, keyring, filename, error);
+    rpmtsFree(ts);
+    return ret;
+} CATCH_TO_GERROR(FALSE)
@@ -39,6 +39,7 @@
 
 #include <librepo/librepo.h>
 #include <memory>
+#include <vector>
 
 #include "catch-error.hpp"
 #include "dnf-package.h"
@@ -685,89 +686,217 @@ dnf_repo_checksum_hy_to_lr(GChecksumType checksum)
     return LR_CHECKSUM_SHA512;
 }
 
-/**
- * dnf_package_check_filename:
- * @pkg: a #DnfPackage *instance.
- * @valid: Set to %TRUE if the package is valid.
- * @error: a #GError or %NULL..
- *
- * Checks the package is already downloaded and valid.
- *
- * Returns: %TRUE if the package was checked successfully
- *
- * Since: 0.1.0
- **/
-gboolean
-dnf_package_check_filename(DnfPackage *pkg, gboolean *valid, GError **error) try
+/* maximal number of packages checked at once by dnf_package_array_check_filename() */
+#define DNF_PACKAGE_CHECK_FILENAME_THREADS_MAX  4
+
+/* a downloaded file to check, the checksum is computed without touching the pool */
+typedef struct {
+    const gchar     *path;
+    gchar           *checksum;      /* expected checksum, %NULL if the file is missing */
+    LrChecksumType   checksum_type;
+    gboolean         valid;
+    GError          *error;
+} DnfPackageCheckItem;
+
+/* reads the expected checksum, fails for a file missing in a local repository */
+static gboolean
+dnf_package_check_filename_begin(DnfPackage *pkg, DnfPackageCheckItem *item, GError **error)
 {
-    LrChecksumType checksum_type_lr;
-    char *checksum_valid = NULL;
-    const gchar *path;
     const unsigned char *checksum;
-    gboolean ret = TRUE;
     int checksum_type_hy;
-    int fd;
 
-    /* check if the file does not exist */
-    path = dnf_package_get_filename(pkg);
-    g_debug("checking if %s already exists...", path);
-    if (!g_file_test(path, G_FILE_TEST_EXISTS)) {
-        *valid = FALSE;
+    item->checksum = NULL;
+    item->valid = FALSE;
+    item->error = NULL;
 
+    /* check if the file does not exist */
+    item->path = dnf_package_get_filename(pkg);
+    g_debug("checking if %s already exists...", item->path);
+    if (!g_file_test(item->path, G_FILE_TEST_EXISTS)) {
         /* a missing file in a local repo is an error, unless it is remote via base:url,
          * since we can't download it */
         if (dnf_package_is_local(pkg)) {
-            ret = FALSE;
             g_set_error(error,
                         DNF_ERROR,
                         DNF_ERROR_INTERNAL_ERROR,
-                        "File missing in local repository %s", path);
+                        "File missing in local repository %s", item->path);
+            return FALSE;
         }
-
-        goto out;
+        return TRUE;
     }
 
-    /* check the checksum */
     checksum = dnf_package_get_chksum(pkg, &checksum_type_hy);
-    checksum_valid = hy_chksum_str(checksum, checksum_type_hy);
-    checksum_type_lr = dnf_repo_checksum_hy_to_lr((GChecksumType)checksum_type_hy);
-    fd = g_open(path, O_RDONLY, 0);
+    item->checksum = hy_chksum_str(checksum, checksum_type_hy);
+    item->checksum_type = dnf_repo_checksum_hy_to_lr((GChecksumType)checksum_type_hy);
+    return TRUE;
+}
+
+/* compares the checksum of the file, safe to be called from any thread */
+static void
+dnf_package_check_filename_compute(DnfPackageCheckItem *item)
+{
+    int fd;
+
+    if (item->checksum == NULL)
+        return;
+    fd = g_open(item->path, O_RDONLY, 0);
     if (fd < 0) {
-        ret = FALSE;
-        g_set_error(error,
-                 DNF_ERROR,
-                 DNF_ERROR_INTERNAL_ERROR,
-                 "Failed to open %s", path);
-        goto out;
+        g_set_error(&item->error,
+                    DNF_ERROR,
+                    DNF_ERROR_INTERNAL_ERROR,
+                    "Failed to open %s", item->path);
+        return;
     }
-    ret = lr_checksum_fd_cmp(checksum_type_lr,
-                 fd,
-                 checksum_valid,
-                 TRUE, /* use xattr value */
-                 valid,
-                 error);
-    if (!ret) {
+
+    /* the whole file is read unless librepo has the checksum cached in xattr */
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (!lr_checksum_fd_cmp(item->checksum_type,
+                            fd,
+                            item->checksum,
+                            TRUE, /* use xattr value */
+                            &item->valid,
+                            &item->error)) {
         g_close(fd, NULL);
-        goto out;
+        return;
     }
-    ret = g_close(fd, error);
-    if (!ret)
+    g_close(fd, &item->error);
+}
+
+/* reports the result of the check, frees the item */
+static gboolean
+dnf_package_check_filename_end(DnfPackage *pkg, DnfPackageCheckItem *item, gboolean *valid, GError **error)
+{
+    gboolean ret = TRUE;
+
+    *valid = item->valid;
+    if (item->error != NULL) {
+        g_propagate_error(error, item->error);
+        item->error = NULL;
+        ret = FALSE;
         goto out;
+    }
 
     /* A checksum mismatch for a package in a local repository is an
        error.  We can't repair it by downloading a corrected version,
        so let's fail here. */
-    if (!*valid && dnf_repo_is_local (dnf_package_get_repo (pkg))) {
+    if (item->checksum != NULL && !item->valid && dnf_repo_is_local(dnf_package_get_repo(pkg))) {
         ret = FALSE;
         g_set_error(error,
                     DNF_ERROR,
                     DNF_ERROR_INTERNAL_ERROR,
-                    "Checksum mismatch in local repository %s", path);
+                    "Checksum mismatch in local repository %s", item->path);
         goto out;
     }
 
 out:
-    g_free(checksum_valid);
+    g_free(item->checksum);
+    item->checksum = NULL;
+    return ret;
+}
+
+/**
+ * dnf_package_check_filename:
+ * @pkg: a #DnfPackage *instance.
+ * @valid: Set to %TRUE if the package is valid.
+ * @error: a #GError or %NULL..
+ *
+ * Checks the package is already downloaded and valid.
+ *
+ * Returns: %TRUE if the package was checked successfully
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+dnf_package_check_filename(DnfPackage *pkg, gboolean *valid, GError **error) try
+{
+    DnfPackageCheckItem item;
+
+    *valid = FALSE;
+    if (!dnf_package_check_filename_begin(pkg, &item, error))
+        return FALSE;
+    dnf_package_check_filename_compute(&item);
+    return dnf_package_check_filename_end(pkg, &item, valid, error);
+} CATCH_TO_GERROR(FALSE)
+
+/* shared by the workers, each worker takes the next unchecked item */
+typedef struct {
+    DnfPackageCheckItem *items;
+    gint n_items;
+    gint next;      /* atomic */
+} DnfPackageCheckJob;
+
+static gpointer
+dnf_package_check_filename_worker(gpointer user_data)
+{
+    auto job = static_cast<DnfPackageCheckJob *>(user_data);
+    while (true) {
+        gint i = g_atomic_int_add(&job->next, 1);
+        if (i >= job->n_items)
+            break;
+        dnf_package_check_filename_compute(&job->items[i]);
+    }
+    return NULL;
+}
+
+/**
+ * dnf_package_array_check_filename:
+ * @packages: an array of packages.
+ * @valid: an array of @packages->len values, set to %TRUE for packages that are valid.
+ * @error: a #GError or %NULL..
+ *
+ * Checks the packages are already downloaded and valid, like
+ * dnf_package_check_filename(). The checksums of the files are computed
+ * concurrently. On failure, the error of the first failing package
+ * in @packages is returned.
+ *
+ * Returns: %TRUE if the packages were checked successfully
+ *
+ * Since: 0.55.0
+ **/
+gboolean
+dnf_package_array_check_filename(GPtrArray *packages, gboolean *valid, GError **error) try
+{
+    g_autoptr(GError) error_begin = NULL;
+    DnfPackageCheckJob job;
+    gboolean ret = TRUE;
+    guint n_items;
+    guint n_workers;
+
+    /* the pool is not thread-safe, read the expected checksums in advance;
+     * packages following a failing one are not checked at all */
+    std::vector<DnfPackageCheckItem> items(packages->len);
+    for (guint i = 0; i < packages->len; i++)
+        valid[i] = FALSE;
+    for (n_items = 0; n_items < packages->len; n_items++) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(packages, n_items));
+        if (!dnf_package_check_filename_begin(pkg, &items[n_items], &error_begin))
+            break;
+    }
+
+    job.items = items.data();
+    job.n_items = n_items;
+    job.next = 0;
+    n_workers = MIN(MIN(g_get_num_processors(), DNF_PACKAGE_CHECK_FILENAME_THREADS_MAX), n_items);
+    std::vector<GThread *> workers;
+    for (guint i = 0; i < n_workers; i++)
+        workers.push_back(g_thread_new("check-filename", dnf_package_check_filename_worker, &job));
+    for (auto worker : workers)
+        g_thread_join(worker);
+
+    for (guint i = 0; i < n_items; i++) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(packages, i));
+        if (!ret) {
+            g_clear_error(&items[i].error);
+            g_free(items[i].checksum);
+            continue;
+        }
+        ret = dnf_package_check_filename_end(pkg, &items[i], &valid[i], error);
+    }
+    if (ret && error_begin != NULL) {
+        g_propagate_error(error, error_begin);
+        error_begin = NULL;
+        ret = FALSE;
+    }
     return ret;
 } CATCH_TO_GERROR(FALSE)
 
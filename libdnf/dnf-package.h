@@ -95,6 +95,9 @@ gboolean         dnf_package_check_filename             (DnfPackage     *pkg,
                                                          gboolean       *valid,
                                                          GError         **error);
 
+gboolean         dnf_package_array_check_filename       (GPtrArray      *packages,
+                                                         gboolean       *valid,
+                                                         GError         **error);
 gboolean         dnf_package_array_download             (GPtrArray      *packages,
                                                          const gchar    *directory,
                                                          DnfState       *state,
@@ -38,9 +38,14 @@
 #include "dnf-context.hpp"
 #include "hy-repo-private.hpp"
 #include "hy-iutil-private.hpp"
+#include "dnf-sack-private.hpp"
+#include "hy-package-private.hpp"
+#include "sack/query.hpp"
 
 #include <strings.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <glib/gstdio.h>
 #include "hy-util.h"
 #include <librepo/librepo.h>
@@ -56,8 +61,10 @@
 #include "utils/File.hpp"
 #include "utils/url-encode.hpp"
 
+#include <algorithm>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 typedef struct
@@ -1237,6 +1244,9 @@ dnf_repo_setup(DnfRepo *repo, GError **error) try
         return FALSE;
     if (!lr_handle_setopt(priv->repo_handle, error, LRO_INTERRUPTIBLE, 0L))
         return FALSE;
+    if (!lr_handle_setopt(priv->repo_handle, error, LRO_MAXPARALLELDOWNLOADS,
+                          (long)priv->repo->getConfig()->max_parallel_downloads().getValue()))
+        return FALSE;
     priv->urlvars = lr_urlvars_set(priv->urlvars, "releasever", release);
     priv->urlvars = lr_urlvars_set(priv->urlvars, "basearch", basearch);
 
@@ -1389,6 +1399,78 @@ dnf_repo_set_timestamp_modified(DnfRepo *repo, GError **error)
     return TRUE;
 }
 
+/* written to the repodata directory after the metadata checksums were verified */
+#define DNF_REPO_VERIFIED_COOKIE ".verified"
+
+/**
+ * dnf_repo_get_verified_cookie:
+ *
+ * Computes a cookie describing the state of the metadata files found by
+ * librepo. It is built from the stat tuple (device, inode, size, mtime) of
+ * every file in the style of checksum_stat(), so it changes whenever a file
+ * is rewritten.
+ *
+ * Returns: the cookie, or %NULL if a file cannot be stat-ed
+ **/
+static gchar *
+dnf_repo_get_verified_cookie(const std::vector<const char *> & download_list,
+                             LrYumRepo *yum_repo)
+{
+    std::vector<std::pair<std::string, std::string>> files;
+    if (yum_repo->repomd)
+        files.emplace_back("repomd", yum_repo->repomd);
+    for (auto *elem = yum_repo->paths; elem; elem = g_slist_next(elem)) {
+        auto yumrepopath = static_cast<LrYumRepoPath *>(elem->data);
+        if (yumrepopath && yumrepopath->type && yumrepopath->path)
+            files.emplace_back(yumrepopath->type, yumrepopath->path);
+    }
+    std::sort(files.begin(), files.end());
+
+    g_autoptr(GChecksum) checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    for (const auto item : download_list) {
+        if (item)
+            g_checksum_update(checksum, reinterpret_cast<const guchar *>(item), strlen(item) + 1);
+    }
+    for (const auto & file : files) {
+        struct stat st;
+        if (stat(file.second.c_str(), &st) != 0)
+            return NULL;
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(file.first.c_str()),
+                          file.first.size() + 1);
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(file.second.c_str()),
+                          file.second.size() + 1);
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(&st.st_dev), sizeof(st.st_dev));
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(&st.st_ino), sizeof(st.st_ino));
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(&st.st_size), sizeof(st.st_size));
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(&st.st_mtim.tv_sec),
+                          sizeof(st.st_mtim.tv_sec));
+        g_checksum_update(checksum, reinterpret_cast<const guchar *>(&st.st_mtim.tv_nsec),
+                          sizeof(st.st_mtim.tv_nsec));
+    }
+    return g_strdup(g_checksum_get_string(checksum));
+}
+
+/**
+ * dnf_repo_locate_metadata:
+ *
+ * Runs librepo on the local copy of the metadata to locate the files,
+ * without verifying their checksums.
+ *
+ * Returns: %TRUE if all the files were found
+ **/
+static gboolean
+dnf_repo_locate_metadata(DnfRepo *repo, LrYumRepo **yum_repo)
+{
+    DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    g_autoptr(GError) error_local = NULL;
+    if (!lr_handle_setopt(priv->repo_handle, &error_local, LRO_CHECKSUM, 0L))
+        return FALSE;
+    lr_result_clear(priv->repo_result);
+    if (!lr_handle_perform(priv->repo_handle, priv->repo_result, &error_local))
+        return FALSE;
+    return lr_result_getinfo(priv->repo_result, &error_local, LRR_YUM_REPO, yum_repo);
+}
+
 static gboolean
 dnf_repo_check_internal(DnfRepo *repo,
                         guint permissible_cache_age,
@@ -1450,8 +1532,6 @@ dnf_repo_check_internal(DnfRepo *repo,
         return FALSE;
     if (!lr_handle_setopt(priv->repo_handle, error, LRO_LOCAL, 1L))
         return FALSE;
-    if (!lr_handle_setopt(priv->repo_handle, error, LRO_CHECKSUM, 1L))
-        return FALSE;
     if (!lr_handle_setopt(priv->repo_handle, error, LRO_YUMDLIST, download_list.data()))
         return FALSE;
     if (!lr_handle_setopt(priv->repo_handle, error, LRO_MIRRORLISTURL, NULL))
@@ -1460,24 +1540,64 @@ dnf_repo_check_internal(DnfRepo *repo,
         return FALSE;
     if (!lr_handle_setopt(priv->repo_handle, error, LRO_GNUPGHOMEDIR, priv->keyring))
         return FALSE;
-    lr_result_clear(priv->repo_result);
-    if (!lr_handle_perform(priv->repo_handle, priv->repo_result, &error_local)) {
-        g_set_error(error,
-                    DNF_ERROR,
-                    DNF_ERROR_REPO_NOT_AVAILABLE,
-                    "repodata %s was not complete: %s",
-                    priv->repo->getId().c_str(), error_local->message);
-        return FALSE;
-    }
 
-    /* get the metadata file locations */
-    if (!lr_result_getinfo(priv->repo_result, &error_local, LRR_YUM_REPO, &yum_repo)) {
-        g_set_error(error,
-                    DNF_ERROR,
-                    DNF_ERROR_INTERNAL_ERROR,
-                    "failed to get yum-repo: %s",
-                    error_local->message);
+    /* the checksums of the cached metadata were verified before, so skip
+     * hashing them again if none of the files was changed since; the files
+     * are located without hashing them and their state is taken before any
+     * verification, so a file replaced while it is verified does not end up
+     * in a cookie */
+    g_autofree gchar *cookie_fn = g_build_filename(priv->location, "repodata",
+                                                   DNF_REPO_VERIFIED_COOKIE, NULL);
+    g_autofree gchar *cookie_before = NULL;
+    gboolean verified = FALSE;
+    if (priv->kind == DNF_REPO_KIND_REMOTE) {
+        g_autofree gchar *cookie = NULL;
+        if (dnf_repo_locate_metadata(repo, &yum_repo))
+            cookie_before = dnf_repo_get_verified_cookie(download_list, yum_repo);
+        if (cookie_before &&
+            g_file_get_contents(cookie_fn, &cookie, NULL, NULL) &&
+            g_strcmp0(cookie, cookie_before) == 0) {
+            verified = TRUE;
+        } else {
+            g_debug("metadata of %s not verified before, checking checksums",
+                    priv->repo->getId().c_str());
+        }
+    }
+    /* the handle is reused by dnf_repo_update(), never leave the checksums off */
+    if (!lr_handle_setopt(priv->repo_handle, error, LRO_CHECKSUM, 1L))
         return FALSE;
+    if (!verified) {
+        lr_result_clear(priv->repo_result);
+        if (!lr_handle_perform(priv->repo_handle, priv->repo_result, &error_local)) {
+            g_set_error(error,
+                        DNF_ERROR,
+                        DNF_ERROR_REPO_NOT_AVAILABLE,
+                        "repodata %s was not complete: %s",
+                        priv->repo->getId().c_str(), error_local->message);
+            return FALSE;
+        }
+
+        /* get the metadata file locations */
+        if (!lr_result_getinfo(priv->repo_result, &error_local, LRR_YUM_REPO, &yum_repo)) {
+            g_set_error(error,
+                        DNF_ERROR,
+                        DNF_ERROR_INTERNAL_ERROR,
+                        "failed to get yum-repo: %s",
+                        error_local->message);
+            return FALSE;
+        }
+
+        /* only files left alone during the verification were verified */
+        if (cookie_before) {
+            g_autofree gchar *cookie_after = dnf_repo_get_verified_cookie(download_list,
+                                                                          yum_repo);
+            g_autoptr(GError) error_cookie = NULL;
+            if (g_strcmp0(cookie_before, cookie_after) != 0)
+                g_debug("metadata of %s changed while verified, not writing %s",
+                        priv->repo->getId().c_str(), cookie_fn);
+            else if (!g_file_set_contents(cookie_fn, cookie_before, -1, &error_cookie))
+                g_debug("failed to write %s: %s", cookie_fn, error_cookie->message);
+        }
     }
 
     /* get timestamp */
@@ -1849,6 +1969,11 @@ dnf_repo_update(DnfRepo *repo,
                            LRO_LOCAL, 0L);
     if (!ret)
         goto out;
+    /* downloaded metadata are always verified, whatever the local check did */
+    ret = lr_handle_setopt(priv->repo_handle, error,
+                           LRO_CHECKSUM, 1L);
+    if (!ret)
+        goto out;
     ret = lr_handle_setopt(priv->repo_handle, error,
                            LRO_DESTDIR, priv->location_tmp);
     if (!ret)
@@ -2076,6 +2201,9 @@ typedef struct
     gchar *last_mirror_failure_message;
     guint64 downloaded;
     guint64 download_size;
+    const gchar *directory;
+    DnfRepoPackageReadyFunc ready_func;
+    gpointer ready_data;
 } GlobalDownloadData;
 
 typedef struct
@@ -2083,6 +2211,7 @@ typedef struct
     DnfPackage *pkg;
     DnfState *state;
     guint64 downloaded;
+    gboolean is_delta;
     GlobalDownloadData *global_download_data;
 } PackageDownloadData;
 
@@ -2109,10 +2238,14 @@ package_download_update_state_cb(void *user_data,
                            DNF_STATE_ACTION_DOWNLOAD_PACKAGES,
                            dnf_package_get_package_id(data->pkg));
 
+    /* a download restarted from another mirror starts from zero again,
+     * only count what goes beyond the previous maximum */
     previously_downloaded = data->downloaded;
+    if (now_downloaded <= previously_downloaded)
+        return 0;
     data->downloaded = now_downloaded;
 
-    global_data->downloaded += (now_downloaded - previously_downloaded);
+    global_data->downloaded += (data->downloaded - previously_downloaded);
 
     /* set percentage */
     percentage = 100.0f * global_data->downloaded / global_data->download_size;
@@ -2132,6 +2265,16 @@ package_download_end_cb(void *user_data,
                         const char *msg)
 {
     auto data = static_cast<PackageDownloadData *>(user_data);
+    GlobalDownloadData *global_data = data->global_download_data;
+
+    /* let the caller process the package while the rest is still downloading,
+     * a delta rpm is reported only when the package is rebuilt from it */
+    if (global_data->ready_func != NULL && !data->is_delta &&
+        (status == LR_TRANSFER_SUCCESSFUL || status == LR_TRANSFER_ALREADYEXISTS)) {
+        g_autofree gchar *basename = g_path_get_basename(dnf_package_get_location(data->pkg));
+        g_autofree gchar *filename = g_build_filename(global_data->directory, basename, NULL);
+        global_data->ready_func(data->pkg, filename, global_data->ready_data);
+    }
 
     g_slice_free(PackageDownloadData, data);
 
@@ -2155,6 +2298,303 @@ out:
     return LR_CB_OK;
 }
 
+/* the delta rpms are rebuilt by the tool from the deltarpm package */
+#define DNF_REPO_APPLYDELTARPM          "/usr/bin/applydeltarpm"
+
+/* maximal number of delta rpms rebuilt at once, applydeltarpm is CPU bound */
+#define DNF_REPO_DELTARPM_JOBS_MAX      4
+
+/* a package downloaded as a delta rpm and rebuilt using the installed files */
+typedef struct {
+    DnfPackage      *pkg;
+    const gchar     *arch;
+    gchar           *delta_filename;
+    gchar           *filename;
+    gchar           *checksum;
+    LrChecksumType   checksum_type;
+    LrPackageTarget *target;        /* only valid during the first round */
+    gboolean         downloaded;
+    gboolean         rebuilt;
+} DnfRepoDeltaItem;
+
+/* shared by the workers, each worker takes the next item to rebuild */
+typedef struct {
+    DnfRepoDeltaItem *items;
+    gint n_items;
+    gint next;          /* atomic */
+    gint *finished;     /* indexes in the order of completion, protected by mutex */
+    gint n_finished;    /* protected by mutex */
+    GMutex mutex;
+    GCond cond;
+} DnfRepoDeltaJob;
+
+/* delta rpms are only usable with the installed files of the running system */
+static gboolean
+dnf_repo_use_deltas(DnfRepo *repo)
+{
+    DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    auto & mainConf = libdnf::getGlobalMainConfig();
+
+    if (!mainConf.deltarpm().getValue() || mainConf.deltarpm_percentage().getValue() == 0)
+        return FALSE;
+    if (dnf_repo_is_local(repo) || priv->context == NULL)
+        return FALSE;
+    if (g_strcmp0(dnf_context_get_install_root(priv->context), "/") != 0)
+        return FALSE;
+    return g_file_test(DNF_REPO_APPLYDELTARPM, G_FILE_TEST_IS_EXECUTABLE);
+}
+
+/* returns the smallest delta from an installed version that is worth downloading, or %NULL */
+static DnfPackageDelta *
+dnf_repo_get_package_delta(DnfPackage *pkg)
+{
+    auto & mainConf = libdnf::getGlobalMainConfig();
+    guint64 max_size = dnf_package_get_downloadsize(pkg) * mainConf.deltarpm_percentage().getValue() / 100;
+    DnfPackageDelta *best = NULL;
+
+    libdnf::Query query(dnf_package_get_sack(pkg), libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES);
+    query.addFilter(HY_PKG_NAME, HY_EQ, dnf_package_get_name(pkg));
+    query.addFilter(HY_PKG_ARCH, HY_EQ, dnf_package_get_arch(pkg));
+    query.addFilter(HY_PKG_REPONAME, HY_EQ, HY_SYSTEM_REPO_NAME);
+    g_autoptr(GPtrArray) installed = query.run();
+    for (guint i = 0; i < installed->len; i++) {
+        auto installed_pkg = static_cast<DnfPackage *>(g_ptr_array_index(installed, i));
+        auto delta = dnf_package_get_delta_from_evr(pkg, dnf_package_get_evr(installed_pkg));
+        if (delta == NULL)
+            continue;
+        if (dnf_packagedelta_get_chksum(delta, NULL) == NULL ||
+            dnf_packagedelta_get_downloadsize(delta) > max_size ||
+            (best != NULL &&
+             dnf_packagedelta_get_downloadsize(delta) >= dnf_packagedelta_get_downloadsize(best))) {
+            g_object_unref(delta);
+            continue;
+        }
+        if (best != NULL)
+            g_object_unref(best);
+        best = delta;
+    }
+    return best;
+}
+
+/* rebuilds the package and verifies its checksum, the delta rpm is removed */
+static void
+dnf_repo_delta_rebuild(DnfRepoDeltaItem *item)
+{
+    g_autoptr(GError) error_local = NULL;
+    gboolean matches = FALSE;
+    gint exit_status = 0;
+    gint fd;
+    const gchar *argv[] = { DNF_REPO_APPLYDELTARPM,
+                            "-a", item->arch,
+                            item->delta_filename,
+                            item->filename,
+                            NULL };
+
+    item->rebuilt = FALSE;
+    if (!item->downloaded)
+        goto out;
+    if (!g_spawn_sync(NULL, (gchar **) argv, NULL,
+                      static_cast<GSpawnFlags>(G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL),
+                      NULL, NULL, NULL, NULL, &exit_status, &error_local) ||
+        !g_spawn_check_exit_status(exit_status, &error_local)) {
+        g_debug("failed to rebuild %s from %s: %s",
+                item->filename, item->delta_filename, error_local->message);
+        goto out;
+    }
+
+    fd = g_open(item->filename, O_RDONLY, 0);
+    if (fd < 0) {
+        g_debug("failed to open rebuilt %s", item->filename);
+        goto out;
+    }
+    if (!lr_checksum_fd_cmp(item->checksum_type, fd, item->checksum, FALSE, &matches, &error_local))
+        g_debug("failed to checksum rebuilt %s: %s", item->filename, error_local->message);
+    else if (!matches)
+        g_debug("rebuilt %s does not match the checksum", item->filename);
+    close(fd);
+    item->rebuilt = matches;
+out:
+    g_unlink(item->delta_filename);
+    if (!item->rebuilt)
+        g_unlink(item->filename);
+}
+
+static gpointer
+dnf_repo_delta_rebuild_worker(gpointer user_data)
+{
+    auto job = static_cast<DnfRepoDeltaJob *>(user_data);
+    while (true) {
+        gint i = g_atomic_int_add(&job->next, 1);
+        if (i >= job->n_items)
+            break;
+        dnf_repo_delta_rebuild(&job->items[i]);
+
+        g_mutex_lock(&job->mutex);
+        job->finished[job->n_finished++] = i;
+        g_cond_signal(&job->cond);
+        g_mutex_unlock(&job->mutex);
+    }
+    return NULL;
+}
+
+/* rebuilds the packages from the downloaded delta rpms concurrently, each rebuilt
+ * package is reported from this thread as soon as it is verified */
+static void
+dnf_repo_delta_rebuild_all(std::vector<DnfRepoDeltaItem> & items,
+                           DnfState *state,
+                           GlobalDownloadData *global_data)
+{
+    DnfRepoDeltaJob job;
+    gint reported = 0;
+    guint n_workers;
+
+    std::vector<gint> finished(items.size());
+    job.items = items.data();
+    job.n_items = items.size();
+    job.next = 0;
+    job.finished = finished.data();
+    job.n_finished = 0;
+    g_mutex_init(&job.mutex);
+    g_cond_init(&job.cond);
+
+    n_workers = MIN(MIN(g_get_num_processors(), DNF_REPO_DELTARPM_JOBS_MAX), items.size());
+    std::vector<GThread *> workers;
+    for (guint i = 0; i < n_workers; i++)
+        workers.push_back(g_thread_new("applydeltarpm", dnf_repo_delta_rebuild_worker, &job));
+
+    /* DnfState and the ready callback are not thread-safe */
+    g_mutex_lock(&job.mutex);
+    while (reported < job.n_items) {
+        while (job.n_finished == reported)
+            g_cond_wait(&job.cond, &job.mutex);
+        gint n_finished = job.n_finished;
+        g_mutex_unlock(&job.mutex);
+        for (; reported < n_finished; reported++) {
+            auto & item = items[finished[reported]];
+            if (!item.rebuilt)
+                continue;
+            /* the full size of the package was reserved for the rebuild */
+            global_data->downloaded += dnf_package_get_downloadsize(item.pkg);
+            dnf_state_set_percentage(state, 100.0f * global_data->downloaded / global_data->download_size);
+            if (global_data->ready_func != NULL)
+                global_data->ready_func(item.pkg, item.filename, global_data->ready_data);
+        }
+        g_mutex_lock(&job.mutex);
+    }
+    g_mutex_unlock(&job.mutex);
+
+    for (auto worker : workers)
+        g_thread_join(worker);
+    g_mutex_clear(&job.mutex);
+    g_cond_clear(&job.cond);
+}
+
+/* the order in which dnf_repo_download_packages_full() queues @packages: the largest
+ * first so the long downloads overlap with the short ones, equal sizes keep their order */
+std::vector<DnfPackage *>
+dnf_repo_get_download_queue(GPtrArray *packages)
+{
+    std::vector<DnfPackage *> queue(reinterpret_cast<DnfPackage **>(packages->pdata),
+                                    reinterpret_cast<DnfPackage **>(packages->pdata) + packages->len);
+    std::stable_sort(queue.begin(), queue.end(),
+                     [](DnfPackage *first, DnfPackage *second) {
+                         return dnf_package_get_downloadsize(first) > dnf_package_get_downloadsize(second);
+                     });
+    return queue;
+}
+
+/* creates a librepo target for the package, or for its delta rpm if @delta is set */
+static LrPackageTarget *
+dnf_repo_package_target_new(DnfRepo *repo,
+                            DnfPackage *pkg,
+                            DnfPackageDelta *delta,
+                            DnfState *state,
+                            GlobalDownloadData *global_data,
+                            GError **error)
+{
+    DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    PackageDownloadData *data;
+    LrPackageTarget *target;
+    const unsigned char *checksum;
+    int checksum_type;
+    g_autofree char *checksum_str = NULL;
+    const gchar *location;
+
+    if (delta != NULL) {
+        location = dnf_packagedelta_get_location(delta);
+        checksum = dnf_packagedelta_get_chksum(delta, &checksum_type);
+    } else {
+        location = dnf_package_get_location(pkg);
+        checksum = dnf_package_get_chksum(pkg, &checksum_type);
+    }
+
+    g_debug("downloading %s to %s", location, global_data->directory);
+
+    data = g_slice_new0(PackageDownloadData);
+    data->pkg = pkg;
+    data->state = state;
+    data->is_delta = delta != NULL;
+    data->global_download_data = global_data;
+
+    checksum_str = hy_chksum_str(checksum, checksum_type);
+
+    std::string encodedUrl = location;
+    if (encodedUrl.find("://") == std::string::npos) {
+        encodedUrl = libdnf::urlEncode(encodedUrl, "/");
+    }
+
+    target = lr_packagetarget_new_v2(priv->repo_handle,
+                                     encodedUrl.c_str(),
+                                     global_data->directory,
+                                     dnf_repo_checksum_hy_to_lr(checksum_type),
+                                     checksum_str,
+                                     delta != NULL ? dnf_packagedelta_get_downloadsize(delta)
+                                                   : dnf_package_get_downloadsize(pkg),
+                                     delta != NULL ? dnf_packagedelta_get_baseurl(delta)
+                                                   : dnf_package_get_baseurl(pkg),
+                                     TRUE,
+                                     package_download_update_state_cb,
+                                     data,
+                                     package_download_end_cb,
+                                     mirrorlist_failure_cb,
+                                     error);
+    if (target == NULL)
+        g_slice_free(PackageDownloadData, data);
+    return target;
+}
+
+/* downloads the targets, an already downloaded target is not an error; without
+ * LR_PACKAGEDOWNLOAD_FAILFAST the caller has to check the err of each target */
+static gboolean
+dnf_repo_download_targets(GSList *package_targets,
+                          LrPackageDownloadFlag flags,
+                          GlobalDownloadData *global_data,
+                          GError **error)
+{
+    g_autoptr(GError) error_local = NULL;
+
+    if (lr_download_packages(package_targets, flags, &error_local))
+        return TRUE;
+    if (g_error_matches(error_local,
+                        LR_PACKAGE_DOWNLOADER_ERROR,
+                        LRE_ALREADYDOWNLOADED))
+        return TRUE;
+    if (!(flags & LR_PACKAGEDOWNLOAD_FAILFAST)) {
+        /* the failed targets are reported by the caller */
+        for (GSList *l = package_targets; l != NULL; l = l->next) {
+            if (static_cast<LrPackageTarget *>(l->data)->err != NULL)
+                return TRUE;
+        }
+    }
+    if (global_data->last_mirror_failure_message) {
+        g_autofree gchar *orig_message = error_local->message;
+        error_local->message = g_strconcat(orig_message, "; Last error: ", global_data->last_mirror_failure_message, NULL);
+    }
+    g_propagate_error(error, error_local);
+    error_local = NULL;
+    return FALSE;
+}
+
 LrHandle *
 dnf_repo_get_lr_handle(DnfRepo *repo)
 {
@@ -2223,15 +2663,55 @@ dnf_repo_download_packages(DnfRepo *repo,
                            GPtrArray *packages,
                            const gchar *directory,
                            DnfState *state,
-                           GError **error) try
+                           GError **error)
+{
+    return dnf_repo_download_packages_full(repo, packages, directory, NULL, NULL, state, error);
+}
+
+/**
+ * dnf_repo_download_packages_full:
+ * @repo: a #DnfRepo instance.
+ * @packages: (element-type DnfPackage): an array of packages, must be from this repo
+ * @directory: the destination directory.
+ * @ready_func: (scope call) (nullable): a function called for every downloaded package, or %NULL.
+ * @ready_data: user data for @ready_func.
+ * @state: a #DnfState.
+ * @error: a #GError or %NULL.
+ *
+ * Downloads multiple packages from a repo like dnf_repo_download_packages().
+ * The largest packages are downloaded first and partially downloaded files
+ * are resumed. @ready_func is called from the calling thread as soon as
+ * a package is downloaded, or found already downloaded, so the caller can
+ * start processing it before the whole batch is finished.
+ *
+ * When deltarpm is enabled, the presto metadata of the repo is loaded and
+ * a delta rpm is downloaded instead of a package if it is at most
+ * deltarpm_percentage of the package size. The packages are rebuilt from
+ * the delta rpms concurrently using applydeltarpm and their checksums are
+ * verified. @ready_func is called for a rebuilt package as soon as it is
+ * verified. A package whose delta rpm fails to download or to rebuild is
+ * downloaded in full.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.55.0
+ **/
+gboolean
+dnf_repo_download_packages_full(DnfRepo *repo,
+                                GPtrArray *packages,
+                                const gchar *directory,
+                                DnfRepoPackageReadyFunc ready_func,
+                                gpointer ready_data,
+                                DnfState *state,
+                                GError **error) try
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
     gboolean ret = FALSE;
-    guint i;
+    gboolean use_deltas;
     GSList *package_targets = NULL;
     GlobalDownloadData global_data = { 0, };
-    g_autoptr(GError) error_local = NULL;
     g_autofree gchar *directory_slash = NULL;
+    std::vector<DnfRepoDeltaItem> deltas;
 
     /* ensure we reset the values from the keyfile */
     if (!dnf_repo_set_keyfile_data(repo, error))
@@ -2258,67 +2738,116 @@ dnf_repo_download_packages(DnfRepo *repo,
     }
 
     global_data.download_size = dnf_package_array_get_download_size(packages);
-    for (i = 0; i < packages->len; i++) {
-        auto pkg = static_cast<DnfPackage *>(packages->pdata[i]);
-        PackageDownloadData *data;
+    global_data.directory = directory_slash;
+    global_data.ready_func = ready_func;
+    global_data.ready_data = ready_data;
+
+    /* the deltas are loaded only here, they are of no use to anything else */
+    use_deltas = dnf_repo_use_deltas(repo) && packages->len > 0;
+    if (use_deltas) {
+        g_autoptr(GError) error_local = NULL;
+        auto sack = dnf_package_get_sack(static_cast<DnfPackage *>(g_ptr_array_index(packages, 0)));
+        if (!dnf_sack_load_repo_presto(sack, priv->repo, &error_local)) {
+            g_debug("not using delta rpms for %s: %s", dnf_repo_get_id(repo), error_local->message);
+            use_deltas = FALSE;
+        }
+    }
+    for (auto pkg : dnf_repo_get_download_queue(packages)) {
+        g_autoptr(DnfPackageDelta) delta = NULL;
+        g_autofree gchar *basename = NULL;
         LrPackageTarget *target;
-        const unsigned char *checksum;
-        int checksum_type;
-        g_autofree char *checksum_str = NULL;
-
-        g_debug("downloading %s to %s",
-                dnf_package_get_location(pkg),
-                directory_slash);
-
-        data = g_slice_new0(PackageDownloadData);
-        data->pkg = pkg;
-        data->state = state;
-        data->global_download_data = &global_data;
 
-        checksum = dnf_package_get_chksum(pkg, &checksum_type);
-        checksum_str = hy_chksum_str(checksum, checksum_type);
-
-        std::string encodedUrl = dnf_package_get_location(pkg);
-        if (encodedUrl.find("://") == std::string::npos) {
-            encodedUrl = libdnf::urlEncode(encodedUrl, "/");
+        /* a package already in place is not downloaded again */
+        basename = g_path_get_basename(dnf_package_get_location(pkg));
+        if (use_deltas) {
+            g_autofree gchar *filename = g_build_filename(directory_slash, basename, NULL);
+            if (!g_file_test(filename, G_FILE_TEST_EXISTS))
+                delta = dnf_repo_get_package_delta(pkg);
+        }
+        if (delta != NULL) {
+            g_autofree gchar *delta_basename = g_path_get_basename(dnf_packagedelta_get_location(delta));
+            const unsigned char *checksum;
+            int checksum_type;
+
+            DnfRepoDeltaItem item;
+            item.pkg = pkg;
+            item.arch = dnf_package_get_arch(pkg);
+            item.delta_filename = g_build_filename(directory_slash, delta_basename, NULL);
+            item.filename = g_build_filename(directory_slash, basename, NULL);
+            checksum = dnf_package_get_chksum(pkg, &checksum_type);
+            item.checksum = hy_chksum_str(checksum, checksum_type);
+            item.checksum_type = dnf_repo_checksum_hy_to_lr(checksum_type);
+            item.target = NULL;
+            item.downloaded = FALSE;
+            item.rebuilt = FALSE;
+            deltas.push_back(item);
+
+            /* the full size stays reserved for the rebuild or the fallback download,
+             * so the progress does not go back when a rebuild fails */
+            global_data.download_size += dnf_packagedelta_get_downloadsize(delta);
         }
 
-        target = lr_packagetarget_new_v2(priv->repo_handle,
-                                         encodedUrl.c_str(),
-                                         directory_slash,
-                                         dnf_repo_checksum_hy_to_lr(checksum_type),
-                                         checksum_str,
-                                         dnf_package_get_downloadsize(pkg),
-                                         dnf_package_get_baseurl(pkg),
-                                         TRUE,
-                                         package_download_update_state_cb,
-                                         data,
-                                         package_download_end_cb,
-                                         mirrorlist_failure_cb,
-                                         error);
+        target = dnf_repo_package_target_new(repo, pkg, delta, state, &global_data, error);
         if (target == NULL)
             goto out;
-
+        if (delta != NULL)
+            deltas.back().target = target;
         package_targets = g_slist_prepend(package_targets, target);
     }
+    package_targets = g_slist_reverse(package_targets);
 
-    ret = lr_download_packages(package_targets, LR_PACKAGEDOWNLOAD_FAILFAST, &error_local);
-    if (!ret) {
-        if (g_error_matches(error_local,
-                            LR_PACKAGE_DOWNLOADER_ERROR,
-                            LRE_ALREADYDOWNLOADED)) {
-            /* ignore */
-            g_clear_error(&error_local);
-        } else {
-            if (global_data.last_mirror_failure_message) {
-                g_autofree gchar *orig_message = error_local->message;
-                error_local->message = g_strconcat(orig_message, "; Last error: ", global_data.last_mirror_failure_message, NULL);
-            }
-            g_propagate_error(error, error_local);
-            error_local = NULL;
+    /* a failed delta rpm must not abort the other downloads, the package
+     * is downloaded in full instead */
+    if (!dnf_repo_download_targets(package_targets,
+                                   deltas.empty() ? LR_PACKAGEDOWNLOAD_FAILFAST
+                                                  : static_cast<LrPackageDownloadFlag>(0),
+                                   &global_data, error))
+        goto out;
+    for (GSList *l = package_targets; l != NULL && !deltas.empty(); l = l->next) {
+        auto target = static_cast<LrPackageTarget *>(l->data);
+        if (target->err == NULL ||
+            std::any_of(deltas.begin(), deltas.end(),
+                        [target](const DnfRepoDeltaItem & item) { return item.target == target; }))
+            continue;
+        g_set_error(error,
+                    DNF_ERROR,
+                    DNF_ERROR_CANNOT_FETCH_SOURCE,
+                    "Failed to download %s: %s",
+                    target->relative_url, target->err);
+        goto out;
+    }
+    for (auto & item : deltas) {
+        item.downloaded = item.target->err == NULL;
+        if (!item.downloaded)
+            g_debug("failed to download the delta rpm of %s: %s",
+                    dnf_package_get_nevra(item.pkg), item.target->err);
+        item.target = NULL;
+    }
+    g_slist_free_full(package_targets, (GDestroyNotify)lr_packagetarget_free);
+    package_targets = NULL;
+
+    if (deltas.empty()) {
+        ret = TRUE;
+        goto out;
+    }
+
+    /* rebuild the packages and download in full the ones that failed */
+    dnf_repo_delta_rebuild_all(deltas, state, &global_data);
+    for (auto & item : deltas) {
+        LrPackageTarget *target;
+
+        if (item.rebuilt)
+            continue;
+        g_debug("falling back to the full download of %s", dnf_package_get_nevra(item.pkg));
+        target = dnf_repo_package_target_new(repo, item.pkg, NULL, state, &global_data, error);
+        if (target == NULL)
             goto out;
-        }
+        package_targets = g_slist_prepend(package_targets, target);
     }
+    package_targets = g_slist_reverse(package_targets);
+    if (package_targets != NULL &&
+        !dnf_repo_download_targets(package_targets, LR_PACKAGEDOWNLOAD_FAILFAST, &global_data, error))
+        goto out;
 
     ret = TRUE;
 out:
@@ -2327,6 +2856,11 @@ out:
     g_free(global_data.last_mirror_failure_message);
     g_free(global_data.last_mirror_url);
     g_slist_free_full(package_targets, (GDestroyNotify)lr_packagetarget_free);
+    for (auto & item : deltas) {
+        g_free(item.delta_filename);
+        g_free(item.filename);
+        g_free(item.checksum);
+    }
     return ret;
 } CATCH_TO_GERROR(FALSE)
 
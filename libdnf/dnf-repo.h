@@ -101,6 +101,20 @@ typedef enum {
         DNF_REPO_ENABLED_LAST
 } DnfRepoEnabled;
 
+/**
+ * DnfRepoPackageReadyFunc:
+ * @pkg: the downloaded #DnfPackage.
+ * @filename: the path of the downloaded file.
+ * @user_data: user data passed to dnf_repo_download_packages_full().
+ *
+ * Called for every package as soon as it is downloaded.
+ *
+ * Since: 0.55.0
+ **/
+typedef void (*DnfRepoPackageReadyFunc)                 (DnfPackage           *pkg,
+                                                         const gchar          *filename,
+                                                         gpointer              user_data);
+
 DnfRepo         *dnf_repo_new                   (DnfContext           *context);
 
 /* getters */
@@ -201,6 +215,13 @@ gboolean         dnf_repo_download_packages     (DnfRepo              *repo,
                                                  const gchar          *directory,
                                                  DnfState             *state,
                                                  GError              **error);
+gboolean         dnf_repo_download_packages_full(DnfRepo              *repo,
+                                                 GPtrArray            *pkgs,
+                                                 const gchar          *directory,
+                                                 DnfRepoPackageReadyFunc ready_func,
+                                                 gpointer              ready_data,
+                                                 DnfState             *state,
+                                                 GError              **error);
 
 HyRepo dnf_repo_get_hy_repo(DnfRepo *repo);
 #endif
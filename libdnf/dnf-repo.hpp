@@ -23,6 +23,8 @@
 
 #include "dnf-repo.h"
 
+#include <vector>
+
 inline DnfRepoEnabled operator|(DnfRepoEnabled a, DnfRepoEnabled b)
 {
     return static_cast<DnfRepoEnabled>(static_cast<int>(a) | static_cast<int>(b));
@@ -33,5 +35,7 @@ inline DnfRepoEnabled & operator|=(DnfRepoEnabled & a, DnfRepoEnabled b)
     return a = a | b;
 }
 
+std::vector<DnfPackage *> dnf_repo_get_download_queue(GPtrArray *packages);
+
 
 #endif /* __DNF_REPO_HPP */
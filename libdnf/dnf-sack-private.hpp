@@ -63,6 +63,69 @@ libdnf::ModulePackageContainer * dnf_sack_set_module_container(
     DnfSack *sack, libdnf::ModulePackageContainer * newConteiner);
 libdnf::ModulePackageContainer * dnf_sack_get_module_container(DnfSack *sack);
 void         dnf_sack_make_provides_ready   (DnfSack    *sack);
+
+/**
+ * @brief Load filelists deferred by DNF_SACK_LOAD_FLAG_LAZY_FILELISTS, of all repos if repo is
+ * nullptr. Only filelists with a cache valid when the repo was loaded are deferred, a failure here
+ * means the cache and the metadata both went away meanwhile. It is logged, files of the repo are
+ * missing then.
+ */
+void         dnf_sack_load_lazy_filelists   (DnfSack    *sack, Repo *repo);
+
+/**
+ * @brief Load the deferred filelists of all repos unless primary contains all files matching
+ * the filename with the comparison type (HY_EQ, HY_GLOB, ...).
+ */
+void         dnf_sack_load_lazy_filelists_for(DnfSack *sack, const char *filename, int cmp_type);
+
+/**
+ * @brief Load the presto deltas of the repo unless they are loaded already. Used by the package
+ * download, which is the only consumer of the deltas. A repo without the prestodelta metadata
+ * is not an error.
+ */
+gboolean     dnf_sack_load_repo_presto      (DnfSack *sack, HyRepo repo, GError **error);
+
+/**
+ * @brief Load descriptive attributes (summary, description, url, ...) left out of the main solv
+ * file by DNF_SACK_LOAD_FLAG_COMPACT, of all repos if repo is nullptr. Failures are logged.
+ */
+void         dnf_sack_load_lazy_descriptions(DnfSack *sack, Repo *repo);
+
+/**
+ * @brief Append solvables that have a dependency of the keyname type (SOLVABLE_REQUIRES, ...)
+ * with a name of the dep. The solvables are looked up in a reverse index built on the first use,
+ * they are only candidates to be checked with pool_match_dep() or whatprovides.
+ */
+void         dnf_sack_get_dependency_candidates(DnfSack *sack, Id keyname, Id dep,
+                                                std::vector<Id> & candidates);
+
+/**
+ * @brief Return distinct names of provides of all solvables sorted by the string.
+ * The table is built after whatprovides is created and reused until it is created again.
+ */
+const std::vector<Id> & dnf_sack_get_provide_names(DnfSack *sack);
+
+/**
+ * @brief Return all solvables sorted by the name Id, the latest evr first and the Id. With byArch
+ * they are sorted by the name Id, the arch Id, the latest evr first and the Id. Packages of a query
+ * taken in this order are sorted the same way, no sorting is needed per query. The order is built
+ * on the first use and reused until solvables are added to the pool.
+ */
+const std::vector<Id> & dnf_sack_get_name_ordered_solvables(DnfSack *sack, bool byArch);
+
+/**
+ * @brief Return ranks of evrs of all solvables indexed by the evr Id. Ranks compare like
+ * pool_evrcmp() of the evrs, equal evrs have the same rank, Ids that are not an evr of any
+ * solvable have rank 0. The table is extended when solvables are added to the pool.
+ */
+const std::vector<int> & dnf_sack_get_evr_ranks(DnfSack *sack);
+
+/**
+ * @brief Return the lowest rank of solvable evrs that are not older than the evr, the evr does not
+ * need to belong to any solvable. Evrs with a lower rank are older, evrs with the same rank are
+ * equal to the evr if exact is set, newer otherwise. Evrs with a higher rank are newer.
+ */
+int          dnf_sack_get_evr_rank_bound(DnfSack *sack, Id evr, bool *exact);
 Id           dnf_sack_running_kernel        (DnfSack    *sack);
 void         dnf_sack_recompute_considered_map  (DnfSack * sack, Map ** considered, libdnf::Query::ExcludeFlags flags);
 void         dnf_sack_recompute_considered  (DnfSack    *sack);
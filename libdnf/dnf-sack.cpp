@@ -33,15 +33,23 @@
 
 
 #include <algorithm>
+#include <array>
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <functional>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <map>
+#include <memory>
 #include <set>
+#include <string>
 
 extern "C" {
+#include <solv/chksum.h>
 #include <solv/evr.h>
 #include <solv/pool.h>
 #include <solv/poolarch.h>
@@ -55,6 +63,7 @@ extern "C" {
 #include <solv/repo_write.h>
 #include <solv/solv_xfopen.h>
 #include <solv/solver.h>
+#include <solv/util.h>
 }
 
 #include <cstring>
@@ -90,6 +99,82 @@ extern "C" {
 #define DEFAULT_CACHE_ROOT "/var/cache/hawkey"
 #define DEFAULT_CACHE_USER "/var/tmp/hawkey"
 
+/* Module artifact split into Ids of the sack pool */
+struct ModuleArtifactId {
+    Id module;  /* solvable of the module in the module sack */
+    Id name;
+    Id evr;     /* 0 when not known to the pool */
+    Id arch;    /* 0 when not known to the pool */
+};
+
+/* Index of all module artifacts, rebuilt only when modules or repos are loaded */
+struct ModuleArtifactIndex {
+    guint moduleGeneration{0};
+    size_t nmodules{0};
+    std::vector<ModuleArtifactId> artifacts;
+};
+
+/* Reverse index of one dependency type, pairs of <dependency name, solvable> sorted by the name */
+typedef std::vector<std::pair<Id, Id>> DependencyNameIndex;
+
+/* Reverse indexes of requires, recommends, ..., built on the first use of each type,
+ * rebuilt only when solvables are added to the pool or @System is loaded again */
+struct DependencyIndex {
+    int nsolvables{0};
+    guint systemRepoGeneration{0};
+    std::map<Id, DependencyNameIndex> byKeyname;
+};
+
+/* All solvables sorted by name (and arch) with the latest evr first, each order is built on
+ * the first use, rebuilt only when solvables are added to the pool or @System is loaded again */
+struct SolvableOrderIndex {
+    int nsolvables{0};
+    guint systemRepoGeneration{0};
+    std::vector<Id> byName;
+    std::vector<Id> byNameArch;
+};
+
+/* Dense ranks of evrs of all solvables, evrs equal by pool_evrcmp() share the rank. Evrs of
+ * solvables added to the pool later are merged in, the ranks are reassigned. */
+struct EvrRankIndex {
+    int nsolvables{0};
+    guint systemRepoGeneration{0};
+    std::vector<Id> evrs;   /* distinct evr Ids sorted by pool_evrcmp() */
+    std::vector<int> ranks; /* indexed by the evr Id, 0 for unknown Ids */
+};
+
+/* Distinct names of all provides sorted by the string, rebuilt with whatprovides */
+struct ProvideNameIndex {
+    guint providesGeneration{0};
+    std::vector<Id> names;
+};
+
+#define DNF_SACK_CACHE_WRITE_THREADS_MAX  4
+
+/* A solv file written to a temporary file, renamed to the cache file by a worker thread */
+struct CacheWrite {
+    std::string tmpFn;
+    std::string fn;
+    mode_t mode;
+    HyRepo hrepo{nullptr};          /* referenced, its owner may free it before the wait */
+    enum _hy_repo_state *state;     /* of hrepo, set to _HY_WRITTEN once the file is published */
+    GError *error{nullptr};
+
+    ~CacheWrite()
+    {
+        g_clear_error(&error);
+        if (hrepo)
+            hy_repo_free(hrepo);
+    }
+};
+
+/* Cache files of repos loaded with DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC being published,
+ * the jobs are kept in the order of writing */
+struct CacheWriter {
+    GThreadPool *pool{nullptr};
+    std::vector<std::unique_ptr<CacheWrite>> jobs;
+};
+
 typedef struct
 {
     Id                   running_kernel_id;
@@ -98,6 +183,21 @@ typedef struct
     Map                 *repo_excludes;
     Map                 *module_excludes;
     Map                 *module_includes;   /* To fast identify enabled modular packages */
+    gboolean             module_excludes_valid; /* module_excludes match the key below */
+    libdnf::ModulePackageContainer * module_excludes_container;
+    guint                module_excludes_module_generation;
+    unsigned int         module_excludes_activation;
+    gchar               *module_excludes_hotfixes;
+    ModuleArtifactIndex *module_artifacts;
+    DependencyIndex     *dependency_index;
+    ProvideNameIndex    *provide_names;
+    SolvableOrderIndex  *solvable_order;
+    EvrRankIndex        *evr_ranks;
+    CacheWriter         *cache_writer;
+    GError              *cache_write_error; /* found by a wait that could not report it */
+    gboolean             have_pending_filelists; /* a repo defers loading of filelists */
+    gboolean             have_pending_descriptions; /* a repo defers loading of descriptions */
+    guint                provides_generation; /* incremented when whatprovides is created */
     Map                 *pkg_solvables;     /* Map representing only solvable pkgs of query */
     int                  pool_nsolvables;   /* Number of nsolvables for creation of pkg_solvables*/
     Pool                *pool;
@@ -112,6 +212,10 @@ typedef struct
     dnf_sack_running_kernel_fn_t  running_kernel_fn;
     guint                installonly_limit;
     libdnf::ModulePackageContainer * moduleContainer;
+    guint                module_generation; /* incremented when modules or repos are loaded */
+    guint                system_repo_generation; /* incremented when @System is loaded */
+    guint                rpmdb_version_generation;
+    gchar               *rpmdb_version;     /* cached for rpmdb_version_generation */
 } DnfSackPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(DnfSack, dnf_sack, G_TYPE_OBJECT)
@@ -129,7 +233,11 @@ dnf_sack_finalize(GObject *object)
     Pool *pool = priv->pool;
     Repo *repo;
     int i;
+    g_autoptr(GError) error = NULL;
 
+    /* the pending jobs update states of the repos */
+    if (!dnf_sack_wait_cache_writes(sack, &error))
+        g_warning("%s", error->message);
     FOR_REPOS(i, repo) {
         auto hrepo = static_cast<HyRepo>(repo->appdata);
         if (!hrepo)
@@ -138,6 +246,13 @@ dnf_sack_finalize(GObject *object)
     }
     g_free(priv->cache_dir);
     g_free(priv->arch);
+    g_free(priv->module_excludes_hotfixes);
+    g_free(priv->rpmdb_version);
+    delete priv->module_artifacts;
+    delete priv->dependency_index;
+    delete priv->provide_names;
+    delete priv->solvable_order;
+    delete priv->evr_ranks;
     queue_free(&priv->installonly);
 
     free_map_fully(priv->pkg_excludes);
@@ -359,6 +474,116 @@ dnf_sack_recompute_considered(DnfSack *sack)
     priv->considered_uptodate = TRUE;
 }
 
+#define METADATA_BUFFER_SIZE  (128 * 1024)
+#define METADATA_PIPE_SIZE    (1024 * 1024)
+
+/* Metadata file opened for parsing. A compressed file is decompressed by a separate thread
+ * into a pipe, the parser reads the other end of the pipe. */
+struct MetadataReader {
+    FILE *fp{nullptr};              /* the stream for the parser */
+    FILE *compressed{nullptr};      /* read by the thread */
+    int fd_out{-1};                 /* the write end of the pipe, owned by the thread */
+    GThread *thread{nullptr};
+    gint cancelled{0};
+    gint failed{0};
+    std::vector<char> buffer;       /* buffer of fp */
+};
+
+static gpointer
+metadata_reader_worker(gpointer data)
+{
+    auto reader = static_cast<MetadataReader *>(data);
+    std::vector<char> chunk(METADATA_BUFFER_SIZE);
+    size_t nread;
+
+    while (!g_atomic_int_get(&reader->cancelled) &&
+           (nread = fread(chunk.data(), 1, chunk.size(), reader->compressed)) > 0) {
+        for (size_t offset = 0; offset < nread;) {
+            ssize_t nwritten = write(reader->fd_out, chunk.data() + offset, nread - offset);
+            if (nwritten < 0) {
+                if (errno == EINTR)
+                    continue;
+                g_atomic_int_set(&reader->failed, 1);
+                goto out;
+            }
+            offset += nwritten;
+        }
+    }
+    if (ferror(reader->compressed))
+        g_atomic_int_set(&reader->failed, 1);
+ out:
+    close(reader->fd_out);
+    fclose(reader->compressed);
+    return NULL;
+}
+
+/* Opens the metadata file like solv_xfopen(), the returned stream is owned by the reader */
+static FILE *
+metadata_reader_open(MetadataReader *reader, const char *fn)
+{
+    int fds[2];
+
+    reader->buffer.resize(METADATA_BUFFER_SIZE);
+    if (solv_xfopen_iscompressed(fn) == 0) {
+        reader->fp = fopen(fn, "r");
+        if (reader->fp)
+            setvbuf(reader->fp, reader->buffer.data(), _IOFBF, reader->buffer.size());
+        return reader->fp;
+    }
+
+    FILE *compressed = solv_xfopen(fn, "r");
+    if (!compressed)
+        return NULL;
+    if (pipe2(fds, O_CLOEXEC)) {
+        reader->fp = compressed;
+        return reader->fp;
+    }
+#ifdef F_SETPIPE_SZ
+    /* the decompression runs ahead of the parser by at most the pipe size */
+    fcntl(fds[1], F_SETPIPE_SZ, METADATA_PIPE_SIZE);
+#endif
+    reader->fp = fdopen(fds[0], "r");
+    if (!reader->fp) {
+        close(fds[0]);
+        close(fds[1]);
+        reader->fp = compressed;
+        return reader->fp;
+    }
+    setvbuf(reader->fp, reader->buffer.data(), _IOFBF, reader->buffer.size());
+    reader->compressed = compressed;
+    reader->fd_out = fds[1];
+    reader->thread = g_thread_try_new("decompress", metadata_reader_worker, reader, NULL);
+    if (!reader->thread) {
+        /* the data are read from the decompressing stream directly */
+        fclose(reader->fp);
+        close(reader->fd_out);
+        reader->fp = compressed;
+        reader->compressed = NULL;
+        reader->fd_out = -1;
+    }
+    return reader->fp;
+}
+
+/* Returns nonzero when the file could not be decompressed completely */
+static int
+metadata_reader_close(MetadataReader *reader)
+{
+    if (!reader->fp)
+        return 0;
+    if (reader->thread) {
+        /* the parser may stop early, the rest is drained so that the thread is not blocked
+         * by the full pipe and does not write to a closed one */
+        g_atomic_int_set(&reader->cancelled, 1);
+        while (fread(reader->buffer.data(), 1, reader->buffer.size(), reader->fp) > 0)
+            ;
+        g_thread_join(reader->thread);
+        reader->thread = NULL;
+    }
+    fclose(reader->fp);
+    reader->fp = NULL;
+    return g_atomic_int_get(&reader->failed);
+}
+
 static gboolean
 load_ext(DnfSack *sack, HyRepo hrepo, _hy_repo_repodata which_repodata,
          const char *suffix, const char * which_filename,
@@ -414,7 +639,8 @@ load_ext(DnfSack *sack, HyRepo hrepo, _hy_repo_repodata which_repodata,
     if (done)
         return TRUE;
 
-    fp = solv_xfopen(fn.c_str(), "r");
+    MetadataReader reader;
+    fp = metadata_reader_open(&reader, fn.c_str());
     if (fp == NULL) {
         g_set_error (error,
                      DNF_ERROR,
@@ -426,7 +652,8 @@ load_ext(DnfSack *sack, HyRepo hrepo, _hy_repo_repodata which_repodata,
 
     int previous_last = repo->nrepodata - 1;
     ret = cb(repo, fp);
-    fclose(fp);
+    if (metadata_reader_close(&reader) && ret == 0)
+        ret = DNF_ERROR_INTERNAL_ERROR;
     if (ret == 0) {
         repo_update_state(hrepo, which_repodata, _HY_LOADED_FETCH);
         assert(previous_last == repo->nrepodata - 2); (void)previous_last;
@@ -478,14 +705,154 @@ repo_is_one_piece(Repo *repo)
     return 1;
 }
 
+/* Extensions cover only the main solvables. The updateinfo solvables following them are left
+ * out of the repo while an extension is loaded after updateinfo. */
+class MainSolvablesScope {
+public:
+    explicit MainSolvablesScope(HyRepo hrepo)
+    : repo(libdnf::repoGetImpl(hrepo)->libsolvRepo), end(repo->end), nsolvables(repo->nsolvables)
+    {
+        auto repoImpl = libdnf::repoGetImpl(hrepo);
+        repo->end = repoImpl->main_end;
+        repo->nsolvables = repoImpl->main_nsolvables;
+    }
+    ~MainSolvablesScope()
+    {
+        repo->end = end;
+        repo->nsolvables = nsolvables;
+    }
+
+private:
+    Repo *repo;
+    int end;
+    int nsolvables;
+};
+
+/* Attributes left out of the main solv file by DNF_SACK_LOAD_FLAG_COMPACT, none of them
+ * is needed for resolving or downloading */
+static bool
+is_descriptive_key(Id keyname)
+{
+    switch (keyname) {
+    case SOLVABLE_SUMMARY:
+    case SOLVABLE_DESCRIPTION:
+    case SOLVABLE_URL:
+    case SOLVABLE_LICENSE:
+    case SOLVABLE_PACKAGER:
+    case SOLVABLE_GROUP:
+    case SOLVABLE_BUILDHOST:
+    case SOLVABLE_AUTHORS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* drops the descriptive attributes from the main solv file */
+static int
+write_main_resolver_filter(Repo *repo, Repokey *key, void *kfdata)
+{
+    if (is_descriptive_key(key->name))
+        return KEY_STORAGE_DROPPED;
+    return repo_write_stdkeyfilter(repo, key, 0);
+}
+
+/* keeps only the descriptive attributes, they extend the solvables of the main solv file */
+static int
+write_descriptions_filter(Repo *repo, Repokey *key, void *kfdata)
+{
+    if (!is_descriptive_key(key->name))
+        return KEY_STORAGE_DROPPED;
+    return repo_write_stdkeyfilter(repo, key, 0);
+}
+
+static void
+cache_write_worker(gpointer data, gpointer user_data)
+{
+    auto job = static_cast<CacheWrite *>(data);
+    const char *tmp_fn = job->tmpFn.c_str();
+    const char *fn = job->fn.c_str();
+
+    /* the data must be on the disk before the rename, a crash never leaves a truncated cache */
+    int fd = open(tmp_fn, O_RDONLY | O_CLOEXEC);
+    gboolean synced = fd >= 0 && fchmod(fd, job->mode) == 0 && fdatasync(fd) == 0;
+    int errsv = errno;
+    if (fd >= 0)
+        close(fd);
+    if (!synced) {
+        g_set_error(&job->error,
+                    DNF_ERROR,
+                    DNF_ERROR_FILE_INVALID,
+                    _("Failed syncing %1$s: %2$s"),
+                    tmp_fn, g_strerror(errsv));
+        unlink(tmp_fn);
+        return;
+    }
+    if (rename(tmp_fn, fn)) {
+        errsv = errno;
+        g_set_error(&job->error,
+                    DNF_ERROR,
+                    DNF_ERROR_FILE_INVALID,
+                    _("Failed renaming %1$s to %2$s: %3$s"),
+                    tmp_fn, fn, g_strerror(errsv));
+        unlink(tmp_fn);
+        return;
+    }
+    g_autofree gchar *dir = g_path_get_dirname(fn);
+    fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/* Moves the written solv file to the cache and marks it written. With
+ * DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC it is done by a worker thread, the
+ * caller can load the next repo meanwhile. */
+static gboolean
+publish_cache_file(DnfSack *sack, HyRepo hrepo, const char *tmp_fn, const char *fn,
+                   enum _hy_repo_state *state, GError **error)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+
+    if (!(libdnf::repoGetImpl(hrepo)->load_flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC)) {
+        if (!mv(tmp_fn, fn, error))
+            return FALSE;
+        *state = _HY_WRITTEN;
+        return TRUE;
+    }
+
+    if (!priv->cache_writer) {
+        GThreadPool *pool = g_thread_pool_new(cache_write_worker, NULL,
+                                              DNF_SACK_CACHE_WRITE_THREADS_MAX, FALSE, error);
+        if (!pool)
+            return FALSE;
+        priv->cache_writer = new CacheWriter;
+        priv->cache_writer->pool = pool;
+    }
+    /* umask() is not thread-safe, the mode is computed here */
+    auto job = new CacheWrite;
+    job->tmpFn = tmp_fn;
+    job->fn = fn;
+    job->mode = 0666 & ~get_umask();
+    job->hrepo = hy_repo_ref(hrepo);
+    job->state = state;
+    priv->cache_writer->jobs.emplace_back(job);
+    /* the job is queued even when no new thread could be started */
+    g_thread_pool_push(priv->cache_writer->pool, job, NULL);
+    return TRUE;
+}
+
 static gboolean
 write_main(DnfSack *sack, HyRepo hrepo, int switchtosolv, GError **error)
 {
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
     auto repoImpl = libdnf::repoGetImpl(hrepo);
     Repo *repo = repoImpl->libsolvRepo;
     const char *name = repo->name;
     const char *chksum = pool_checksum_str(dnf_sack_get_pool(sack), repoImpl->checksum);
-    char *fn = dnf_sack_give_cache_fn(sack, name, NULL);
+    const bool compact = repoImpl->load_flags & DNF_SACK_LOAD_FLAG_COMPACT;
+    char *fn = dnf_sack_give_cache_fn(sack, name, compact ? HY_EXT_RESOLVER : NULL);
     char *tmp_fn_templ = solv_dupjoin(fn, ".XXXXXX", NULL);
     int tmp_fd  = mkstemp(tmp_fn_templ);
     gboolean ret = TRUE;
@@ -512,7 +879,10 @@ write_main(DnfSack *sack, HyRepo hrepo, int switchtosolv, GError **error)
                         strerror(errno));
             goto done;
         }
-        rc = repo_write(repo, fp);
+        if (compact)
+            rc = repo_write_filtered(repo, fp, write_main_resolver_filter, NULL, 0);
+        else
+            rc = repo_write(repo, fp);
         rc |= checksum_write(repoImpl->checksum, fp);
         rc |= fclose(fp);
         if (rc) {
@@ -541,13 +911,68 @@ write_main(DnfSack *sack, HyRepo hrepo, int switchtosolv, GError **error)
                                        "written solv file"));
                 goto done;
             }
+            /* the descriptions were written by write_descriptions() before */
+            if (compact) {
+                repoImpl->descriptions_pending = true;
+                priv->have_pending_descriptions = TRUE;
+            }
         }
     }
 
-    ret = mv(tmp_fn_templ, fn, error);
-    if (!ret)
+    ret = publish_cache_file(sack, hrepo, tmp_fn_templ, fn, &repoImpl->state_main, error);
+
+ done:
+    if (!ret && tmp_fd >= 0)
+        unlink(tmp_fn_templ);
+    g_free(tmp_fn_templ);
+    g_free(fn);
+    return ret;
+}
+
+static gboolean
+write_descriptions(DnfSack *sack, HyRepo hrepo, GError **error)
+{
+    auto repoImpl = libdnf::repoGetImpl(hrepo);
+    Repo *repo = repoImpl->libsolvRepo;
+    char *fn = dnf_sack_give_cache_fn(sack, repo->name, HY_EXT_DESCRIPTIONS);
+    char *tmp_fn_templ = solv_dupjoin(fn, ".XXXXXX", NULL);
+    int tmp_fd = mkstemp(tmp_fn_templ);
+    gboolean ret = TRUE;
+    FILE *fp;
+    int rc;
+
+    if (tmp_fd < 0) {
+        ret = FALSE;
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("cannot create temporary file: %s"),
+                     tmp_fn_templ);
+        goto done;
+    }
+    fp = fdopen(tmp_fd, "w+");
+    if (!fp) {
+        ret = FALSE;
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("failed opening tmp file: %s"),
+                     strerror(errno));
+        goto done;
+    }
+    g_debug("%s: storing %s to: %s", __func__, repo->name, tmp_fn_templ);
+    rc = repo_write_filtered(repo, fp, write_descriptions_filter, NULL, 0);
+    rc |= checksum_write(repoImpl->checksum, fp);
+    rc |= fclose(fp);
+    if (rc) {
+        ret = FALSE;
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("write_descriptions() failed writing data: %i"), rc);
         goto done;
-    repoImpl->state_main = _HY_WRITTEN;
+    }
+    ret = publish_cache_file(sack, hrepo, tmp_fn_templ, fn, &repoImpl->state_descriptions, error);
 
  done:
     if (!ret && tmp_fd >= 0)
@@ -642,12 +1067,8 @@ write_ext(DnfSack *sack, HyRepo hrepo, _hy_repo_repodata which_repodata,
         }
     }
 
-    if (!mv(tmp_fn_templ, fn, error)) {
-        success = FALSE;
-        goto done;
-    }
-    repo_update_state(hrepo, which_repodata, _HY_WRITTEN);
-    success = TRUE;
+    success = publish_cache_file(sack, hrepo, tmp_fn_templ, fn,
+                                 repo_get_state(hrepo, which_repodata), error);
  done:
     if (ret && tmp_fd >=0 )
         unlink(tmp_fn_templ);
@@ -666,8 +1087,10 @@ load_yum_repo(DnfSack *sack, HyRepo hrepo, GError **error)
     const char *name = hrepo->getId().c_str();
     Repo *repo = repo_create(pool, name);
     const char *fn_repomd = repoImpl->repomdFn.c_str();
-    char *fn_cache = dnf_sack_give_cache_fn(sack, name, NULL);
+    const bool compact = repoImpl->load_flags & DNF_SACK_LOAD_FLAG_COMPACT;
+    char *fn_cache = dnf_sack_give_cache_fn(sack, name, compact ? HY_EXT_RESOLVER : NULL);
 
+    MetadataReader primary_reader;
     FILE *fp_primary = NULL;
     FILE *fp_repomd = NULL;
     FILE *fp_cache = fopen(fn_cache, "r");
@@ -703,6 +1126,10 @@ load_yum_repo(DnfSack *sack, HyRepo hrepo, GError **error)
             goto out;
         }
         repoImpl->state_main = _HY_LOADED_CACHE;
+        if (compact) {
+            repoImpl->descriptions_pending = true;
+            priv->have_pending_descriptions = TRUE;
+        }
     } else {
         auto primary = hrepo->getMetadataPath(MD_TYPE_PRIMARY);
         if (primary.empty()) {
@@ -715,12 +1142,13 @@ load_yum_repo(DnfSack *sack, HyRepo hrepo, GError **error)
             retval = FALSE;
             goto out;
         }
-        fp_primary = solv_xfopen(primary.c_str(), "r");
+        fp_primary = metadata_reader_open(&primary_reader, primary.c_str());
         assert(fp_primary);
 
         g_debug("fetching %s", name);
         if (repo_add_repomdxml(repo, fp_repomd, 0) || \
-            repo_add_rpmmd(repo, fp_primary, 0, 0)) {
+            repo_add_rpmmd(repo, fp_primary, 0, 0) || \
+            metadata_reader_close(&primary_reader)) {
             g_set_error (error,
                          DNF_ERROR,
                          DNF_ERROR_INTERNAL_ERROR,
@@ -735,8 +1163,7 @@ out:
         fclose(fp_cache);
     if (fp_repomd)
         fclose(fp_repomd);
-    if (fp_primary)
-        fclose(fp_primary);
+    metadata_reader_close(&primary_reader);
     g_free(fn_cache);
 
     if (retval) {
@@ -1152,6 +1579,7 @@ dnf_sack_add_cmdline_package_flags(DnfSack *sack, const char *fn, const int flag
     auto hrepo = static_cast<HyRepo>(repo->appdata);
     libdnf::repoGetImpl(hrepo)->needs_internalizing = 1;
     priv->considered_uptodate = FALSE;   /* triggers recompute_considered later */
+    priv->module_generation++;
     return dnf_package_new(sack, p);
 }
 
@@ -1249,6 +1677,7 @@ void
 dnf_sack_add_module_excludes(DnfSack *sack, const DnfPackageSet *pset)
 {
     DnfSackPrivate *priv = GET_PRIVATE(sack);
+    priv->module_excludes_valid = FALSE;
     dnf_sack_add_excludes_or_includes(sack, &priv->module_excludes, pset);
 }
 
@@ -1308,6 +1737,7 @@ void
 dnf_sack_remove_module_excludes(DnfSack *sack, const DnfPackageSet *pset)
 {
     DnfSackPrivate *priv = GET_PRIVATE(sack);
+    priv->module_excludes_valid = FALSE;
     dnf_sack_remove_excludes_or_includes(sack, priv->module_excludes, pset);
 }
 
@@ -1350,6 +1780,7 @@ dnf_sack_set_module_includes(DnfSack *sack, const DnfPackageSet *pset)
         return;
     }
     DnfSackPrivate *priv = GET_PRIVATE(sack);
+    priv->module_excludes_valid = FALSE;
     free_map_fully(priv->module_includes);
     priv->module_includes = static_cast<Map *>(g_malloc0(sizeof(Map)));
     auto pkgmap = pset->getMap();
@@ -1385,6 +1816,7 @@ void
 dnf_sack_set_module_excludes(DnfSack *sack, const DnfPackageSet *pset)
 {
     DnfSackPrivate *priv = GET_PRIVATE(sack);
+    priv->module_excludes_valid = FALSE;
     dnf_sack_set_excludes_or_includes(sack, &priv->module_excludes, pset);
 }
 
@@ -1699,6 +2131,8 @@ dnf_sack_load_system_repo(DnfSack *sack, HyRepo a_hrepo, int flags, GError **err
 
     libdnf::repoGetImpl(hrepo)->attachLibsolvRepo(repo);
     pool_set_installed(pool, repo);
+    priv->system_repo_generation++;
+    priv->module_generation++;
     priv->provides_ready = 0;
 
     repoImpl->main_nsolvables = repo->nsolvables;
@@ -1712,6 +2146,94 @@ dnf_sack_load_system_repo(DnfSack *sack, HyRepo a_hrepo, int flags, GError **err
     return ret;
 } CATCH_TO_GERROR(FALSE)
 
+/* the solv file of the filelists was written for the current metadata */
+static bool
+filelists_cache_valid(DnfSack *sack, HyRepo repo)
+{
+    auto repoImpl = libdnf::repoGetImpl(repo);
+    char *fn = dnf_sack_give_cache_fn(sack, repoImpl->libsolvRepo->name, HY_EXT_FILENAMES);
+    FILE *fp = fopen(fn, "r");
+    bool valid = can_use_repomd_cache(fp, repoImpl->checksum);
+
+    if (fp)
+        fclose(fp);
+    g_free(fn);
+    return valid;
+}
+
+static gboolean
+load_filelists(DnfSack *sack, HyRepo repo, GError **error)
+{
+    auto repoImpl = libdnf::repoGetImpl(repo);
+    GError *error_local = NULL;
+    MainSolvablesScope scope(repo);
+
+    repoImpl->filelists_pending = false;
+    if (!load_ext(sack, repo, _HY_REPODATA_FILENAMES,
+                  HY_EXT_FILENAMES, MD_TYPE_FILELISTS,
+                  load_filelists_cb, &error_local)) {
+        /* allow missing files */
+        if (g_error_matches (error_local,
+                             DNF_ERROR,
+                             DNF_ERROR_NO_CAPABILITY)) {
+            g_debug("no filelists metadata available for %s", repoImpl->conf->name().getValue().c_str());
+            g_clear_error (&error_local);
+        } else {
+            g_propagate_error (error, error_local);
+            return FALSE;
+        }
+    }
+    if (repoImpl->state_filelists == _HY_LOADED_FETCH &&
+        (repoImpl->load_flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE)) {
+        if (!write_ext(sack, repo,
+                       _HY_REPODATA_FILENAMES,
+                       HY_EXT_FILENAMES, error))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+load_presto(DnfSack *sack, HyRepo repo, GError **error)
+{
+    auto repoImpl = libdnf::repoGetImpl(repo);
+    GError *error_local = NULL;
+
+    if (!load_ext(sack, repo, _HY_REPODATA_PRESTO,
+                  HY_EXT_PRESTO, MD_TYPE_PRESTODELTA,
+                  load_presto_cb, &error_local)) {
+        /* allow missing files */
+        if (g_error_matches (error_local,
+                             DNF_ERROR,
+                             DNF_ERROR_NO_CAPABILITY)) {
+            g_debug("no presto metadata available for %s", repoImpl->conf->name().getValue().c_str());
+            g_clear_error (&error_local);
+        } else {
+            g_propagate_error (error, error_local);
+            return FALSE;
+        }
+    }
+    if (repoImpl->state_presto == _HY_LOADED_FETCH &&
+        (repoImpl->load_flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE)) {
+        if (!write_ext(sack, repo,
+                       _HY_REPODATA_PRESTO,
+                       HY_EXT_PRESTO, error))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+dnf_sack_load_repo_presto(DnfSack *sack, HyRepo repo, GError **error) try
+{
+    auto repoImpl = libdnf::repoGetImpl(repo);
+
+    /* loaded already, or the repo is not in the sack */
+    if (repoImpl->state_presto != _HY_NEW || repoImpl->libsolvRepo == NULL)
+        return TRUE;
+    return load_presto(sack, repo, error);
+} CATCH_TO_GERROR(FALSE)
+
 /**
  * dnf_sack_load_repo:
  * @sack: a #DnfSack instance.
@@ -1733,10 +2255,13 @@ dnf_sack_load_repo(DnfSack *sack, HyRepo repo, int flags, GError **error) try
     GError *error_local = NULL;
     const int build_cache = flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE;
     gboolean retval;
+    repoImpl->load_flags = flags;
     if (!load_yum_repo(sack, repo, error))
         return FALSE;
-    repoImpl->load_flags = flags;
+    priv->module_generation++;
     if (repoImpl->state_main == _HY_LOADED_FETCH && build_cache) {
+        if ((flags & DNF_SACK_LOAD_FLAG_COMPACT) && !write_descriptions(sack, repo, error))
+            return FALSE;
         if (!write_main(sack, repo, 1, error))
             return FALSE;
     }
@@ -1744,26 +2269,12 @@ dnf_sack_load_repo(DnfSack *sack, HyRepo repo, int flags, GError **error) try
     repoImpl->main_nrepodata = repoImpl->libsolvRepo->nrepodata;
     repoImpl->main_end = repoImpl->libsolvRepo->end;
     if (flags & DNF_SACK_LOAD_FLAG_USE_FILELISTS) {
-        retval = load_ext(sack, repo, _HY_REPODATA_FILENAMES,
-                          HY_EXT_FILENAMES, MD_TYPE_FILELISTS,
-                          load_filelists_cb, &error_local);
-        /* allow missing files */
-        if (!retval) {
-            if (g_error_matches (error_local,
-                                 DNF_ERROR,
-                                 DNF_ERROR_NO_CAPABILITY)) {
-                g_debug("no filelists metadata available for %s", repoImpl->conf->name().getValue().c_str());
-                g_clear_error (&error_local);
-            } else {
-                g_propagate_error (error, error_local);
-                return FALSE;
-            }
-        }
-        if (repoImpl->state_filelists == _HY_LOADED_FETCH && build_cache) {
-            if (!write_ext(sack, repo,
-                           _HY_REPODATA_FILENAMES,
-                           HY_EXT_FILENAMES, error))
-                return FALSE;
+        /* the deferred loading cannot report failures, only a valid cache is deferred */
+        if ((flags & DNF_SACK_LOAD_FLAG_LAZY_FILELISTS) && filelists_cache_valid(sack, repo)) {
+            repoImpl->filelists_pending = true;
+            priv->have_pending_filelists = TRUE;
+        } else if (!load_filelists(sack, repo, error)) {
+            return FALSE;
         }
     }
     if (flags & DNF_SACK_LOAD_FLAG_USE_OTHER) {
@@ -1790,23 +2301,8 @@ dnf_sack_load_repo(DnfSack *sack, HyRepo repo, int flags, GError **error) try
         }
     }
     if (flags & DNF_SACK_LOAD_FLAG_USE_PRESTO) {
-        retval = load_ext(sack, repo, _HY_REPODATA_PRESTO,
-                          HY_EXT_PRESTO, MD_TYPE_PRESTODELTA,
-                          load_presto_cb, &error_local);
-        if (!retval) {
-            if (g_error_matches (error_local,
-                                 DNF_ERROR,
-                                 DNF_ERROR_NO_CAPABILITY)) {
-                g_debug("no presto metadata available for %s", repoImpl->conf->name().getValue().c_str());
-                g_clear_error (&error_local);
-            } else {
-                g_propagate_error (error, error_local);
-                return FALSE;
-            }
-        }
-        if (repoImpl->state_presto == _HY_LOADED_FETCH && build_cache)
-            if (!write_ext(sack, repo, _HY_REPODATA_PRESTO, HY_EXT_PRESTO, error))
-                return FALSE;
+        if (!load_presto(sack, repo, error))
+            return FALSE;
     }
     /* updateinfo must come *after* all other extensions, as it is not a real
        extension, but contains a new set of packages */
@@ -1834,8 +2330,200 @@ dnf_sack_load_repo(DnfSack *sack, HyRepo repo, int flags, GError **error) try
     return TRUE;
 } CATCH_TO_GERROR(FALSE)
 
+/**
+ * dnf_sack_wait_cache_writes:
+ * @sack: a #DnfSack instance.
+ * @error: a #GError, or %NULL.
+ *
+ * Waits until the solv cache files of repos loaded with
+ * %DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC are written. The sack waits
+ * for them itself before it gets ready for depsolving and when destroyed.
+ * A failure found by such a wait is returned by the next call of this
+ * function. dnf_sack_add_repos() uses the flag and waits before it returns.
+ *
+ * Returns: %TRUE for success, the first failure is returned otherwise
+ *
+ * Since: 0.55.0
+ */
+gboolean
+dnf_sack_wait_cache_writes(DnfSack *sack, GError **error)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    std::unique_ptr<CacheWriter> writer(priv->cache_writer);
+    gboolean ret = TRUE;
+
+    /* the failure of an earlier internal wait comes first */
+    if (priv->cache_write_error) {
+        g_propagate_error(error, priv->cache_write_error);
+        priv->cache_write_error = NULL;
+        ret = FALSE;
+    }
+    if (!writer)
+        return ret;
+    priv->cache_writer = NULL;
+    g_thread_pool_free(writer->pool, FALSE, TRUE);
+    for (auto & job : writer->jobs) {
+        if (!job->error) {
+            *job->state = _HY_WRITTEN;
+        } else if (ret) {
+            g_propagate_error(error, job->error);
+            job->error = NULL;
+            ret = FALSE;
+        } else {
+            g_warning("%s", job->error->message);
+        }
+    }
+    return ret;
+}
+
+/* Waits for the cache writes where the failure cannot be returned, it is kept
+ * for the next dnf_sack_wait_cache_writes() */
+static void
+wait_cache_writes_deferred(DnfSack *sack)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    GError *error_local = NULL;
+
+    if (!priv->cache_writer)
+        return;
+    if (!dnf_sack_wait_cache_writes(sack, &error_local))
+        priv->cache_write_error = error_local;
+}
+
 // internal to hawkey
 
+/* Files createrepo lists in primary, other files are only in filelists */
+static bool
+filename_in_primary(const char *filename)
+{
+    return g_str_has_prefix(filename, "/etc/") || strstr(filename, "bin/") ||
+        strcmp(filename, "/usr/lib/sendmail") == 0;
+}
+
+static bool
+filenames_in_primary(Pool *pool, Queue *filenames)
+{
+    for (int i = 0; i < filenames->count; ++i) {
+        if (!filename_in_primary(pool_id2str(pool, filenames->elements[i])))
+            return false;
+    }
+    return true;
+}
+
+void
+dnf_sack_load_lazy_filelists(DnfSack *sack, Repo *repo)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+    bool pending = false;
+    Repo *r;
+    int i;
+
+    if (!priv->have_pending_filelists)
+        return;
+    if (repo) {
+        auto hrepo = static_cast<HyRepo>(repo->appdata);
+        if (!hrepo || !libdnf::repoGetImpl(hrepo)->filelists_pending)
+            return;
+    }
+    FOR_REPOS(i, r) {
+        auto hrepo = static_cast<HyRepo>(r->appdata);
+        if (!hrepo || !libdnf::repoGetImpl(hrepo)->filelists_pending)
+            continue;
+        if (repo && r != repo) {
+            pending = true;
+            continue;
+        }
+        g_autoptr(GError) error = NULL;
+        g_debug("loading deferred filelists of %s", r->name);
+        if (!load_filelists(sack, hrepo, &error))
+            g_warning("failed to load filelists of %s: %s", r->name, error->message);
+    }
+    priv->have_pending_filelists = pending;
+}
+
+void
+dnf_sack_load_lazy_filelists_for(DnfSack *sack, const char *filename, int cmp_type)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+
+    if (!priv->have_pending_filelists)
+        return;
+    cmp_type &= ~HY_NOT;
+    /* all matches of a glob starting with /etc/ are in primary too */
+    if ((cmp_type == HY_EQ && filename_in_primary(filename)) ||
+        (cmp_type == HY_GLOB && g_str_has_prefix(filename, "/etc/")))
+        return;
+    dnf_sack_load_lazy_filelists(sack, NULL);
+}
+
+static gboolean
+load_descriptions(DnfSack *sack, HyRepo hrepo, GError **error)
+{
+    auto repoImpl = libdnf::repoGetImpl(hrepo);
+    Repo *repo = repoImpl->libsolvRepo;
+    char *fn = dnf_sack_give_cache_fn(sack, repo->name, HY_EXT_DESCRIPTIONS);
+    FILE *fp = fopen(fn, "r");
+    gboolean ret = TRUE;
+
+    repoImpl->descriptions_pending = false;
+    if (!can_use_repomd_cache(fp, repoImpl->checksum)) {
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("cannot use %s"), fn);
+        ret = FALSE;
+    } else {
+        MainSolvablesScope scope(hrepo);
+        g_debug("%s: using cache file: %s", __func__, fn);
+        /* the strings are only looked up, they do not go to the main pool */
+        if (repo_add_solv(repo, fp, REPO_EXTEND_SOLVABLES | REPO_LOCALPOOL)) {
+            g_set_error_literal (error,
+                                 DNF_ERROR,
+                                 DNF_ERROR_INTERNAL_ERROR,
+                                 _("failed to add solv"));
+            ret = FALSE;
+        }
+    }
+    if (fp)
+        fclose(fp);
+    g_free(fn);
+    return ret;
+}
+
+void
+dnf_sack_load_lazy_descriptions(DnfSack *sack, Repo *repo)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+    bool pending = false;
+    Repo *r;
+    int i;
+
+    if (!priv->have_pending_descriptions)
+        return;
+    if (repo) {
+        auto hrepo = static_cast<HyRepo>(repo->appdata);
+        if (!hrepo || !libdnf::repoGetImpl(hrepo)->descriptions_pending)
+            return;
+    }
+    /* the file may be still being written */
+    wait_cache_writes_deferred(sack);
+    FOR_REPOS(i, r) {
+        auto hrepo = static_cast<HyRepo>(r->appdata);
+        if (!hrepo || !libdnf::repoGetImpl(hrepo)->descriptions_pending)
+            continue;
+        if (repo && r != repo) {
+            pending = true;
+            continue;
+        }
+        g_autoptr(GError) error_local = NULL;
+        if (!load_descriptions(sack, hrepo, &error_local))
+            g_warning("failed to load descriptions of %s: %s", r->name, error_local->message);
+    }
+    priv->have_pending_descriptions = pending;
+}
+
 // return true if q1 is a superset of q2
 // only works if there are no duplicates both in q1 and q2
 // the map parameter must point to an empty map that can hold all ids
@@ -1926,6 +2614,8 @@ dnf_sack_make_provides_ready(DnfSack *sack)
 
     if (priv->provides_ready)
         return;
+    /* rewrite_repos() must not race with the pending writes of the same files */
+    wait_cache_writes_deferred(sack);
     repo_internalize_all_trigger(priv->pool);
     Queue addedfileprovides;
     Queue addedfileprovides_inst;
@@ -1933,12 +2623,264 @@ dnf_sack_make_provides_ready(DnfSack *sack)
     queue_init(&addedfileprovides_inst);
     pool_addfileprovides_queue(priv->pool, &addedfileprovides,
                                &addedfileprovides_inst);
+    if (priv->have_pending_filelists &&
+        !(filenames_in_primary(priv->pool, &addedfileprovides) &&
+          filenames_in_primary(priv->pool, &addedfileprovides_inst))) {
+        /* a file dependency can be provided only by a file missing in primary */
+        dnf_sack_load_lazy_filelists(sack, NULL);
+        repo_internalize_all_trigger(priv->pool);
+        queue_empty(&addedfileprovides);
+        queue_empty(&addedfileprovides_inst);
+        pool_addfileprovides_queue(priv->pool, &addedfileprovides,
+                                   &addedfileprovides_inst);
+    }
     if (addedfileprovides.count || addedfileprovides_inst.count)
         rewrite_repos(sack, &addedfileprovides, &addedfileprovides_inst);
     queue_free(&addedfileprovides);
     queue_free(&addedfileprovides_inst);
     pool_createwhatprovides(priv->pool);
     priv->provides_ready = 1;
+    priv->provides_generation++;
+}
+
+const std::vector<Id> &
+dnf_sack_get_provide_names(DnfSack *sack)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+
+    dnf_sack_make_provides_ready(sack);
+    auto index = priv->provide_names;
+    if (index && index->providesGeneration == priv->provides_generation) {
+        return index->names;
+    }
+    if (!index) {
+        index = priv->provide_names = new ProvideNameIndex;
+    }
+    index->providesGeneration = priv->provides_generation;
+    index->names.clear();
+
+    Queue provides;
+    queue_init(&provides);
+    for (Id id = 2; id < pool->nsolvables; ++id) {
+        Solvable * s = pool_id2solvable(pool, id);
+        if (!s->repo) {
+            continue;
+        }
+        solvable_lookup_idarray(s, SOLVABLE_PROVIDES, &provides);
+        for (int i = 0; i < provides.count; ++i) {
+            Id name = provides.elements[i];
+            while (ISRELDEP(name)) {
+                name = GETRELDEP(pool, name)->name;
+            }
+            if (name != SOLVABLE_FILEMARKER) {
+                index->names.push_back(name);
+            }
+        }
+    }
+    queue_free(&provides);
+
+    auto & names = index->names;
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::sort(names.begin(), names.end(), [pool](Id first, Id second) {
+        return strcmp(pool_id2str(pool, first), pool_id2str(pool, second)) < 0;
+    });
+    names.shrink_to_fit();
+    return names;
+}
+
+/* Appends names the dependency can be matched by. Both sides of rich dependencies are used. */
+static void
+dependencyNames(Pool * pool, Id dep, std::vector<Id> & names)
+{
+    while (ISRELDEP(dep)) {
+        Reldep * rd = GETRELDEP(pool, dep);
+        if (rd->flags >= 8)
+            dependencyNames(pool, rd->evr, names);
+        dep = rd->name;
+    }
+    names.push_back(dep);
+}
+
+static const DependencyNameIndex &
+getDependencyNameIndex(DnfSack * sack, Id keyname)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+    auto index = priv->dependency_index;
+    if (!index) {
+        index = priv->dependency_index = new DependencyIndex;
+    }
+    if (index->nsolvables != pool->nsolvables
+        || index->systemRepoGeneration != priv->system_repo_generation) {
+        index->byKeyname.clear();
+        index->nsolvables = pool->nsolvables;
+        index->systemRepoGeneration = priv->system_repo_generation;
+    }
+    auto inserted = index->byKeyname.emplace(keyname, DependencyNameIndex());
+    auto & nameIndex = inserted.first->second;
+    if (!inserted.second) {
+        return nameIndex;
+    }
+
+    Queue deps;
+    queue_init(&deps);
+    std::vector<Id> names;
+    for (Id id = 2; id < pool->nsolvables; ++id) {
+        Solvable * s = pool_id2solvable(pool, id);
+        if (!s->repo) {
+            continue;
+        }
+        solvable_lookup_idarray(s, keyname, &deps);
+        names.clear();
+        for (int i = 0; i < deps.count; ++i) {
+            if (deps.elements[i] != SOLVABLE_PREREQMARKER) {
+                dependencyNames(pool, deps.elements[i], names);
+            }
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        for (auto name : names) {
+            nameIndex.emplace_back(name, id);
+        }
+    }
+    queue_free(&deps);
+    std::sort(nameIndex.begin(), nameIndex.end());
+    nameIndex.shrink_to_fit();
+    return nameIndex;
+}
+
+void
+dnf_sack_get_dependency_candidates(DnfSack *sack, Id keyname, Id dep, std::vector<Id> & candidates)
+{
+    Pool * pool = dnf_sack_get_pool(sack);
+    auto & nameIndex = getDependencyNameIndex(sack, keyname);
+    std::vector<Id> names;
+    dependencyNames(pool, dep, names);
+    for (auto name : names) {
+        auto it = std::lower_bound(nameIndex.begin(), nameIndex.end(), std::make_pair(name, Id(0)));
+        for (; it != nameIndex.end() && it->first == name; ++it) {
+            candidates.push_back(it->second);
+        }
+    }
+}
+
+const std::vector<int> &
+dnf_sack_get_evr_ranks(DnfSack *sack)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+    auto index = priv->evr_ranks;
+    if (!index) {
+        index = priv->evr_ranks = new EvrRankIndex;
+    }
+    if (index->nsolvables == pool->nsolvables
+        && index->systemRepoGeneration == priv->system_repo_generation) {
+        return index->ranks;
+    }
+    index->nsolvables = pool->nsolvables;
+    index->systemRepoGeneration = priv->system_repo_generation;
+
+    // evrs without a rank, usually only those of the repos loaded since the last call
+    auto & ranks = index->ranks;
+    std::vector<Id> added;
+    for (Id id = 2; id < pool->nsolvables; ++id) {
+        Solvable * s = pool_id2solvable(pool, id);
+        if (!s->repo) {
+            continue;
+        }
+        if (static_cast<size_t>(s->evr) >= ranks.size() || ranks[s->evr] == 0) {
+            added.push_back(s->evr);
+        }
+    }
+    if (added.empty()) {
+        return ranks;
+    }
+    std::sort(added.begin(), added.end());
+    added.erase(std::unique(added.begin(), added.end()), added.end());
+    if (static_cast<size_t>(added.back()) >= ranks.size()) {
+        ranks.resize(added.back() + 1, 0);
+    }
+    auto evrLess = [pool](Id first, Id second) {
+        return pool_evrcmp(pool, first, second, EVRCMP_COMPARE) < 0;
+    };
+    std::sort(added.begin(), added.end(), evrLess);
+    std::vector<Id> evrs;
+    evrs.reserve(index->evrs.size() + added.size());
+    std::merge(index->evrs.begin(), index->evrs.end(), added.begin(), added.end(),
+               std::back_inserter(evrs), evrLess);
+    index->evrs.swap(evrs);
+
+    int rank = 0;
+    for (size_t i = 0; i < index->evrs.size(); ++i) {
+        Id evr = index->evrs[i];
+        if (i == 0 || pool_evrcmp(pool, index->evrs[i - 1], evr, EVRCMP_COMPARE) != 0) {
+            ++rank;
+        }
+        ranks[evr] = rank;
+    }
+    return ranks;
+}
+
+int
+dnf_sack_get_evr_rank_bound(DnfSack *sack, Id evr, bool *exact)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+    auto & ranks = dnf_sack_get_evr_ranks(sack);
+    auto & evrs = priv->evr_ranks->evrs;
+    auto low = std::lower_bound(evrs.begin(), evrs.end(), evr, [pool](Id first, Id second) {
+        return pool_evrcmp(pool, first, second, EVRCMP_COMPARE) < 0;
+    });
+    if (low == evrs.end()) {
+        *exact = false;
+        return evrs.empty() ? 1 : ranks[evrs.back()] + 1;
+    }
+    *exact = pool_evrcmp(pool, *low, evr, EVRCMP_COMPARE) == 0;
+    return ranks[*low];
+}
+
+const std::vector<Id> &
+dnf_sack_get_name_ordered_solvables(DnfSack *sack, bool byArch)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+    auto index = priv->solvable_order;
+    if (!index) {
+        index = priv->solvable_order = new SolvableOrderIndex;
+    }
+    if (index->nsolvables != pool->nsolvables
+        || index->systemRepoGeneration != priv->system_repo_generation) {
+        index->byName.clear();
+        index->byNameArch.clear();
+        index->nsolvables = pool->nsolvables;
+        index->systemRepoGeneration = priv->system_repo_generation;
+    }
+    auto & ordered = byArch ? index->byNameArch : index->byName;
+    if (!ordered.empty()) {
+        return ordered;
+    }
+
+    for (Id id = 2; id < pool->nsolvables; ++id) {
+        if (pool_id2solvable(pool, id)->repo) {
+            ordered.push_back(id);
+        }
+    }
+    auto & ranks = dnf_sack_get_evr_ranks(sack);
+    std::sort(ordered.begin(), ordered.end(), [pool, byArch, &ranks](Id first, Id second) {
+        Solvable * sFirst = pool_id2solvable(pool, first);
+        Solvable * sSecond = pool_id2solvable(pool, second);
+        if (sFirst->name != sSecond->name)
+            return sFirst->name < sSecond->name;
+        if (byArch && sFirst->arch != sSecond->arch)
+            return sFirst->arch < sSecond->arch;
+        if (ranks[sFirst->evr] != ranks[sSecond->evr])
+            return ranks[sFirst->evr] > ranks[sSecond->evr];
+        return first < second;
+    });
+    ordered.shrink_to_fit();
+    return ordered;
 }
 
 /**
@@ -1995,6 +2937,7 @@ dnf_sack_set_module_container(DnfSack *sack, libdnf::ModulePackageContainer * ne
     DnfSackPrivate *priv = GET_PRIVATE(sack);
     auto oldConteiner = priv->moduleContainer;
     priv->moduleContainer = newConteiner;
+    priv->module_generation++;
     return oldConteiner;
 }
 
@@ -2017,6 +2960,56 @@ dnf_sack_get_module_container(DnfSack *sack)
 
 /**********************************************************************/
 
+/**
+ * Resolves all patterns in a single pass over the query and adds the matched packages to the set.
+ * Returns true if at least one pattern matched.
+ */
+static bool
+filterPatterns(libdnf::Query & query, const std::vector<std::string> & patterns,
+               libdnf::PackageSet & matched)
+{
+    if (patterns.empty())
+        return false;
+    std::vector<const char *> subjects;
+    subjects.reserve(patterns.size());
+    for (const auto & pattern : patterns)
+        subjects.push_back(pattern.c_str());
+
+    auto ret = query.filterSubjects(subjects, nullptr, false, true, false, false);
+    bool found = false;
+    for (const auto & subjectRet : ret)
+        found = found || subjectRet.first;
+    if (found)
+        matched += *query.runSet();
+    return found;
+}
+
+/**
+ * Resolves includepkgs/excludepkgs of the main configuration in the packages of the query.
+ * Returns true if some includes were found.
+ */
+static bool
+process_main_excludes(DnfSack *sack, const libdnf::Query & baseQuery,
+                      libdnf::PackageSet & includes, libdnf::PackageSet & excludes)
+{
+    auto & mainConf = libdnf::getGlobalMainConfig();
+    bool useGlobalIncludes = false;
+    if (!mainConf.includepkgs().getValue().empty()) {
+        libdnf::Query query(baseQuery);
+        useGlobalIncludes = filterPatterns(query, mainConf.includepkgs().getValue(), includes);
+    }
+
+    if (!mainConf.excludepkgs().getValue().empty()) {
+        libdnf::Query query(baseQuery);
+        filterPatterns(query, mainConf.excludepkgs().getValue(), excludes);
+    }
+
+    if (useGlobalIncludes) {
+        dnf_sack_set_use_includes(sack, nullptr, true);
+    }
+    return useGlobalIncludes;
+}
+
 static void
 process_excludes(DnfSack *sack, GPtrArray *enabled_repos)
 {
@@ -2037,52 +3030,42 @@ process_excludes(DnfSack *sack, GPtrArray *enabled_repos)
         if (std::find(disabled.begin(), disabled.end(), repo->getId()) != disabled.end()) {
             continue;
         }
+        auto & includes = repo->getConfig()->includepkgs().getValue();
+        auto & excludes = repo->getConfig()->excludepkgs().getValue();
+        if (includes.empty() && excludes.empty()) {
+            continue;
+        }
 
+        // packages of a repo are a contiguous range of solvables, no need to filter the sack
+        libdnf::PackageSet repoPkgs(sack);
+        if (auto libsolvRepo = libdnf::repoGetImpl(repo)->libsolvRepo) {
+            Id p;
+            Solvable *s;
+            FOR_REPO_SOLVABLES(libsolvRepo, p, s)
+                repoPkgs.set(p);
+        }
         libdnf::Query repoQuery(sack);
-        repoQuery.addFilter(HY_PKG_REPONAME, HY_EQ, repo->getId().c_str());
+        repoQuery.addFilter(HY_PKG, HY_EQ, &repoPkgs);
         repoQuery.apply();
 
-        for (const auto & name : repo->getConfig()->includepkgs().getValue()) {
+        if (!includes.empty()) {
             libdnf::Query query(repoQuery);
-            auto ret = query.filterSubject(name.c_str(), nullptr, false, true, false, false);
-            if (ret.first) {
-                repoIncludes += *query.runSet();
+            if (filterPatterns(query, includes, repoIncludes)) {
                 includesExist = true;
                 repo->setUseIncludes(true);
             }
         }
-
-        for (const auto & name : repo->getConfig()->excludepkgs().getValue()) {
+        if (!excludes.empty()) {
             libdnf::Query query(repoQuery);
-            auto ret = query.filterSubject(name.c_str(), nullptr, false, true, false, false);
-            if (ret.first) {
-                repoExcludes += *query.runSet();
-            }
+            filterPatterns(query, excludes, repoExcludes);
         }
     }
 
     if (std::find(disabled.begin(), disabled.end(), "main") == disabled.end()) {
-        bool useGlobalIncludes = false;
-        for (const auto & name : mainConf.includepkgs().getValue()) {
-            libdnf::Query query(sack);
-            auto ret = query.filterSubject(name.c_str(), nullptr, false, true, false, false);
-            if (ret.first) {
-                repoIncludes += *query.runSet();
-                includesExist = true;
-                useGlobalIncludes = true;
-            }
-        }
-
-        for (const auto & name : mainConf.excludepkgs().getValue()) {
-            libdnf::Query query(sack);
-            auto ret = query.filterSubject(name.c_str(), nullptr, false, true, false, false);
-            if (ret.first) {
-                repoExcludes += *query.runSet();
-            }
-        }
-        
-        if (useGlobalIncludes) {
-            dnf_sack_set_use_includes(sack, nullptr, true);
+        libdnf::Query query(sack);
+        query.apply();
+        if (process_main_excludes(sack, query, repoIncludes, repoExcludes)) {
+            includesExist = true;
         }
     }
 
@@ -2093,21 +3076,142 @@ process_excludes(DnfSack *sack, GPtrArray *enabled_repos)
 }
 
 /**
- * dnf_sack_add_repo:
+ * dnf_sack_refresh_system_repo:
+ * @sack: a #DnfSack instance.
+ * @error: a #GError or %NULL.
+ *
+ * Re-reads the installed packages after the rpmdb was changed, e.g. by
+ * a transaction, and keeps the available repos loaded. Packages which stayed
+ * installed are taken over from the current @System repo without parsing
+ * their headers again, and they keep their excludes and includes. The main
+ * configuration includepkgs and excludepkgs are applied to the newly installed
+ * packages.
+ *
+ * Nothing is changed when the installed packages are the same. Otherwise
+ * packages of the previous @System repo must not be used anymore.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.55.0
  */
 gboolean
-dnf_sack_add_repo(DnfSack *sack,
-                    DnfRepo *repo,
-                    guint permissible_cache_age,
-                    DnfSackAddFlags flags,
-                    DnfState *state,
-                    GError **error) try
+dnf_sack_refresh_system_repo(DnfSack *sack, GError **error) try
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = dnf_sack_get_pool(sack);
+    Repo *oldRepo = pool->installed;
+    if (!oldRepo || !oldRepo->appdata)
+        return dnf_sack_load_system_repo(sack, nullptr, DNF_SACK_LOAD_FLAG_NONE, error);
+    auto hrepo = static_cast<HyRepo>(oldRepo->appdata);
+    auto repoImpl = libdnf::repoGetImpl(hrepo);
+
+    Repo *repo = repo_create(pool, HY_SYSTEM_REPO_NAME);
+    g_debug("refreshing rpmdb");
+    int flagsrpm = REPO_REUSE_REPODATA | RPM_ADD_WITH_HDRID | REPO_USE_ROOTDIR;
+    if (repo_add_rpmdb(repo, oldRepo, flagsrpm)) {
+        repo_free(repo, 1);
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("failed loading RPMDB"));
+        return FALSE;
+    }
+
+    // pair packages which stayed installed by their rpmdb id and nevra
+    std::map<Id, Id> newByRpmdbId;
+    Id p;
+    Solvable *s;
+    FOR_REPO_SOLVABLES(repo, p, s)
+        if (repo->rpmdbid)
+            newByRpmdbId[repo->rpmdbid[p - repo->start]] = p;
+    std::vector<std::pair<Id, Id>> kept;
+    FOR_REPO_SOLVABLES(oldRepo, p, s) {
+        if (!oldRepo->rpmdbid)
+            break;
+        auto it = newByRpmdbId.find(oldRepo->rpmdbid[p - oldRepo->start]);
+        if (it == newByRpmdbId.end())
+            continue;
+        Solvable *newSolvable = pool_id2solvable(pool, it->second);
+        if (newSolvable->name == s->name && newSolvable->evr == s->evr &&
+            newSolvable->arch == s->arch) {
+            kept.emplace_back(p, it->second);
+            newByRpmdbId.erase(it);
+        }
+    }
+    if (newByRpmdbId.empty() && kept.size() == static_cast<size_t>(oldRepo->nsolvables)) {
+        g_debug("installed packages did not change");
+        repo_free(repo, 1);
+        return TRUE;
+    }
+
+    // move excludes and includes of kept packages to their new ids
+    for (Map *map : {priv->pkg_excludes, priv->pkg_includes, priv->repo_excludes,
+                     priv->module_excludes, priv->module_includes}) {
+        if (!map)
+            continue;
+        map_grow(map, pool->nsolvables);
+        for (const auto & oldNew : kept) {
+            if (MAPTST(map, oldNew.first))
+                MAPSET(map, oldNew.second);
+        }
+        FOR_REPO_SOLVABLES(oldRepo, p, s)
+            MAPCLR(map, p);
+    }
+
+    repoImpl->attachLibsolvRepo(repo);
+    repo_free(oldRepo, 1);
+    pool_set_installed(pool, repo);
+    priv->system_repo_generation++;
+    priv->module_generation++;
+    repoImpl->main_nsolvables = repo->nsolvables;
+    repoImpl->main_nrepodata = repo->nrepodata;
+    repoImpl->main_end = repo->end;
+
+    priv->provides_ready = 0;
+    priv->considered_uptodate = FALSE;
+    priv->module_excludes_valid = FALSE;
+    priv->running_kernel_id = -1;
+    free_map_fully(priv->pkg_solvables);
+    priv->pkg_solvables = NULL;
+    priv->pool_nsolvables = 0;
+
+    auto & disabled = libdnf::getGlobalMainConfig().disable_excludes().getValue();
+    if (!newByRpmdbId.empty() &&
+        std::find(disabled.begin(), disabled.end(), "all") == disabled.end() &&
+        std::find(disabled.begin(), disabled.end(), "main") == disabled.end()) {
+        libdnf::PackageSet newPkgs(sack);
+        for (const auto & rpmdbIdNew : newByRpmdbId)
+            newPkgs.set(rpmdbIdNew.second);
+        libdnf::Query query(sack, libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES);
+        query.addFilter(HY_PKG, HY_EQ, &newPkgs);
+        query.apply();
+        libdnf::PackageSet includes(sack);
+        libdnf::PackageSet excludes(sack);
+        if (process_main_excludes(sack, query, includes, excludes))
+            dnf_sack_add_includes(sack, &includes);
+        dnf_sack_add_excludes(sack, &excludes);
+    }
+    return TRUE;
+} CATCH_TO_GERROR(FALSE)
+
+/* with build_cache_async the caller has to wait for the cache writes */
+static gboolean
+dnf_sack_add_repo_internal(DnfSack *sack,
+                           DnfRepo *repo,
+                           guint permissible_cache_age,
+                           DnfSackAddFlags flags,
+                           gboolean build_cache_async,
+                           DnfState *state,
+                           GError **error)
 {
     gboolean ret = TRUE;
     GError *error_local = NULL;
     DnfState *state_local;
     int flags_hy = DNF_SACK_LOAD_FLAG_BUILD_CACHE;
 
+    if (build_cache_async)
+        flags_hy |= DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC;
+
     /* set state */
     ret = dnf_state_set_steps(state, error,
                    5, /* check repo */
@@ -2163,11 +3267,15 @@ dnf_sack_add_repo(DnfSack *sack,
 
     /* only load what's required */
     if ((flags & DNF_SACK_ADD_FLAG_FILELISTS) > 0)
-        flags_hy |= DNF_SACK_LOAD_FLAG_USE_FILELISTS;
+        flags_hy |= DNF_SACK_LOAD_FLAG_USE_FILELISTS | DNF_SACK_LOAD_FLAG_LAZY_FILELISTS;
     if ((flags & DNF_SACK_ADD_FLAG_OTHER) > 0)
         flags_hy |= DNF_SACK_LOAD_FLAG_USE_OTHER;
     if ((flags & DNF_SACK_ADD_FLAG_UPDATEINFO) > 0)
         flags_hy |= DNF_SACK_LOAD_FLAG_USE_UPDATEINFO;
+    if ((flags & DNF_SACK_ADD_FLAG_PRESTO) > 0)
+        flags_hy |= DNF_SACK_LOAD_FLAG_USE_PRESTO;
+    if ((flags & DNF_SACK_ADD_FLAG_COMPACT) > 0)
+        flags_hy |= DNF_SACK_LOAD_FLAG_COMPACT;
 
     /* load solv */
     g_debug("Loading repo %s", dnf_repo_get_id(repo));
@@ -2177,6 +3285,21 @@ dnf_sack_add_repo(DnfSack *sack,
 
     /* done */
     return dnf_state_done(state, error);
+}
+
+/**
+ * dnf_sack_add_repo:
+ */
+gboolean
+dnf_sack_add_repo(DnfSack *sack,
+                    DnfRepo *repo,
+                    guint permissible_cache_age,
+                    DnfSackAddFlags flags,
+                    DnfState *state,
+                    GError **error) try
+{
+    return dnf_sack_add_repo_internal(sack, repo, permissible_cache_age, flags,
+                                      FALSE, state, error);
 } CATCH_TO_GERROR(FALSE)
 
 /**
@@ -2225,15 +3348,19 @@ dnf_sack_add_repos(DnfSack *sack,
                 continue;
         }
 
+        /* the cache files are written while the following repos are loaded */
         state_local = dnf_state_get_child(state);
-        ret = dnf_sack_add_repo(sack,
-                                  repo,
-                                  permissible_cache_age,
-                                  flags,
-                                  state_local,
-                                  error);
-        if (!ret)
+        ret = dnf_sack_add_repo_internal(sack,
+                                         repo,
+                                         permissible_cache_age,
+                                         flags,
+                                         TRUE,
+                                         state_local,
+                                         error);
+        if (!ret) {
+            wait_cache_writes_deferred(sack);
             return FALSE;
+        }
 
         g_ptr_array_add(enabled_repos, repo);
 
@@ -2242,6 +3369,9 @@ dnf_sack_add_repos(DnfSack *sack,
             return FALSE;
     }
 
+    if (!dnf_sack_wait_cache_writes(sack, error))
+        return FALSE;
+
     process_excludes(sack, enabled_repos);
 
     /* success */
@@ -2267,77 +3397,175 @@ void readModuleMetadataFromRepo(DnfSack * sack, libdnf::ModulePackageContainer *
     }
 }
 
-static std::tuple<std::vector<std::string>, std::vector<std::string>>
-collectNevraForInclusionExclusion(libdnf::ModulePackageContainer &modulePackageContainer)
+/**
+ * Split module artifact "name-[epoch:]version-release.arch" into pool Ids. Strings unknown to the
+ * pool are not created - no package can match them. Zero epoch is stripped like libsolv does.
+ *
+ * @return false if the artifact is not in NEVRA format or its name is unknown to the pool
+ */
+static bool
+splitModuleArtifact(Pool * pool, const char * artifact, ModuleArtifactId & artifactId)
+{
+    const char * evrDelim = nullptr;
+    const char * releaseDelim = nullptr;
+    const char * archDelim = nullptr;
+    const char * end;
+
+    for (end = artifact; *end != '\0'; ++end) {
+        if (*end == '-') {
+            evrDelim = releaseDelim;
+            releaseDelim = end;
+        } else if (*end == '.') {
+            archDelim = end;
+        }
+    }
+    if (!evrDelim || evrDelim == artifact || releaseDelim - evrDelim <= 1 ||
+        !archDelim || archDelim <= releaseDelim + 1 || archDelim == end - 1)
+        return false;
+
+    if (!(artifactId.name = pool_strn2id(pool, artifact, evrDelim - artifact, 0)))
+        return false;
+
+    int index = 1;
+    while (evrDelim[index] == '0') {
+        if (evrDelim[++index] == ':') {
+            evrDelim += index;
+        }
+    }
+    ++evrDelim;
+    artifactId.evr = pool_strn2id(pool, evrDelim, archDelim - evrDelim, 0);
+    ++archDelim;
+    artifactId.arch = pool_strn2id(pool, archDelim, end - archDelim, 0);
+    return true;
+}
+
+static const std::vector<ModuleArtifactId> &
+getModuleArtifactIndex(DnfSack * sack, libdnf::ModulePackageContainer & moduleContainer)
 {
-    std::vector<std::string> includeNEVRAs;
-    std::vector<std::string> excludeNEVRAs;
-    // TODO: turn into std::vector<const char *> to prevent unnecessary conversion?
-    for (const auto &module : modulePackageContainer.getModulePackages()) {
-        auto artifacts = module->getArtifacts();
-        // TODO use Goal::listInstalls() to not requires filtering out Platform
-        if (modulePackageContainer.isModuleActive(module->getId())) {
-            copy(std::begin(artifacts), std::end(artifacts), std::back_inserter(includeNEVRAs));
-        } else {
-            copy(std::begin(artifacts), std::end(artifacts), std::back_inserter(excludeNEVRAs));
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool * pool = priv->pool;
+    auto modules = moduleContainer.getModulePackages();
+    auto index = priv->module_artifacts;
+    // modules added to the container behind the back of the sack change only their count
+    if (index && index->moduleGeneration == priv->module_generation
+        && index->nmodules == modules.size()) {
+        return index->artifacts;
+    }
+    if (!index) {
+        index = priv->module_artifacts = new ModuleArtifactIndex;
+    }
+    index->moduleGeneration = priv->module_generation;
+    index->nmodules = modules.size();
+    index->artifacts.clear();
+    for (const auto module : modules) {
+        ModuleArtifactId artifactId;
+        artifactId.module = module->getId();
+        for (const auto & artifact : module->getArtifacts()) {
+            if (splitModuleArtifact(pool, artifact.c_str(), artifactId)) {
+                index->artifacts.push_back(artifactId);
+            }
         }
     }
+    return index->artifacts;
+}
 
-    return std::tuple<std::vector<std::string>,
-    std::vector<std::string>>{includeNEVRAs, excludeNEVRAs};
+static bool
+moduleArtifactNevraLess(const ModuleArtifactId & first, const ModuleArtifactId & second)
+{
+    if (first.name != second.name)
+        return first.name < second.name;
+    if (first.arch != second.arch)
+        return first.arch < second.arch;
+    return first.evr < second.evr;
+}
+
+static bool
+moduleArtifactsHaveSolvable(const std::vector<ModuleArtifactId> & artifacts, const Solvable * s)
+{
+    ModuleArtifactId key{0, s->name, s->evr, s->arch};
+    return std::binary_search(artifacts.begin(), artifacts.end(), key, moduleArtifactNevraLess);
 }
 
 static void
 setModuleExcludes(DnfSack *sack, const char ** hotfixRepos,
-    const std::vector<std::string> &includeNEVRAs, const std::vector<std::string> &excludeNEVRAs)
+    libdnf::ModulePackageContainer & moduleContainer)
 {
     dnf_sack_set_module_excludes(sack, nullptr);
-    std::vector<std::string> names;
-    libdnf::DependencyContainer nameDependencies{sack};
-    libdnf::Nevra nevra;
-    for (const auto &rpm : includeNEVRAs) {
-        if (nevra.parse(rpm.c_str(), HY_FORM_NEVRA)) {
-            names.push_back(nevra.getName());
-            nameDependencies.addReldep(nevra.getName().c_str());
+    Pool * pool = dnf_sack_get_pool(sack);
+
+    std::vector<ModuleArtifactId> includeNEVRAs;
+    std::vector<ModuleArtifactId> excludeNEVRAs;
+    std::vector<Id> names;
+    // TODO use Goal::listInstalls() to not requires filtering out Platform
+    for (const auto & artifact : getModuleArtifactIndex(sack, moduleContainer)) {
+        bool complete = artifact.evr && artifact.arch;
+        if (moduleContainer.isModuleActive(artifact.module)) {
+            names.push_back(artifact.name);
+            if (complete)
+                includeNEVRAs.push_back(artifact);
+        } else if (complete) {
+            excludeNEVRAs.push_back(artifact);
+        }
+    }
+    std::sort(includeNEVRAs.begin(), includeNEVRAs.end(), moduleArtifactNevraLess);
+    std::sort(excludeNEVRAs.begin(), excludeNEVRAs.end(), moduleArtifactNevraLess);
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    // Packages from @System, @commandline and module_hotfixes repositories are never excluded
+    std::vector<bool> excludableRepos(pool->nrepos, true);
+    Id repoId;
+    Repo * repo;
+    FOR_REPOS(repoId, repo) {
+        if (strcmp(repo->name, HY_CMDLINE_REPO_NAME) == 0 ||
+            strcmp(repo->name, HY_SYSTEM_REPO_NAME) == 0) {
+            excludableRepos[repoId] = false;
+            continue;
+        }
+        for (auto hotfixRepo = hotfixRepos; hotfixRepo && *hotfixRepo; ++hotfixRepo) {
+            if (strcmp(repo->name, *hotfixRepo) == 0) {
+                excludableRepos[repoId] = false;
+                break;
+            }
         }
     }
 
-    std::vector<const char *> namesCString(names.size() + 1);
-    std::vector<const char *> excludeNEVRAsCString(excludeNEVRAs.size() + 1);
-    std::vector<const char *> includeNEVRAsCString(includeNEVRAs.size() + 1);
-
-    transform(names.begin(), names.end(), namesCString.begin(), std::mem_fn(&std::string::c_str));
-    transform(excludeNEVRAs.begin(), excludeNEVRAs.end(), excludeNEVRAsCString.begin(),
-              std::mem_fn(&std::string::c_str));
-    transform(includeNEVRAs.begin(), includeNEVRAs.end(), includeNEVRAsCString.begin(),
-              std::mem_fn(&std::string::c_str));
-
-    libdnf::Query keepPackages{sack};
-    const char *keepRepo[] = {HY_CMDLINE_REPO_NAME, HY_SYSTEM_REPO_NAME, nullptr};
-    keepPackages.addFilter(HY_PKG_REPONAME, HY_NEQ, keepRepo);
-    keepPackages.addFilter(HY_PKG_REPONAME, HY_NEQ, hotfixRepos);
-
-    libdnf::Query includeQuery{sack};
-    libdnf::Query excludeQuery{keepPackages};
-    libdnf::Query excludeProvidesQuery{keepPackages};
-    libdnf::Query excludeNamesQuery(keepPackages);
-    includeQuery.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, includeNEVRAsCString.data());
+    libdnf::Query allPackages{sack};
+    auto allPset = allPackages.getResultPset();
+    libdnf::PackageSet includes(sack);
+    libdnf::PackageSet excludes(sack);
 
-    excludeQuery.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, excludeNEVRAsCString.data());
-    excludeQuery.queryDifference(includeQuery);
+    Id id = -1;
+    while ((id = allPset->next(id)) != -1) {
+        Solvable * s = pool_id2solvable(pool, id);
+        if (moduleArtifactsHaveSolvable(includeNEVRAs, s)) {
+            includes.set(id);
+            continue;
+        }
+        if (!excludableRepos[s->repo->repoid])
+            continue;
+        // Names are requred to filtrate out source packages and packages with incompatible
+        // architectures
+        if (moduleArtifactsHaveSolvable(excludeNEVRAs, s) ||
+            std::binary_search(names.begin(), names.end(), s->name)) {
+            excludes.set(id);
+        }
+    }
 
     // Exclude packages by their Provides
-    excludeProvidesQuery.addFilter(HY_PKG_PROVIDES, &nameDependencies);
-    excludeProvidesQuery.queryDifference(includeQuery);
-
-    // Requred to filtrate out source packages and packages with incompatible architectures
-    excludeNamesQuery.addFilter(HY_PKG_NAME, HY_EQ, namesCString.data());
-    excludeNamesQuery.queryDifference(includeQuery);
+    dnf_sack_make_provides_ready(sack);
+    for (Id name : names) {
+        Id p, pp;
+        FOR_PROVIDES(p, pp, name) {
+            if (allPset->has(p) && !includes.has(p)
+                && excludableRepos[pool_id2solvable(pool, p)->repo->repoid]) {
+                excludes.set(p);
+            }
+        }
+    }
 
-    dnf_sack_set_module_excludes(sack, excludeQuery.getResultPset());
-    dnf_sack_add_module_excludes(sack, excludeProvidesQuery.getResultPset());
-    dnf_sack_add_module_excludes(sack, excludeNamesQuery.getResultPset());
-    dnf_sack_set_module_includes(sack, includeQuery.getResultPset());
+    dnf_sack_set_module_excludes(sack, &excludes);
+    dnf_sack_set_module_includes(sack, &includes);
 }
 
 }
@@ -2395,6 +3623,7 @@ std::pair<std::vector<std::vector<std::string>>, libdnf::ModulePackageContainer:
         }
         readModuleMetadataFromRepo(sack, moduleContainer, platformModule);
         moduleContainer->addDefaultsFromDisk();
+        priv->module_generation++;
 
         try {
             moduleContainer->moduleDefaultsResolve();
@@ -2408,47 +3637,126 @@ std::pair<std::vector<std::vector<std::string>>, libdnf::ModulePackageContainer:
         throw std::runtime_error("ModuleContainer not provided");
     }
     auto ret = moduleContainer->resolveActiveModulePackages(debugSolver);
-    auto nevraTuple = collectNevraForInclusionExclusion(*moduleContainer);
 
-    setModuleExcludes(sack, hotfixRepos, std::get<0>(nevraTuple), std::get<1>(nevraTuple));
+    // Module excludes depend only on the set of active modules, on the hotfix repositories and on
+    // the packages in the sack. When none of them changed the previous result is still valid.
+    // Containers are told apart by module_generation, which is bumped whenever a container is set
+    // or filled, and not by their address, which a new container may share with a freed one.
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    if (moduleContainer != priv->module_excludes_container) {
+        priv->module_generation++;
+    }
+    std::string hotfixes;
+    for (auto repo = hotfixRepos; repo && *repo; ++repo) {
+        hotfixes.append(*repo).push_back('\n');
+    }
+    auto activation = moduleContainer->getActivationGeneration();
+    if (updateOnly && priv->module_excludes_valid
+        && priv->module_excludes_module_generation == priv->module_generation
+        && priv->module_excludes_activation == activation
+        && hotfixes == priv->module_excludes_hotfixes) {
+        return ret;
+    }
+
+    setModuleExcludes(sack, hotfixRepos, *moduleContainer);
+
+    priv->module_excludes_valid = TRUE;
+    priv->module_excludes_container = moduleContainer;
+    priv->module_excludes_module_generation = priv->module_generation;
+    priv->module_excludes_activation = activation;
+    g_free(priv->module_excludes_hotfixes);
+    priv->module_excludes_hotfixes = g_strdup(hotfixes.c_str());
     return ret;
 }
 
 std::string dnf_sack_get_rpmdb_version(DnfSack *sack) {
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+
+    // the version changes only when @System is loaded again
+    if (priv->rpmdb_version && priv->rpmdb_version_generation == priv->system_repo_generation)
+        return priv->rpmdb_version;
+
     // collect all sha1hdr checksums
     // they are sufficiently unique IDs that represent installed RPMs
+    // the binary checksums are read directly, hex strings are needed only for non-SHA1 ones
+    std::vector<std::array<unsigned char, SHA_DIGEST_LENGTH>> sha1Checksums;
     std::vector<std::string> checksums;
+    size_t count = 0;
+    bool onlySha1 = true;
 
     // iterate all @System repo RPMs (rpmdb records)
     libdnf::Query query{sack, libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES};
     query.addFilter(HY_PKG_REPONAME, HY_EQ, HY_SYSTEM_REPO_NAME);
 
     auto pset = query.getResultPset();
+    if (pool->installed)
+        repo_internalize_trigger(pool->installed);
+    sha1Checksums.reserve(pset->size());
     Id id = -1;
     while(true) {
         id = pset->next(id);
         if (id == -1) {
             break;
         }
-        DnfPackage *pkg = dnf_package_new(sack, id);
-        // store pkgid (equals to sha1hdr)
-        checksums.push_back(libdnf::string::fromCstring(dnf_package_get_pkgid(pkg)));
-        g_object_unref(pkg);
+        ++count;
+        Id type;
+        auto checksum = solvable_lookup_bin_checksum(pool_id2solvable(pool, id), SOLVABLE_HDRID, &type);
+        // a package without the checksum is only counted, it is an empty string in the hash
+        if (!checksum || solv_chksum_len(type) == 0) {
+            continue;
+        }
+        if (type != REPOKEY_TYPE_SHA1) {
+            onlySha1 = false;
+            break;
+        }
+        sha1Checksums.emplace_back();
+        std::copy(checksum, checksum + SHA_DIGEST_LENGTH, sha1Checksums.back().begin());
     }
 
-    // sort checksums to compute the output checksum always the same
+    if (!onlySha1) {
+        // store pkgid (equals to sha1hdr) of all packages as hex strings
+        sha1Checksums.clear();
+        count = 0;
+        id = -1;
+        while ((id = pset->next(id)) != -1) {
+            ++count;
+            Id type;
+            auto checksum = solvable_lookup_bin_checksum(pool_id2solvable(pool, id), SOLVABLE_HDRID, &type);
+            int length = checksum ? solv_chksum_len(type) : 0;
+            if (length == 0) {
+                continue;
+            }
+            std::string hex(2 * length + 1, '\0');
+            solv_bin2hex(checksum, length, &hex[0]);
+            hex.pop_back();
+            checksums.push_back(std::move(hex));
+        }
+    }
+
+    // sort checksums to compute the output checksum always the same,
+    // the binary order equals to the order of the hex strings
+    std::sort(sha1Checksums.begin(), sha1Checksums.end());
     std::sort(checksums.begin(), checksums.end());
 
     SHA1Hash h;
+    char hex[2 * SHA_DIGEST_LENGTH + 1];
+    for (auto & checksum : sha1Checksums) {
+        solv_bin2hex(checksum.data(), SHA_DIGEST_LENGTH, hex);
+        h.update(hex);
+    }
     for (auto & checksum : checksums) {
         h.update(checksum.c_str());
     }
 
     // build <count>:<hash> output
     std::ostringstream result;
-    result << checksums.size();
+    result << count;
     result << ":";
     result << h.hexdigest();
 
+    g_free(priv->rpmdb_version);
+    priv->rpmdb_version = g_strdup(result.str().c_str());
+    priv->rpmdb_version_generation = priv->system_repo_generation;
     return result.str();
 }
@@ -72,6 +72,9 @@ typedef enum {
  * @DNF_SACK_LOAD_FLAG_USE_PRESTO:              Use presto deltas metadata
  * @DNF_SACK_LOAD_FLAG_USE_UPDATEINFO:          Use updateinfo metadata
  * @DNF_SACK_LOAD_FLAG_USE_OTHER:               Use other metadata
+ * @DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC:       Publish the built solv cache in background, see dnf_sack_wait_cache_writes()
+ * @DNF_SACK_LOAD_FLAG_LAZY_FILELISTS:          Load the filelists metadata only when files missing in primary are needed, requires a valid filelists cache, they are loaded at once otherwise
+ * @DNF_SACK_LOAD_FLAG_COMPACT:                 Cache summaries, descriptions, ... apart and load them only when needed
  *
  * Flags to use when loading from the sack.
  **/
@@ -82,6 +85,9 @@ typedef enum {
     DNF_SACK_LOAD_FLAG_USE_PRESTO           = 1 << 2,
     DNF_SACK_LOAD_FLAG_USE_UPDATEINFO       = 1 << 3,
     DNF_SACK_LOAD_FLAG_USE_OTHER            = 1 << 4,
+    DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC    = 1 << 5,
+    DNF_SACK_LOAD_FLAG_LAZY_FILELISTS       = 1 << 6,
+    DNF_SACK_LOAD_FLAG_COMPACT              = 1 << 7,
     /*< private >*/
     DNF_SACK_LOAD_FLAG_LAST
 } DnfSackLoadFlags;
@@ -160,10 +166,14 @@ gboolean     dnf_sack_load_system_repo      (DnfSack        *sack,
                                              HyRepo          a_hrepo,
                                              int             flags,
                                              GError        **error);
+gboolean     dnf_sack_refresh_system_repo   (DnfSack        *sack,
+                                             GError        **error);
 gboolean     dnf_sack_load_repo             (DnfSack        *sack,
                                              HyRepo          hrepo,
                                              int             flags,
                                              GError        **error);
+gboolean     dnf_sack_wait_cache_writes     (DnfSack        *sack,
+                                             GError        **error);
 Pool        *dnf_sack_get_pool              (DnfSack    *sack);
 
 void dnf_sack_filter_modules(DnfSack *sack, GPtrArray *repos, const char *install_root,
@@ -180,6 +190,8 @@ void dnf_sack_filter_modules(DnfSack *sack, GPtrArray *repos, const char *instal
  * @DNF_SACK_ADD_FLAG_REMOTE:                   Use remote repos
  * @DNF_SACK_ADD_FLAG_UNAVAILABLE:              Add repos that are unavailable
  * @DNF_SACK_ADD_FLAG_OTHER:                    Add the other
+ * @DNF_SACK_ADD_FLAG_PRESTO:                   Add the presto deltas
+ * @DNF_SACK_ADD_FLAG_COMPACT:                  Load descriptive package attributes only when used
  *
  * Flags to control repo loading into the sack.
  **/
@@ -190,6 +202,8 @@ typedef enum {
         DNF_SACK_ADD_FLAG_REMOTE                = 1 << 2,
         DNF_SACK_ADD_FLAG_UNAVAILABLE           = 1 << 3,
         DNF_SACK_ADD_FLAG_OTHER                 = 1 << 4,
+        DNF_SACK_ADD_FLAG_PRESTO                = 1 << 5,
+        DNF_SACK_ADD_FLAG_COMPACT               = 1 << 6,
         /*< private >*/
         DNF_SACK_ADD_FLAG_LAST
 } DnfSackAddFlags;
@@ -32,12 +32,15 @@
 #include <rpm/rpmlog.h>
 #include <rpm/rpmts.h>
 
+#include <vector>
+
 #include "catch-error.hpp"
 #include "log.hpp"
 #include "tinyformat/tinyformat.hpp"
 #include "dnf-context.hpp"
 #include "dnf-goal.h"
 #include "dnf-keyring.h"
+#include "dnf-keyring-private.hpp"
 #include "dnf-package.h"
 #include "dnf-rpmts-private.hpp"
 #include "dnf-sack.h"
@@ -354,18 +357,16 @@ dnf_transaction_ensure_repo_list(DnfTransaction *transaction, GPtrArray *pkglist
     return TRUE;
 } CATCH_TO_GERROR(FALSE)
 
-gboolean
-dnf_transaction_gpgcheck_package(DnfTransaction *transaction, DnfPackage *pkg, GError **error) try
+/* returns the downloaded file of the package or %NULL if it is missing */
+static const gchar *
+dnf_transaction_gpgcheck_get_filename(DnfTransaction *transaction, DnfPackage *pkg, GError **error)
 {
-    DnfTransactionPrivate *priv = GET_PRIVATE(transaction);
-    GError *error_local = NULL;
-    DnfRepo *repo;
     const gchar *fn;
 
     /* ensure the filename is set */
     if (!dnf_transaction_ensure_repo(transaction, pkg, error)) {
         g_prefix_error(error, _("Failed to check untrusted: "));
-        return FALSE;
+        return NULL;
     }
 
     /* find the location of the local file */
@@ -376,58 +377,207 @@ dnf_transaction_gpgcheck_package(DnfTransaction *transaction, DnfPackage *pkg, G
                     DNF_ERROR_FILE_NOT_FOUND,
                     _("Downloaded file for %s not found"),
                     dnf_package_get_name(pkg));
+        return NULL;
+    }
+    return fn;
+}
+
+/* decides if the result of the file check is fatal, takes ownership of @error_local */
+static gboolean
+dnf_transaction_gpgcheck_result(DnfTransaction *transaction,
+                                DnfPackage *pkg,
+                                GError *error_local,
+                                GError **error)
+{
+    DnfTransactionPrivate *priv = GET_PRIVATE(transaction);
+    DnfRepo *repo;
+
+    if (error_local == NULL)
+        return TRUE;
+
+    /* probably an i/o error */
+    if (!g_error_matches(error_local, DNF_ERROR, DNF_ERROR_GPG_SIGNATURE_INVALID)) {
+        g_propagate_error(error, error_local);
+        return FALSE;
+    }
+
+    /* if the repo is signed this is ALWAYS an error */
+    repo = dnf_package_get_repo(pkg);
+    if (repo != NULL && dnf_repo_get_gpgcheck(repo)) {
+        g_set_error(error,
+                    DNF_ERROR,
+                    DNF_ERROR_FILE_INVALID,
+                    _("package %1$s cannot be verified "
+                      "and repo %2$s is GPG enabled: %3$s"),
+                    dnf_package_get_nevra(pkg),
+                    dnf_repo_get_id(repo),
+                    error_local->message);
+        g_error_free(error_local);
+        return FALSE;
+    }
+
+    /* we can only install signed packages in this mode */
+    if ((priv->flags & DNF_TRANSACTION_FLAG_ONLY_TRUSTED) > 0) {
+        g_propagate_error(error, error_local);
         return FALSE;
     }
+    g_error_free(error_local);
+    return TRUE;
+}
+
+gboolean
+dnf_transaction_gpgcheck_package(DnfTransaction *transaction, DnfPackage *pkg, GError **error) try
+{
+    DnfTransactionPrivate *priv = GET_PRIVATE(transaction);
+    GError *error_local = NULL;
+    const gchar *fn;
+
+    fn = dnf_transaction_gpgcheck_get_filename(transaction, pkg, error);
+    if (fn == NULL)
+        return FALSE;
 
     /* check file */
-    if (!dnf_keyring_check_untrusted_file(priv->keyring, fn, &error_local)) {
+    dnf_keyring_check_untrusted_file(priv->keyring, fn, &error_local);
+    return dnf_transaction_gpgcheck_result(transaction, pkg, error_local, error);
+} CATCH_TO_GERROR(FALSE)
 
-        /* probably an i/o error */
-        if (!g_error_matches(error_local, DNF_ERROR, DNF_ERROR_GPG_SIGNATURE_INVALID)) {
-            g_propagate_error(error, error_local);
-            return FALSE;
-        }
+/* maximal number of packages checked at once by dnf_transaction_gpgcheck_packages() */
+#define DNF_TRANSACTION_GPGCHECK_THREADS_MAX  4
 
-        /* if the repo is signed this is ALWAYS an error */
-        repo = dnf_package_get_repo(pkg);
-        if (repo != NULL && dnf_repo_get_gpgcheck(repo)) {
-            g_set_error(error,
-                        DNF_ERROR,
-                        DNF_ERROR_FILE_INVALID,
-                        _("package %1$s cannot be verified "
-                          "and repo %2$s is GPG enabled: %3$s"),
-                        dnf_package_get_nevra(pkg),
-                        dnf_repo_get_id(repo),
-                        error_local->message);
-            g_error_free(error_local);
-            return FALSE;
+/* a file checked by the gpgcheck workers */
+typedef struct {
+    const gchar *filename;
+    GError *error;
+} DnfTransactionGpgcheckItem;
+
+/* shared by the gpgcheck workers, each worker takes the next unchecked item */
+typedef struct {
+    rpmKeyring keyring;
+    DnfTransactionGpgcheckItem *items;
+    gint n_items;
+    gint next;      /* atomic */
+    gint checked;   /* protected by mutex */
+    GMutex mutex;
+    GCond cond;
+} DnfTransactionGpgcheckJob;
+
+static gpointer
+dnf_transaction_gpgcheck_worker(gpointer user_data)
+{
+    auto job = static_cast<DnfTransactionGpgcheckJob *>(user_data);
+
+    /* the keyring is shared, the transaction set is private to the worker */
+    rpmKeyring keyring = rpmKeyringLink(job->keyring);
+    rpmts ts = rpmtsCreate();
+    while (true) {
+        gint i = g_atomic_int_add(&job->next, 1);
+        if (i >= job->n_items)
+            break;
+        auto item = &job->items[i];
+        dnf_keyring_check_untrusted_file_with_ts(ts, keyring, item->filename, &item->error);
+
+        g_mutex_lock(&job->mutex);
+        job->checked++;
+        g_cond_signal(&job->cond);
+        g_mutex_unlock(&job->mutex);
+    }
+    rpmtsFree(ts);
+    rpmKeyringFree(keyring);
+    return NULL;
+}
+
+/* checks the files of @pkglist in parallel, the first failure in the order of @pkglist is reported */
+static gboolean
+dnf_transaction_gpgcheck_packages(DnfTransaction *transaction,
+                                  GPtrArray *pkglist,
+                                  DnfState *state,
+                                  GError **error)
+{
+    DnfTransactionPrivate *priv = GET_PRIVATE(transaction);
+    DnfTransactionGpgcheckJob job;
+    GError *filename_error = NULL;
+    gboolean ret = TRUE;
+    gint reported = 0;
+    guint n_items;
+    guint n_workers;
+
+    if (state != NULL)
+        dnf_state_set_number_steps(state, pkglist->len);
+
+    /* the sack is not thread-safe, resolve the files in advance; like in a serial
+     * check, a missing file is reported only if the packages before it pass */
+    std::vector<DnfTransactionGpgcheckItem> items;
+    for (n_items = 0; n_items < pkglist->len; n_items++) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(pkglist, n_items));
+        auto filename = dnf_transaction_gpgcheck_get_filename(transaction, pkg, &filename_error);
+        if (filename == NULL)
+            break;
+        items.push_back({filename, NULL});
+    }
+
+    job.keyring = priv->keyring;
+    job.items = items.data();
+    job.n_items = n_items;
+    job.next = 0;
+    job.checked = 0;
+    g_mutex_init(&job.mutex);
+    g_cond_init(&job.cond);
+
+    n_workers = MIN(MIN(g_get_num_processors(), DNF_TRANSACTION_GPGCHECK_THREADS_MAX), n_items);
+    std::vector<GThread *> workers;
+    for (guint i = 0; i < n_workers; i++)
+        workers.push_back(g_thread_new("gpgcheck", dnf_transaction_gpgcheck_worker, &job));
+
+    /* report progress from this thread, DnfState is not thread-safe */
+    g_mutex_lock(&job.mutex);
+    while (reported < job.n_items) {
+        while (job.checked == reported)
+            g_cond_wait(&job.cond, &job.mutex);
+        gint checked = job.checked;
+        g_mutex_unlock(&job.mutex);
+        for (; reported < checked; reported++) {
+            if (ret && state != NULL && !dnf_state_done(state, error)) {
+                /* cancelled, let the workers finish after their current file */
+                g_atomic_int_set(&job.next, job.n_items);
+                ret = FALSE;
+            }
         }
+        g_mutex_lock(&job.mutex);
+        if (!ret)
+            break;
+    }
+    g_mutex_unlock(&job.mutex);
 
-        /* we can only install signed packages in this mode */
-        if ((priv->flags & DNF_TRANSACTION_FLAG_ONLY_TRUSTED) > 0) {
-            g_propagate_error(error, error_local);
+    for (auto worker : workers)
+        g_thread_join(worker);
+    g_mutex_clear(&job.mutex);
+    g_cond_clear(&job.cond);
+
+    for (guint i = 0; i < n_items; i++) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(pkglist, i));
+        if (!ret) {
+            g_clear_error(&items[i].error);
+            continue;
+        }
+        ret = dnf_transaction_gpgcheck_result(transaction, pkg, items[i].error, error);
+    }
+    if (filename_error != NULL) {
+        if (ret) {
+            g_propagate_error(error, filename_error);
             return FALSE;
-        } else {
-            g_clear_error(&error_local);
         }
+        g_error_free(filename_error);
     }
+    return ret;
+}
 
-    return TRUE;
-} CATCH_TO_GERROR(FALSE)
-
-/**
- * dnf_transaction_check_untrusted:
- * @transaction: Transaction
- * @goal: Target goal
- * @error: Error
- *
- * Verify GPG signatures for all pending packages to be changed as part
- * of @goal.
- */
-gboolean
-dnf_transaction_check_untrusted(DnfTransaction *transaction, HyGoal goal, GError **error) try
+/* like dnf_transaction_check_untrusted(), reporting progress to @state if set */
+static gboolean
+dnf_transaction_check_untrusted_with_state(DnfTransaction *transaction,
+                                           HyGoal goal,
+                                           DnfState *state,
+                                           GError **error)
 {
-    guint i;
     g_autoptr(GPtrArray) install = NULL;
 
     /* find a list of all the packages we might have to download */
@@ -441,13 +591,22 @@ dnf_transaction_check_untrusted(DnfTransaction *transaction, HyGoal goal, GError
         return TRUE;
 
     /* find any packages in untrusted repos */
-    for (i = 0; i < install->len; i++) {
-        auto pkg = static_cast< DnfPackage * >(g_ptr_array_index(install, i));
+    return dnf_transaction_gpgcheck_packages(transaction, install, state, error);
+}
 
-        if (!dnf_transaction_gpgcheck_package(transaction, pkg, error))
-            return FALSE;
-    }
-    return TRUE;
+/**
+ * dnf_transaction_check_untrusted:
+ * @transaction: Transaction
+ * @goal: Target goal
+ * @error: Error
+ *
+ * Verify GPG signatures for all pending packages to be changed as part
+ * of @goal.
+ */
+gboolean
+dnf_transaction_check_untrusted(DnfTransaction *transaction, HyGoal goal, GError **error) try
+{
+    return dnf_transaction_check_untrusted_with_state(transaction, goal, NULL, error);
 } CATCH_TO_GERROR(FALSE)
 
 /**
@@ -984,8 +1143,8 @@ gboolean
 dnf_transaction_depsolve(DnfTransaction *transaction, HyGoal goal, DnfState *state, GError **error) try
 {
     DnfTransactionPrivate *priv = GET_PRIVATE(transaction);
-    gboolean valid;
     g_autoptr(GPtrArray) packages = NULL;
+    g_autoptr(GPtrArray) downloaded = g_ptr_array_new();
 
     /* depsolve */
     if (!priv->dont_solve_goal) {
@@ -1014,14 +1173,18 @@ dnf_transaction_depsolve(DnfTransaction *transaction, HyGoal goal, DnfState *sta
         if (g_strcmp0(dnf_package_get_reponame(pkg), HY_CMDLINE_REPO_NAME) == 0) {
             continue;
         }
+        g_ptr_array_add(downloaded, pkg);
+    }
 
-        /* check package exists and checksum is okay */
-        if (!dnf_package_check_filename(pkg, &valid, error))
-            return FALSE;
+    /* check packages exist and checksums are okay */
+    std::vector<gboolean> valid(downloaded->len);
+    if (!dnf_package_array_check_filename(downloaded, valid.data(), error))
+        return FALSE;
 
-        /* package needs to be downloaded */
-        if (!valid) {
-            g_ptr_array_add(priv->pkgs_to_download, g_object_ref(pkg));
+    /* packages that need to be downloaded */
+    for (guint i = 0; i < downloaded->len; i++) {
+        if (!valid[i]) {
+            g_ptr_array_add(priv->pkgs_to_download, g_object_ref(g_ptr_array_index(downloaded, i)));
         }
     }
     return TRUE;
@@ -1150,18 +1313,20 @@ dnf_transaction_commit(DnfTransaction *transaction, HyGoal goal, DnfState *state
     if (priv->flags & DNF_TRANSACTION_FLAG_TEST) {
         ret = dnf_state_set_steps(state,
                                   error,
+                                  1,  /* check untrusted */
                                   2,  /* install */
                                   2,  /* remove */
                                   10, /* test-commit */
-                                  86, /* commit */
+                                  85, /* commit */
                                   -1);
     } else {
         ret = dnf_state_set_steps(state,
                                   error,
+                                  1,  /* check untrusted */
                                   2,  /* install */
                                   2,  /* remove */
                                   10, /* test-commit */
-                                  83, /* commit */
+                                  82, /* commit */
                                   1,  /* write yumDB */
                                   2,  /* delete files */
                                   -1);
@@ -1174,7 +1339,13 @@ dnf_transaction_commit(DnfTransaction *transaction, HyGoal goal, DnfState *state
         goto out;
 
     /* find any packages without valid GPG signatures */
-    ret = dnf_transaction_check_untrusted(transaction, goal, error);
+    state_local = dnf_state_get_child(state);
+    ret = dnf_transaction_check_untrusted_with_state(transaction, goal, state_local, error);
+    if (!ret)
+        goto out;
+
+    /* this section done */
+    ret = dnf_state_done(state, error);
     if (!ret)
         goto out;
 
@@ -1553,7 +1724,7 @@ dnf_transaction_new(DnfContext *context)
     } else {
         dbPath = ":memory:";
     }
-    priv->swdb = new libdnf::Swdb(dbPath);
+    priv->swdb = new libdnf::Swdb(dbPath, libdnf::getGlobalMainConfig().history_relaxed_sync().getValue());
     priv->context = context;
     g_object_add_weak_pointer(G_OBJECT(priv->context), (void **)&priv->context);
     priv->ts = rpmtsCreate();
@@ -295,6 +295,7 @@ filterFileToJob(DnfSack *sack, const Filter *f, Queue *job)
 
     const char *file = matches[0].str;
     Pool *pool = dnf_sack_get_pool(sack);
+    dnf_sack_load_lazy_filelists_for(sack, file, f->getCmpType());
 
     int flags = f->getCmpType() & HY_GLOB ? SELECTION_GLOB : 0;
     if (f->getCmpType() & HY_GLOB)
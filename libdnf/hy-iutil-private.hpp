@@ -25,6 +25,9 @@
 #include "hy-types.h"
 #include "sack/packageset.hpp"
 
+#include <sys/types.h>
+#include <vector>
+
 /* crypto utils */
 int checksum_cmp(const unsigned char *cs1, const unsigned char *cs2);
 int checksum_fp(unsigned char *out, FILE *fp);
@@ -40,6 +43,7 @@ const char *id2nevra(Pool *pool, Id id);
 char *abspath(const char *path);
 int is_readable_rpm(const char *fn);
 int mkcachedir(char *path);
+mode_t get_umask(void);
 gboolean mv(const char *old_path, const char *new_path, GError **error);
 gboolean dnf_remove_recursive_v2(const gchar *path, GError **error);
 gboolean dnf_copy_file(const std::string & srcPath, const std::string & dstPath, GError ** error);
@@ -55,8 +59,8 @@ Id running_kernel(DnfSack *sack);
 Repo *repo_by_name(DnfSack *sack, const char *name);
 HyRepo hrepo_by_name(DnfSack *sack, const char *name);
 Id str2archid(Pool *pool, const char *s);
-Id what_upgrades(Pool *pool, Id p);
-Id what_downgrades(Pool *pool, Id p);
+Id what_upgrades(Pool *pool, Id p, const std::vector<int> & evrRanks);
+Id what_downgrades(Pool *pool, Id p, const std::vector<int> & evrRanks);
 Map *free_map_fully(Map *m);
 int is_package(const Pool *pool, const Solvable *s);
 
@@ -69,7 +69,7 @@ extern "C" {
 #define CHKSUM_IDENT "H000"
 #define CACHEDIR_PERMISSIONS 0700
 
-static mode_t
+mode_t
 get_umask(void)
 {
     mode_t mask = umask(0);
@@ -548,9 +548,10 @@ str2archid(Pool *pool, const char *arch)
  *    installed version, e.g kernel).
  *
  * Or 0 if none such package is installed.
+ * Versions are compared by evrRanks from dnf_sack_get_evr_ranks().
  */
 Id
-what_upgrades(Pool *pool, Id pkg)
+what_upgrades(Pool *pool, Id pkg, const std::vector<int> & evrRanks)
 {
     Id l = 0, l_evr = 0;
     Id p, pp;
@@ -567,11 +568,11 @@ what_upgrades(Pool *pool, Id pkg)
             updated->arch != ARCH_NOARCH &&
             s->arch != ARCH_NOARCH)
             continue;
-        if (pool_evrcmp(pool, updated->evr, s->evr, EVRCMP_COMPARE) >= 0)
+        if (evrRanks[updated->evr] >= evrRanks[s->evr])
             // >= version installed, this pkg can not be used for upgrade
             return 0;
         if (l == 0 ||
-            pool_evrcmp(pool, updated->evr, l_evr, EVRCMP_COMPARE) > 0) {
+            evrRanks[updated->evr] > evrRanks[l_evr]) {
             l = p;
             l_evr = updated->evr;
         }
@@ -591,9 +592,10 @@ what_upgrades(Pool *pool, Id pkg)
  *    installed)
  *
  * Or 0 if none such package is installed.
+ * Versions are compared by evrRanks from dnf_sack_get_evr_ranks().
  */
 Id
-what_downgrades(Pool *pool, Id pkg)
+what_downgrades(Pool *pool, Id pkg, const std::vector<int> & evrRanks)
 {
     Id l = 0, l_evr = 0;
     Id p, pp;
@@ -607,11 +609,11 @@ what_downgrades(Pool *pool, Id pkg)
             updated->name != s->name ||
             updated->arch != s->arch)
             continue;
-        if (pool_evrcmp(pool, updated->evr, s->evr, EVRCMP_COMPARE) <= 0)
+        if (evrRanks[updated->evr] <= evrRanks[s->evr])
             // <= version installed, this pkg can not be used for downgrade
             return 0;
         if (l == 0 ||
-            pool_evrcmp(pool, updated->evr, l_evr, EVRCMP_COMPARE) < 0) {
+            evrRanks[updated->evr] < evrRanks[l_evr]) {
             l = p;
             l_evr = updated->evr;
         }
@@ -115,6 +115,15 @@ get_solvable(DnfPackage *pkg)
     return pool_id2solvable(dnf_package_get_pool(pkg), priv->id);
 }
 
+/* descriptive attributes of repos loaded with DNF_SACK_LOAD_FLAG_COMPACT are loaded on demand */
+static Solvable *
+get_described_solvable(DnfPackage *pkg)
+{
+    Solvable *s = get_solvable(pkg);
+    dnf_sack_load_lazy_descriptions(dnf_package_get_sack(pkg), s->repo);
+    return s;
+}
+
 /**
  * dnf_package_get_pool: (skip)
  * @pkg: a #DnfPackage instance.
@@ -431,7 +440,7 @@ dnf_package_get_name(DnfPackage *pkg)
 const char *
 dnf_package_get_packager(DnfPackage *pkg)
 {
-    return solvable_lookup_str(get_solvable(pkg), SOLVABLE_PACKAGER);
+    return solvable_lookup_str(get_described_solvable(pkg), SOLVABLE_PACKAGER);
 }
 
 /**
@@ -511,7 +520,7 @@ dnf_package_get_hdr_chksum(DnfPackage *pkg, int *type)
 const char *
 dnf_package_get_description(DnfPackage *pkg)
 {
-    return solvable_lookup_str(get_solvable(pkg), SOLVABLE_DESCRIPTION);
+    return solvable_lookup_str(get_described_solvable(pkg), SOLVABLE_DESCRIPTION);
 }
 
 /**
@@ -544,7 +553,7 @@ dnf_package_get_evr(DnfPackage *pkg)
 const char *
 dnf_package_get_group(DnfPackage *pkg)
 {
-  return solvable_lookup_str(get_solvable(pkg), SOLVABLE_GROUP);
+  return solvable_lookup_str(get_described_solvable(pkg), SOLVABLE_GROUP);
 }
 
 /**
@@ -560,7 +569,7 @@ dnf_package_get_group(DnfPackage *pkg)
 const char *
 dnf_package_get_license(DnfPackage *pkg)
 {
-    return solvable_lookup_str(get_solvable(pkg), SOLVABLE_LICENSE);
+    return solvable_lookup_str(get_described_solvable(pkg), SOLVABLE_LICENSE);
 }
 
 /**
@@ -593,7 +602,7 @@ dnf_package_get_reponame(DnfPackage *pkg)
 const char *
 dnf_package_get_summary(DnfPackage *pkg)
 {
-    Solvable *s = get_solvable(pkg);
+    Solvable *s = get_described_solvable(pkg);
     return solvable_lookup_str(s, SOLVABLE_SUMMARY);
 }
 
@@ -610,7 +619,7 @@ dnf_package_get_summary(DnfPackage *pkg)
 const char *
 dnf_package_get_url(DnfPackage *pkg)
 {
-    return solvable_lookup_str(get_solvable(pkg), SOLVABLE_URL);
+    return solvable_lookup_str(get_described_solvable(pkg), SOLVABLE_URL);
 }
 
 /**
@@ -966,6 +975,7 @@ dnf_package_get_files(DnfPackage *pkg)
     Dataiterator di;
     GPtrArray *ret = g_ptr_array_new();
 
+    dnf_sack_load_lazy_filelists(dnf_package_get_sack(pkg), s->repo);
     repo_internalize_trigger(s->repo);
     dataiterator_init(&di, pool, s->repo, priv->id, SOLVABLE_FILELIST, NULL,
                       SEARCH_FILES | SEARCH_COMPLETE_FILELIST);
@@ -38,9 +38,12 @@ enum _hy_repo_repodata {
 };
 
 int hy_repo_transition(HyRepo repo, enum _hy_repo_state new_state);
+/* adds a reference released by hy_repo_free() */
+HyRepo hy_repo_ref(HyRepo repo);
 
 void repo_internalize_all_trigger(Pool *pool);
 void repo_internalize_trigger(Repo *r);
+enum _hy_repo_state *repo_get_state(HyRepo repo, enum _hy_repo_repodata which);
 void repo_update_state(HyRepo repo, enum _hy_repo_repodata which,
                        enum _hy_repo_state state);
 Id repo_get_repodata(HyRepo repo, enum _hy_repo_repodata which);
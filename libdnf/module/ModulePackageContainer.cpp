@@ -148,6 +148,9 @@ public:
     ~Impl();
     std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType> moduleSolve(
         const std::vector<ModulePackage *> & modules, bool debugSolver);
+    bool isSolveUpToDate(const std::vector<ModulePackage *> & modules,
+        const std::vector<Id> & excludes) const;
+    void invalidateSolve() noexcept { lastSolve.valid = false; }
     bool insert(const std::string &moduleName, const char *path);
     std::vector<ModulePackage *> getLatestActiveEnabledModules();
 
@@ -158,6 +161,20 @@ private:
     std::map<Id, std::unique_ptr<ModulePackage>> modules;
     DnfSack * moduleSack;
     std::unique_ptr<PackageSet> activatedModules;
+    /// Incremented every time moduleSolve() is really performed
+    unsigned int activationGeneration{0};
+
+    /// Input and outcome of the last moduleSolve(). Used to skip the solver when neither
+    /// the requested modules nor the module sack changed since the previous resolution.
+    struct SolveState {
+        bool valid{false};
+        std::vector<std::pair<Id, bool>> request;
+        std::vector<Id> excludes;
+        std::vector<std::vector<std::string>> problems;
+        ModulePackageContainer::ModuleErrorType problemType{
+            ModulePackageContainer::ModuleErrorType::NO_ERROR};
+    };
+    SolveState lastSolve;
     std::string installRoot;
     std::string persistDir;
     ModuleMetadata moduleMetadata;
@@ -331,6 +348,9 @@ ModulePackageContainer::add(const std::string &fileContent, const std::string &
             g_autofree gchar * path = g_build_filename(pImpl->installRoot.c_str(),
                                                       "/etc/dnf/modules.d", NULL);
             std::vector<ModulePackage *> packages = md.getAllModulePackages(pImpl->moduleSack, r, repoID);
+            if (!packages.empty()) {
+                pImpl->invalidateSolve();
+            }
             for(auto const& modulePackagePtr: packages) {
                 std::unique_ptr<ModulePackage> modulePackage(modulePackagePtr);
                 pImpl->modules.insert(std::make_pair(modulePackage->getId(), std::move(modulePackage)));
@@ -346,6 +366,7 @@ Id
 ModulePackageContainer::addPlatformPackage(const std::string& osReleasePath,
     const char* platformModule)
 {
+    pImpl->invalidateSolve();
     return ModulePackage::createPlatformSolvable(pImpl->moduleSack, osReleasePath,
         pImpl->installRoot, platformModule);
 }
@@ -355,12 +376,14 @@ ModulePackageContainer::addPlatformPackage(DnfSack * sack,
     const std::vector<std::string> & osReleasePath,
     const char* platformModule)
 {
+    pImpl->invalidateSolve();
     return ModulePackage::createPlatformSolvable(sack, pImpl->moduleSack, osReleasePath,
         pImpl->installRoot, platformModule);
 }
 
 void ModulePackageContainer::createConflictsBetweenStreams()
 {
+    pImpl->invalidateSolve();
     // TODO Use Query for filtering
     for (const auto &iter : pImpl->modules) {
         const auto &modulePackage = iter.second;
@@ -605,6 +628,7 @@ std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleE
 ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & modules,
     bool debugSolver)
 {
+    ++activationGeneration;
     if (modules.empty()) {
         activatedModules.reset();
         return {};
@@ -613,6 +637,17 @@ ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & m
     dnf_sack_make_provides_ready(moduleSack);
     Goal goal(moduleSack);
     Goal goalWeak(moduleSack);
+    // Previous activation is used as a seed - the solver prefers already active modules, therefore
+    // only streams affected by the change of module states have to be really re-decided.
+    if (activatedModules) {
+        Id id = -1;
+        while ((id = activatedModules->next(id)) != -1) {
+            auto pkg = dnf_package_new(moduleSack, id);
+            goal.favor(pkg);
+            goalWeak.favor(pkg);
+            g_object_unref(pkg);
+        }
+    }
     for (const auto &module : modules) {
         std::ostringstream ss;
         auto name = module->getName();
@@ -657,6 +692,24 @@ ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & m
     return make_pair(problems, problemType);
 }
 
+bool
+ModulePackageContainer::Impl::isSolveUpToDate(const std::vector<ModulePackage *> & modules,
+    const std::vector<Id> & excludes) const
+{
+    if (!lastSolve.valid || lastSolve.excludes != excludes
+        || lastSolve.request.size() != modules.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < modules.size(); ++i) {
+        auto & request = lastSolve.request[i];
+        if (request.first != modules[i]->getId() ||
+            request.second != (persistor->getState(modules[i]->getName()) == ModuleState::DEFAULT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 std::vector<ModulePackage *>
 ModulePackageContainer::query(Nsvcap& moduleNevra)
 {
@@ -1012,7 +1065,6 @@ ModulePackageContainer::getLatestModulesPerRepo(ModuleState moduleFilter,
 std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType>
 ModulePackageContainer::resolveActiveModulePackages(bool debugSolver)
 {
-    dnf_sack_reset_excludes(pImpl->moduleSack);
     std::vector<ModulePackage *> packages;
 
     PackageSet excludes(pImpl->moduleSack);
@@ -1039,11 +1091,40 @@ ModulePackageContainer::resolveActiveModulePackages(bool debugSolver)
             }
         }
     }
+    std::vector<Id> excludeIds;
+    Id id = -1;
+    while ((id = excludes.next(id)) != -1) {
+        excludeIds.push_back(id);
+    }
+
+    // Nothing changed since the last resolution (and debug data are not requested) - the module
+    // sack still carries the excludes of the last run, so the previous activation is valid
+    auto & lastSolve = pImpl->lastSolve;
+    if (!debugSolver && pImpl->isSolveUpToDate(packages, excludeIds)) {
+        return make_pair(lastSolve.problems, lastSolve.problemType);
+    }
+
+    dnf_sack_reset_excludes(pImpl->moduleSack);
     dnf_sack_add_excludes(pImpl->moduleSack, &excludes);
     auto problems = pImpl->moduleSolve(packages, debugSolver);
+
+    lastSolve.valid = true;
+    lastSolve.request.clear();
+    for (auto module : packages) {
+        lastSolve.request.emplace_back(
+            module->getId(), pImpl->persistor->getState(module->getName()) == ModuleState::DEFAULT);
+    }
+    lastSolve.excludes = std::move(excludeIds);
+    lastSolve.problems = problems.first;
+    lastSolve.problemType = problems.second;
     return problems;
 }
 
+unsigned int ModulePackageContainer::getActivationGeneration() const noexcept
+{
+    return pImpl->activationGeneration;
+}
+
 bool ModulePackageContainer::isModuleActive(Id id)
 {
     if (pImpl->activatedModules) {
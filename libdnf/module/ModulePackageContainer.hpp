@@ -265,6 +265,12 @@ public:
         std::string version, std::string context, std::string arch);
     void enableDependencyTree(std::vector<ModulePackage *> & modulePackages);
     std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType> resolveActiveModulePackages(bool debugSolver);
+    /**
+    * @brief Return a counter that changes every time resolveActiveModulePackages() really
+    * recomputes the set of active modules. Results cached per active set can be reused while
+    * the counter stays the same.
+    */
+    unsigned int getActivationGeneration() const noexcept;
     bool isModuleActive(Id id);
     bool isModuleActive(const ModulePackage * modulePackage);
     void loadFailSafeData();
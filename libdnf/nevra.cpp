@@ -22,41 +22,147 @@
 #include "hy-nevra.h"
 #include "dnf-sack.h"
 
-#include "regex/regex.hpp"
+#include "utils/char-class.hpp"
 
 namespace libdnf {
 
-#define PKG_NAME "([^:(/=<> ]+)"
-#define PKG_EPOCH "(([0-9]+):)?"
-#define PKG_VERSION "([^-:(/=<> ]+)"
-#define PKG_RELEASE PKG_VERSION
-#define PKG_ARCH "([^-:.(/=<> ]+)"
+constexpr std::size_t NevraSplitter::NOT_FOUND;
 
-static const Regex NEVRA_FORM_REGEX[]{
-    Regex("^" PKG_NAME "-" PKG_EPOCH PKG_VERSION "-" PKG_RELEASE "\\." PKG_ARCH "$", REG_EXTENDED),
-    Regex("^" PKG_NAME "-" PKG_EPOCH PKG_VERSION "-" PKG_RELEASE          "()"  "$", REG_EXTENDED),
-    Regex("^" PKG_NAME "-" PKG_EPOCH PKG_VERSION        "()"              "()"  "$", REG_EXTENDED),
-    Regex("^" PKG_NAME      "()()"      "()"            "()"     "\\." PKG_ARCH "$", REG_EXTENDED),
-    Regex("^" PKG_NAME      "()()"      "()"            "()"              "()"  "$", REG_EXTENDED)
-};
+NevraSplitter::NevraSplitter(const char * nevraStr) noexcept
+: str(nevraStr), valid(true), epochDigits(false), colon(NOT_FOUND), colonDash(NOT_FOUND),
+  prevDash(NOT_FOUND), lastDash(NOT_FOUND), lastDot(NOT_FOUND)
+{
+    // Only digits since the last dash - candidate for epoch
+    bool digitsOnly = false;
+    std::size_t idx;
+    for (idx = 0; nevraStr[idx] != '\0'; ++idx) {
+        char c = nevraStr[idx];
+        if (charHasClass(c, CHAR_CLASS_NEVRA_INVALID)) {
+            valid = false;
+            break;
+        }
+        if (c == '-') {
+            prevDash = lastDash;
+            lastDash = idx;
+            digitsOnly = true;
+        } else if (c == '.') {
+            lastDot = idx;
+            digitsOnly = false;
+        } else if (c == ':') {
+            // any component can contain at most one colon - the epoch delimiter
+            if (colon != NOT_FOUND) {
+                valid = false;
+                break;
+            }
+            colon = idx;
+            colonDash = lastDash;
+            epochDigits = digitsOnly && lastDash != NOT_FOUND && idx > lastDash + 1;
+            digitsOnly = false;
+        } else if (!charHasClass(c, CHAR_CLASS_DIGIT)) {
+            digitsOnly = false;
+        }
+    }
+    len = idx;
+}
 
-bool Nevra::parse(const char * nevraStr, HyForm form)
+/// Tests "[epoch:]version" between the dash and the end (excluded)
+bool
+NevraSplitter::versionMatches(std::size_t dash, std::size_t end) const noexcept
+{
+    if (colon == NOT_FOUND)
+        return end > dash + 1;
+    return colonDash == dash && colon < end && epochDigits && end > colon + 1;
+}
+
+bool
+NevraSplitter::matches(HyForm form) const noexcept
 {
-    enum { NAME = 1, EPOCH = 3, VERSION = 4, RELEASE = 5, ARCH = 6, _LAST_ };
-    auto matchResult = NEVRA_FORM_REGEX[form - 1].match(nevraStr, false, _LAST_);
-    if (!matchResult.isMatched() || matchResult.getMatchedLen(NAME) == 0)
+    if (!valid || len == 0)
         return false;
-    name = matchResult.getMatchedString(NAME);
-    if (matchResult.getMatchedLen(EPOCH) > 0)
-        epoch = atoi(matchResult.getMatchedString(EPOCH).c_str());
-    else
-        epoch = EPOCH_NOT_SET;
-    version = matchResult.getMatchedString(VERSION);
-    release = matchResult.getMatchedString(RELEASE);
-    arch = matchResult.getMatchedString(ARCH);
+    switch (form) {
+        case HY_FORM_NEVRA:
+            return prevDash != NOT_FOUND && prevDash > 0 && versionMatches(prevDash, lastDash) &&
+                lastDot != NOT_FOUND && lastDot > lastDash + 1 && lastDot + 1 < len;
+        case HY_FORM_NEVR:
+            return prevDash != NOT_FOUND && prevDash > 0 && versionMatches(prevDash, lastDash) &&
+                lastDash + 1 < len;
+        case HY_FORM_NEV:
+            return lastDash != NOT_FOUND && lastDash > 0 && versionMatches(lastDash, len);
+        case HY_FORM_NA:
+            return colon == NOT_FOUND && lastDot != NOT_FOUND && lastDot > 0 &&
+                lastDot + 1 < len && (lastDash == NOT_FOUND || lastDash < lastDot);
+        case HY_FORM_NAME:
+            return colon == NOT_FOUND;
+        default:
+            return false;
+    }
+}
+
+bool
+NevraSplitter::split(HyForm form, Nevra & nevra) const
+{
+    if (!matches(form))
+        return false;
+
+    // components not present in the form are empty - they begin and end at the same position
+    std::size_t nameEnd = len;
+    std::size_t versionEnd = len;
+    std::size_t releaseEnd = len;
+    std::size_t archBegin = len;
+    switch (form) {
+        case HY_FORM_NEVRA:
+            nameEnd = prevDash;
+            versionEnd = lastDash;
+            releaseEnd = lastDot;
+            archBegin = lastDot + 1;
+            break;
+        case HY_FORM_NEVR:
+            nameEnd = prevDash;
+            versionEnd = lastDash;
+            break;
+        case HY_FORM_NEV:
+            nameEnd = lastDash;
+            releaseEnd = versionEnd;
+            break;
+        case HY_FORM_NA:
+            nameEnd = lastDot;
+            versionEnd = releaseEnd = nameEnd;
+            archBegin = lastDot + 1;
+            break;
+        default:
+            break;
+    }
+
+    nevra.setName(std::string(str, nameEnd));
+    int epoch = Nevra::EPOCH_NOT_SET;
+    std::string version;
+    if (versionEnd > nameEnd) {
+        std::size_t versionBegin = nameEnd + 1;
+        if (colon != NOT_FOUND) {
+            epoch = 0;
+            for (; versionBegin < colon; ++versionBegin) {
+                epoch = epoch * 10 + (str[versionBegin] - '0');
+            }
+            ++versionBegin;
+        }
+        version.assign(str + versionBegin, versionEnd - versionBegin);
+    }
+    nevra.setEpoch(epoch);
+    nevra.setVersion(std::move(version));
+    if (releaseEnd > versionEnd) {
+        nevra.setRelease(std::string(str + versionEnd + 1, releaseEnd - versionEnd - 1));
+    } else {
+        nevra.setRelease(std::string());
+    }
+    nevra.setArch(std::string(str + archBegin, len - archBegin));
     return true;
 }
 
+bool Nevra::parse(const char * nevraStr, HyForm form)
+{
+    return NevraSplitter(nevraStr).split(form, *this);
+}
+
 void
 Nevra::clear() noexcept
 {
@@ -24,11 +24,53 @@
 #include "dnf-types.h"
 #include "hy-subject.h"
 
+#include <cstddef>
 #include <string>
 #include <utility>
 
 namespace libdnf {
 
+struct Nevra;
+
+/**
+* @brief Single pass splitter of a string into NEVRA components
+*
+* The string is scanned once in the constructor and only positions of the delimiters are stored,
+* nothing is allocated. The result can be asked for all HyForm forms without scanning the string
+* again. The string must outlive the splitter.
+*/
+struct NevraSplitter {
+public:
+    explicit NevraSplitter(const char * nevraStr) noexcept;
+
+    /**
+    * @brief Returns true if the string can be parsed in given form
+    */
+    bool matches(HyForm form) const noexcept;
+
+    /**
+    * @brief Fills nevra by components of the string parsed in given form
+    *
+    * @return bool false if the string cannot be parsed in the form, nevra is not changed
+    */
+    bool split(HyForm form, Nevra & nevra) const;
+
+private:
+    static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+    bool versionMatches(std::size_t dash, std::size_t end) const noexcept;
+
+    const char * str;
+    std::size_t len;
+    bool valid;
+    bool epochDigits;
+    std::size_t colon;
+    std::size_t colonDash;
+    std::size_t prevDash;
+    std::size_t lastDash;
+    std::size_t lastDot;
+};
+
 struct Nevra {
 public:
     static constexpr int EPOCH_NOT_SET = -1;
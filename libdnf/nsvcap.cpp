@@ -18,59 +18,156 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
-#define HEXADECIMAL DIGITS "abcdef"
-#define MODULE_SPECIAL "+._-"
-#define GLOB "][*?!"
-
 #include "nsvcap.hpp"
 
-#include "libdnf/utils/utils.hpp"
+#include "libdnf/utils/char-class.hpp"
 
-#include <regex/regex.hpp>
+#include <cstring>
 
 namespace libdnf {
 
-#define MODULE_NAME "([" GLOB ASCII_LETTERS DIGITS MODULE_SPECIAL "]+)"
-#define MODULE_STREAM MODULE_NAME
-#define MODULE_VERSION "([" GLOB DIGITS "-]+)"
-#define MODULE_CONTEXT "([" GLOB HEXADECIMAL "-]+)"
-#define MODULE_ARCH MODULE_NAME
-#define MODULE_PROFILE MODULE_NAME
-
-static const Regex NSVCAP_FORM_REGEX[]{
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION ":" MODULE_CONTEXT "::?" MODULE_ARCH "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION ":" MODULE_CONTEXT "::?" MODULE_ARCH "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION     "()"           "::"  MODULE_ARCH "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION     "()"           "::"  MODULE_ARCH "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM     "()"               "()"           "::"  MODULE_ARCH "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM     "()"               "()"           "::"  MODULE_ARCH "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION ":" MODULE_CONTEXT       "()"        "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION     "()"                 "()"        "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION ":" MODULE_CONTEXT       "()"        "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM ":" MODULE_VERSION     "()"                 "()"        "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM     "()"               "()"                 "()"        "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME ":" MODULE_STREAM     "()"               "()"                 "()"        "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME     "()"              "()"               "()"           "::"  MODULE_ARCH "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME     "()"              "()"               "()"           "::"  MODULE_ARCH "\\/?" "()"           "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME     "()"              "()"               "()"                 "()"        "\\/"  MODULE_PROFILE "$", REG_EXTENDED),
-    Regex("^" MODULE_NAME     "()"              "()"               "()"                 "()"        "\\/?" "()"           "$", REG_EXTENDED)
+constexpr std::size_t NsvcapSplitter::MAX_TOKENS;
+
+/**
+* Layouts of colon separated components for every HyModuleForm (indexed by form - 1).
+* Letters mean name, stream, version, context and arch, '-' is an empty component ("::").
+* The arch can be separated by one or two colons in forms with the context.
+*/
+static const struct {
+    const char * layouts[2];
+    bool profile;
+} MODULE_FORM_LAYOUTS[] = {
+    {{"nsvca", "nsvc-a"}, true},    // HY_MODULE_FORM_NSVCAP
+    {{"nsvca", "nsvc-a"}, false},   // HY_MODULE_FORM_NSVCA
+    {{"nsv-a", nullptr}, true},     // HY_MODULE_FORM_NSVAP
+    {{"nsv-a", nullptr}, false},    // HY_MODULE_FORM_NSVA
+    {{"ns-a", nullptr}, true},      // HY_MODULE_FORM_NSAP
+    {{"ns-a", nullptr}, false},     // HY_MODULE_FORM_NSA
+    {{"nsvc", nullptr}, true},      // HY_MODULE_FORM_NSVCP
+    {{"nsv", nullptr}, true},       // HY_MODULE_FORM_NSVP
+    {{"nsvc", nullptr}, false},     // HY_MODULE_FORM_NSVC
+    {{"nsv", nullptr}, false},      // HY_MODULE_FORM_NSV
+    {{"ns", nullptr}, true},        // HY_MODULE_FORM_NSP
+    {{"ns", nullptr}, false},       // HY_MODULE_FORM_NS
+    {{"n-a", nullptr}, true},       // HY_MODULE_FORM_NAP
+    {{"n-a", nullptr}, false},      // HY_MODULE_FORM_NA
+    {{"n", nullptr}, true},         // HY_MODULE_FORM_NP
+    {{"n", nullptr}, false}         // HY_MODULE_FORM_N
 };
 
-bool Nsvcap::parse(const char *nsvcapStr, HyModuleForm form)
+/// Order of components in the layouts
+static const char * const MODULE_COMPONENTS = "nsvca";
+
+static unsigned char
+componentCharClass(char component)
+{
+    switch (component) {
+        case 'v':
+            return CHAR_CLASS_MODULE_VERSION;
+        case 'c':
+            return CHAR_CLASS_MODULE_CONTEXT;
+        default:
+            return CHAR_CLASS_MODULE_NAME;
+    }
+}
+
+NsvcapSplitter::NsvcapSplitter(const char * nsvcapStr) noexcept
+: str(nsvcapStr), ntokens(1), profileBegin(0), profileEnd(0), profileClass(0xFF)
+{
+    std::size_t idx = 0;
+    begins[0] = 0;
+    classes[0] = 0xFF;
+    for (; nsvcapStr[idx] != '\0' && nsvcapStr[idx] != '/'; ++idx) {
+        char c = nsvcapStr[idx];
+        if (c == ':') {
+            ends[ntokens - 1] = idx;
+            if (ntokens == MAX_TOKENS) {
+                ntokens = 0;
+                return;
+            }
+            begins[ntokens] = idx + 1;
+            classes[ntokens] = 0xFF;
+            ++ntokens;
+        } else {
+            classes[ntokens - 1] &= CharClasses::TABLE.classes[static_cast<unsigned char>(c)];
+        }
+    }
+    ends[ntokens - 1] = idx;
+    if (nsvcapStr[idx] == '/') {
+        profileBegin = ++idx;
+        for (; nsvcapStr[idx] != '\0'; ++idx) {
+            profileClass &= CharClasses::TABLE.classes[static_cast<unsigned char>(nsvcapStr[idx])];
+        }
+        profileEnd = idx;
+    }
+}
+
+const char *
+NsvcapSplitter::matchingLayout(HyModuleForm form) const noexcept
+{
+    if (form < HY_MODULE_FORM_NSVCAP || form > HY_MODULE_FORM_N || ntokens == 0)
+        return nullptr;
+    auto & formLayout = MODULE_FORM_LAYOUTS[form - 1];
+
+    bool hasProfile = profileEnd > profileBegin;
+    if (formLayout.profile != hasProfile)
+        return nullptr;
+    if (hasProfile && !(profileClass & CHAR_CLASS_MODULE_NAME))
+        return nullptr;
+
+    for (auto layout : formLayout.layouts) {
+        if (!layout)
+            break;
+        std::size_t idx = 0;
+        for (; layout[idx] != '\0' && idx < ntokens; ++idx) {
+            bool empty = ends[idx] == begins[idx];
+            if (layout[idx] == '-') {
+                if (!empty)
+                    break;
+            } else if (empty || !(classes[idx] & componentCharClass(layout[idx]))) {
+                break;
+            }
+        }
+        if (layout[idx] == '\0' && idx == ntokens)
+            return layout;
+    }
+    return nullptr;
+}
+
+bool
+NsvcapSplitter::matches(HyModuleForm form) const noexcept
 {
-    enum { NAME = 1, STREAM = 2, VERSION = 3, CONTEXT = 4, ARCH = 5, PROFILE = 6, _LAST_ };
-    auto matchResult = NSVCAP_FORM_REGEX[form - 1].match(nsvcapStr, false, _LAST_);
-    if (!matchResult.isMatched() || matchResult.getMatchedLen(NAME) == 0)
+    return matchingLayout(form) != nullptr;
+}
+
+bool
+NsvcapSplitter::split(HyModuleForm form, Nsvcap & nsvcap) const
+{
+    auto layout = matchingLayout(form);
+    if (!layout)
         return false;
-    name = matchResult.getMatchedString(NAME);
-    version = matchResult.getMatchedString(VERSION);
-    stream = matchResult.getMatchedString(STREAM);
-    context = matchResult.getMatchedString(CONTEXT);
-    arch = matchResult.getMatchedString(ARCH);
-    profile = matchResult.getMatchedString(PROFILE);
+    std::string components[5];
+    for (std::size_t idx = 0; idx < ntokens; ++idx) {
+        const char * component = strchr(MODULE_COMPONENTS, layout[idx]);
+        if (component) {
+            components[component - MODULE_COMPONENTS].assign(
+                str + begins[idx], ends[idx] - begins[idx]);
+        }
+    }
+    nsvcap.setName(std::move(components[0]));
+    nsvcap.setStream(std::move(components[1]));
+    nsvcap.setVersion(std::move(components[2]));
+    nsvcap.setContext(std::move(components[3]));
+    nsvcap.setArch(std::move(components[4]));
+    nsvcap.setProfile(std::string(str + profileBegin, profileEnd - profileBegin));
     return true;
 }
 
+bool Nsvcap::parse(const char *nsvcapStr, HyModuleForm form)
+{
+    return NsvcapSplitter(nsvcapStr).split(form, *this);
+}
+
 void
 Nsvcap::clear()
 {
@@ -23,10 +23,51 @@
 
 #include "hy-subject.h"
 
+#include <cstddef>
 #include <string>
 
 namespace libdnf {
 
+struct Nsvcap;
+
+/**
+* @brief Single pass splitter of a string into NSVCAP components
+*
+* The string is scanned once in the constructor, components are stored as positions into the string
+* together with their character classes. The result can be asked for all HyModuleForm forms without
+* scanning the string again. The string must outlive the splitter.
+*/
+struct NsvcapSplitter {
+public:
+    explicit NsvcapSplitter(const char * nsvcapStr) noexcept;
+
+    /**
+    * @brief Returns true if the string can be parsed in given form
+    */
+    bool matches(HyModuleForm form) const noexcept;
+
+    /**
+    * @brief Fills nsvcap by components of the string parsed in given form
+    *
+    * @return bool false if the string cannot be parsed in the form, nsvcap is not changed
+    */
+    bool split(HyModuleForm form, Nsvcap & nsvcap) const;
+
+private:
+    static constexpr std::size_t MAX_TOKENS = 6;
+
+    const char * matchingLayout(HyModuleForm form) const noexcept;
+
+    const char * str;
+    std::size_t ntokens;
+    std::size_t begins[MAX_TOKENS];
+    std::size_t ends[MAX_TOKENS];
+    unsigned char classes[MAX_TOKENS];
+    std::size_t profileBegin;
+    std::size_t profileEnd;
+    unsigned char profileClass;
+};
+
 struct Nsvcap {
 public:
     bool parse(const char *nsvcapStr, HyModuleForm form);
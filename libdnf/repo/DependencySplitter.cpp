@@ -21,22 +21,19 @@
 #include "DependencySplitter.hpp"
 #include "../dnf-sack.h"
 #include "../log.hpp"
-#include "../utils/regex/regex.hpp"
+#include "../utils/char-class.hpp"
+
+#include <cstring>
 
 #include "bgettext/bgettext-lib.h"
 #include "tinyformat/tinyformat.hpp"
 
 namespace libdnf {
 
-static const Regex RELDEP_REGEX = 
-    Regex("^(\\S*)\\s*(<=|>=|<|>|=|==)?\\s*(\\S*)$", REG_EXTENDED);
-
 static bool
-getCmpFlags(int *cmp_type, std::string matchCmpType)
+getCmpFlags(int *cmp_type, const char * match_start, int subexpr_len)
 {
     auto logger(Log::getLogger());
-    int subexpr_len = matchCmpType.size();
-    auto match_start = matchCmpType.c_str();
     if (subexpr_len == 2) {
         if (strncmp(match_start, "<=", 2) == 0) {
             *cmp_type |= HY_LT;
@@ -69,31 +66,55 @@ getCmpFlags(int *cmp_type, std::string matchCmpType)
     return true;
 }
 
+/// Returns pointer to the first character after the leading characters in/out of charClass
+static const char *
+skipChars(const char * str, unsigned char charClass, bool inClass)
+{
+    while (*str != '\0' && charHasClass(*str, charClass) == inClass)
+        ++str;
+    return str;
+}
+
+/// Returns length of the longest comparison operator ("<=", ">=", "==", "<", ">", "=") at str
+static int
+cmpOperatorLen(const char * str)
+{
+    if (*str != '<' && *str != '>' && *str != '=')
+        return 0;
+    return str[1] == '=' ? 2 : 1;
+}
+
 bool
 DependencySplitter::parse(const char * reldepStr)
 {
-    enum { NAME = 1, CMP_TYPE = 2, EVR = 3, _LAST_ };
-    auto matchResult = RELDEP_REGEX.match(reldepStr, false, _LAST_);
-    if (!matchResult.isMatched() || matchResult.getMatchedLen(NAME) == 0) {
+    // "<name> [<cmp_type> <evr>]", whitespaces around cmp_type are optional
+    auto nameEnd = skipChars(reldepStr, CHAR_CLASS_SPACE, false);
+    if (nameEnd == reldepStr) {
         return false;
     }
-    name = matchResult.getMatchedString(NAME);
-    evr = matchResult.getMatchedString(EVR);
+    auto cmpTypeStart = skipChars(nameEnd, CHAR_CLASS_SPACE, true);
+    int cmpTypeLen = cmpOperatorLen(cmpTypeStart);
+    auto evrStart = skipChars(cmpTypeStart + cmpTypeLen, CHAR_CLASS_SPACE, true);
+    auto evrEnd = skipChars(evrStart, CHAR_CLASS_SPACE, false);
+    if (*evrEnd != '\0') {
+        return false;
+    }
+
+    name.assign(reldepStr, nameEnd);
+    evr.assign(evrStart, evrEnd);
     cmpType = 0;
-    int evrLen = matchResult.getMatchedLen(EVR);
-    int cmpTypeLen = matchResult.getMatchedLen(CMP_TYPE);
     if (cmpTypeLen < 1) {
-        if (evrLen > 0) {
+        if (evrEnd > evrStart) {
             // name contains the space char, e.g. filename like "hello world.jpg"
             evr.clear();
             name = reldepStr;
         }
         return true;
     }
-    if (evrLen < 1)
+    if (evrEnd == evrStart)
         return false;
 
-    return getCmpFlags(&cmpType, matchResult.getMatchedString(CMP_TYPE));
+    return getCmpFlags(&cmpType, cmpTypeStart, cmpTypeLen);
 }
 
 }
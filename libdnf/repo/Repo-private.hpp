@@ -171,11 +171,16 @@ public:
     enum _hy_repo_state state_presto{_HY_NEW};
     enum _hy_repo_state state_updateinfo{_HY_NEW};
     enum _hy_repo_state state_other{_HY_NEW};
+    enum _hy_repo_state state_descriptions{_HY_NEW};
     Id filenames_repodata{0};
     Id presto_repodata{0};
     Id updateinfo_repodata{0};
     Id other_repodata{0};
     int load_flags{0};
+    /* filelists deferred by DNF_SACK_LOAD_FLAG_LAZY_FILELISTS and not loaded yet */
+    bool filelists_pending{false};
+    /* descriptive attributes left out by DNF_SACK_LOAD_FLAG_COMPACT and not loaded yet */
+    bool descriptions_pending{false};
     /* the following three elements are needed for repo rewriting */
     int main_nsolvables{0};
     int main_nrepodata{0};
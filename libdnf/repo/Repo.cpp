@@ -55,6 +55,7 @@
 #include <solv/repo.h>
 #include <solv/util.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cctype>
@@ -1710,10 +1711,21 @@ PackageTarget::ChecksumType PackageTarget::checksumType(const std::string & name
 
 void PackageTarget::downloadPackages(std::vector<PackageTarget *> & targets, bool failFast)
 {
+    // librepo starts the transfers in the list order, so the largest packages go first
+    // to keep a big package from being the lone transfer at the end of the batch
+    std::vector<LrPackageTarget *> lrTargets;
+    lrTargets.reserve(targets.size());
+    for (auto target : targets)
+        lrTargets.push_back(target->pImpl->lrPkgTarget.get());
+    std::stable_sort(lrTargets.begin(), lrTargets.end(),
+        [](const LrPackageTarget * first, const LrPackageTarget * second) {
+            return first->expectedsize > second->expectedsize;
+        });
+
     // Convert vector to GSList
     GSList * list{nullptr};
-    for (auto it = targets.rbegin(); it != targets.rend(); ++it)
-        list = g_slist_prepend(list, (*it)->pImpl->lrPkgTarget.get());
+    for (auto it = lrTargets.rbegin(); it != lrTargets.rend(); ++it)
+        list = g_slist_prepend(list, *it);
     std::unique_ptr<GSList, decltype(&g_slist_free)> listGuard(list, &g_slist_free);
 
     LrPackageDownloadFlag flags = static_cast<LrPackageDownloadFlag>(0);
@@ -1977,29 +1989,31 @@ repo_internalize_trigger(Repo * repo)
     repo_internalize(repo);
 }
 
-void
-repo_update_state(HyRepo repo, enum _hy_repo_repodata which,
-                  enum _hy_repo_state state)
+enum _hy_repo_state *
+repo_get_state(HyRepo repo, enum _hy_repo_repodata which)
 {
     auto repoImpl = libdnf::repoGetImpl(repo);
-    assert(state <= _HY_WRITTEN);
     switch (which) {
     case _HY_REPODATA_FILENAMES:
-        repoImpl->state_filelists = state;
-        return;
+        return &repoImpl->state_filelists;
     case _HY_REPODATA_PRESTO:
-        repoImpl->state_presto = state;
-        return;
+        return &repoImpl->state_presto;
     case _HY_REPODATA_UPDATEINFO:
-        repoImpl->state_updateinfo = state;
-        return;
+        return &repoImpl->state_updateinfo;
     case _HY_REPODATA_OTHER:
-        repoImpl->state_other = state;
-        return;
+        return &repoImpl->state_other;
     default:
         assert(0);
     }
-    return;
+    return nullptr;
+}
+
+void
+repo_update_state(HyRepo repo, enum _hy_repo_repodata which,
+                  enum _hy_repo_state state)
+{
+    assert(state <= _HY_WRITTEN);
+    *repo_get_state(repo, which) = state;
 }
 
 Id
@@ -2176,6 +2190,15 @@ hy_repo_get_string(HyRepo repo, int which)
     return ret[0] == '\0' ? nullptr : ret;
 }
 
+HyRepo
+hy_repo_ref(HyRepo repo)
+{
+    auto repoImpl = libdnf::repoGetImpl(repo);
+    std::lock_guard<std::mutex> guard(repoImpl->attachLibsolvMutex);
+    ++repoImpl->nrefs;
+    return repo;
+}
+
 void
 hy_repo_free(HyRepo repo)
 {
@@ -20,12 +20,17 @@
 
 // libsolv
 extern "C" {
-#include <solv/dataiterator.h>
+#include <solv/pool.h>
 }
 
 #include "DependencyContainer.hpp"
 #include "Dependency.hpp"
 #include "../DependencySplitter.hpp"
+#include "../../dnf-sack-private.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fnmatch.h>
 
 namespace libdnf {
 
@@ -94,17 +99,33 @@ bool DependencyContainer::addReldepWithGlob(const char *reldepStr)
     DependencySplitter depSplitter;
     if(!depSplitter.parse(reldepStr))
         return false;
-    Dataiterator di;
     Pool *pool = dnf_sack_get_pool(sack);
-
-    dataiterator_init(&di, pool, 0, 0, 0, depSplitter.getNameCStr(),
-                      SEARCH_STRING | SEARCH_GLOB);
-    while (dataiterator_step(&di)) {
-        Id id = Dependency::getReldepId(sack, di.kv.str, depSplitter.getEVRCStr(),
-                                        depSplitter.getCmpType());
-        add(id);
+    const char *pattern = depSplitter.getNameCStr();
+
+    // only the names of provides can match, the ones sharing the literal prefix
+    // of the pattern are in a continuous range of the sorted table
+    auto & names = dnf_sack_get_provide_names(sack);
+    auto prefixLength = std::strcspn(pattern, "*?[\\");
+    auto first = names.begin();
+    auto last = names.end();
+    if (prefixLength > 0) {
+        first = std::lower_bound(names.begin(), names.end(), pattern,
+            [pool, prefixLength](Id name, const char *prefix) {
+                return std::strncmp(pool_id2str(pool, name), prefix, prefixLength) < 0;
+            });
+        last = std::upper_bound(first, names.end(), pattern,
+            [pool, prefixLength](const char *prefix, Id name) {
+                return std::strncmp(prefix, pool_id2str(pool, name), prefixLength) < 0;
+            });
+    }
+    for (auto it = first; it != last; ++it) {
+        const char *name = pool_id2str(pool, *it);
+        if (fnmatch(pattern, name, 0) == 0) {
+            Id id = Dependency::getReldepId(sack, name, depSplitter.getEVRCStr(),
+                                            depSplitter.getCmpType());
+            add(id);
+        }
     }
-    dataiterator_free(&di);
     return true;
 }
 
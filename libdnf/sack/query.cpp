@@ -22,7 +22,7 @@
 
 #include <algorithm>
 #include <assert.h>
-#include <fnmatch.h>
+#include <limits>
 #include <vector>
 
 extern "C" {
@@ -43,6 +43,7 @@ extern "C" {
 #include "../dnf-advisory-private.hpp"
 #include "../goal/IdQueue.hpp"
 #include "../goal/Goal-private.hpp"
+#include "../utils/GlobMatcher.hpp"
 #include "advisory.hpp"
 #include "advisorypkg.hpp"
 #include "packageset.hpp"
@@ -181,14 +182,6 @@ nameArchCompareLowerSolvable(const NevraID &first, const Solvable &s)
     return first.arch < s.arch;
 }
 
-static bool
-NameArchSolvableComparator(const Solvable * first, const Solvable * second)
-{
-    if (first->name != second->name)
-        return first->name < second->name;
-    return first->arch < second->arch;
-}
-
 static bool
 NamePrioritySolvableKey(const Solvable * first, const Solvable * second)
 {
@@ -462,61 +455,65 @@ pool_solvable_epoch_optional_2str(Pool *pool, const Solvable *s, gboolean with_e
     return output_string;
 }
 
-static int
-filter_latest_sortcmp(const void *ap, const void *bp, void *dp)
+/**
+* @brief Set bits of ids from start to end (excluded) in the map, whole bytes are set at once
+*/
+static void
+map_set_range(Map *m, Id start, Id end)
 {
-    auto pool = static_cast<Pool *>(dp);
-    Solvable *sa = pool->solvables + *(Id *)ap;
-    Solvable *sb = pool->solvables + *(Id *)bp;
-    int r;
-    r = sa->name - sb->name;
-    if (r)
-        return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
-    if (r)
-        return r;
-    return *(Id *)ap - *(Id *)bp;
+    for (; start < end && (start & 7); ++start)
+        MAPSET(m, start);
+    Id bytesEnd = end & ~7;
+    if (start < bytesEnd) {
+        memset(m->map + (start >> 3), 0xff, (bytesEnd - start) >> 3);
+        start = bytesEnd;
+    }
+    for (; start < end; ++start)
+        MAPSET(m, start);
 }
 
-static int
-filter_latest_sortcmp_byarch(const void *ap, const void *bp, void *dp)
-{
-    auto pool = static_cast<Pool *>(dp);
-    Solvable *sa = pool->solvables + *(Id *)ap;
-    Solvable *sb = pool->solvables + *(Id *)bp;
-    int r;
-    r = sa->name - sb->name;
-    if (r)
-        return r;
-    r = sa->arch - sb->arch;
-    if (r)
-        return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
-    if (r)
-        return r;
-    return *(Id *)ap - *(Id *)bp;
+/**
+* @brief Append packages of the map in the order of dnf_sack_get_name_ordered_solvables()
+*/
+static void
+result_to_ordered_queue(DnfSack *sack, const Map *m, bool byArch, Queue *samename)
+{
+    for (Id id : dnf_sack_get_name_ordered_solvables(sack, byArch)) {
+        // the map can be older than the last solvables added to the pool
+        if (id < (m->size << 3) && MAPTST(m, id))
+            queue_push(samename, id);
+    }
 }
 
-static int
-filter_latest_sortcmp_byarch_bypriority(const void *ap, const void *bp, void *dp)
-{
-    auto pool = static_cast<Pool *>(dp);
-    Solvable *sa = pool->solvables + *(Id *)ap;
-    Solvable *sb = pool->solvables + *(Id *)bp;
-    int r;
-    r = sa->name - sb->name;
-    if (r)
-        return r;
-    r = sa->arch - sb->arch;
-    if (r)
-        return r;
-    r = sb->repo->priority - sa->repo->priority;
-    if (r)
-        return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
-    if (r)
-        return r;
-    return *(Id *)ap - *(Id *)bp;
+/**
+* @brief Keep only packages with the highest repo priority in every block of the same name and arch
+*
+* @param pool: Package pool
+* @param samename: Queue sorted by name and arch, the order of kept packages is preserved
+*/
+static void
+keep_highest_priority(const Pool *pool, Queue *samename)
+{
+    int count = 0;
+    int start_block = 0;
+    for (int i = 1; i <= samename->count; ++i) {
+        const Solvable *highest = pool->solvables + samename->elements[start_block];
+        if (i < samename->count) {
+            const Solvable *considered = pool->solvables + samename->elements[i];
+            if (highest->name == considered->name && highest->arch == considered->arch)
+                continue;
+        }
+        int priority = highest->repo->priority;
+        for (int pos = start_block + 1; pos < i; ++pos)
+            priority = std::max(priority, pool->solvables[samename->elements[pos]].repo->priority);
+        for (int pos = start_block; pos < i; ++pos) {
+            Id p = samename->elements[pos];
+            if (pool->solvables[p].repo->priority == priority)
+                samename->elements[count++] = p;
+        }
+        start_block = i;
+    }
+    samename->count = count;
 }
 
 /**
@@ -729,6 +726,8 @@ int Filter::getCmpType() const noexcept { return pImpl->cmpType; }
 int Filter::getMatchType() const noexcept { return pImpl->matchType; }
 const std::vector< _Match >& Filter::getMatches() const noexcept { return pImpl->matches; }
 
+struct SubjectNevraCandidate;
+
 class Query::Impl {
 public:
     ~Impl();
@@ -779,6 +778,12 @@ private:
     void filterUpdownByPriority(const Filter & f, Map *m);
     void filterUpdownAble(const Filter  &f, Map *m);
     void filterDataiterator(const Filter & f, Map *m);
+    /**
+    * @brief Tries NEVRA interpretations of subjects against the result in a single pass. For every
+    * subject it keeps the lowest rank of a matching candidate and the packages matching it.
+    */
+    void filterNevraCandidates(const std::vector<SubjectNevraCandidate> & candidates,
+        std::vector<int> & bestRanks, std::vector<std::vector<Id>> & matches);
     int filterUnneededOrSafeToRemove(const Swdb &swdb, bool debug_solver, bool safeToRemove);
     void obsoletesByPriority(Pool * pool, Solvable * candidate, Map * m, const Map * target, int obsprovides);
 
@@ -1195,29 +1200,41 @@ Query::Impl::filterDepSolvable(const Filter & f, Map * m)
     Pool * pool = dnf_sack_get_pool(sack);
     Id rco_key = reldep_keyname2id(f.getKeyname());
 
-    IdQueue out;
-
+    // only the solvables with a dependency named like a provide of the filter packages
+    // can have the dependency provided by them
     const auto filter_pset = f.getMatches()[0].pset;
+    std::vector<Id> candidates;
+    IdQueue provides;
     Id id = -1;
     while ((id = filter_pset->next(id)) != -1) {
-        out.clear();
-
-        // queue_push2 because we are creating a selection, which contains pairs
-        // of <flags, Id>, SOLVER_SOOLVABLE_ALL is a special flag which includes
-        // all packages from specified pool, Id is ignored.
-        out.pushBack(SOLVER_SOLVABLE_ALL, 0);
-
-        int flags = 0;
-        flags |= SELECTION_FILTER | SELECTION_WITH_ALL;
-        selection_make_matchsolvable(pool, out.getQueue(), id, flags, rco_key, 0);
-
-        // Queue from selection_make_matchsolvable is a selection, which means
-        // it conntains pairs <flags, Id>, flags refers to how was the Id
-        // matched, that is not important here, so skip it and iterate just
-        // over the Ids.
-        for (int j = 1; j < out.size(); j += 2) {
-            MAPSET(m, out[j]);
+        provides.clear();
+        solvable_lookup_idarray(pool_id2solvable(pool, id), SOLVABLE_PROVIDES, provides.getQueue());
+        for (int i = 0; i < provides.size(); ++i) {
+            dnf_sack_get_dependency_candidates(sack, rco_key, provides[i], candidates);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // same match as selection_make_matchsolvable(), a dependency of the candidate
+    // has to be provided by a package from the filter
+    Map * filter_map = filter_pset->getMap();
+    IdQueue deps;
+    for (auto candidate : candidates) {
+        deps.clear();
+        solvable_lookup_idarray(pool_id2solvable(pool, candidate), rco_key, deps.getQueue());
+        for (int i = 0; i < deps.size(); ++i) {
+            if (deps[i] == SOLVABLE_PREREQMARKER)
+                continue;
+            Id p, pp;
+            FOR_PROVIDES(p, pp, deps[i]) {
+                if (MAPTST(filter_map, p)) {
+                    MAPSET(m, candidate);
+                    goto nextCandidate;
+                }
+            }
         }
+        nextCandidate:;
     }
 }
 
@@ -1231,15 +1248,24 @@ Query::Impl::filterRcoReldep(const Filter & f, Map *m)
     Queue rco;
     auto resultPset = result.get();
 
+    // only the solvables with a dependency of the same name can match
+    std::vector<Id> candidates;
+    for (auto match : f.getMatches()) {
+        dnf_sack_get_dependency_candidates(sack, rco_key, match.reldep, candidates);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
     queue_init(&rco);
-    Id resultId = -1;
-    while ((resultId = resultPset->next(resultId)) != -1) {
+    for (auto resultId : candidates) {
+        if (!resultPset->has(resultId))
+            continue;
         Solvable *s = pool_id2solvable(pool, resultId );
+        queue_empty(&rco);
+        solvable_lookup_idarray(s, rco_key, &rco);
         for (auto match : f.getMatches()) {
             Id reldepFilterId = match.reldep;
 
-            queue_empty(&rco);
-            solvable_lookup_idarray(s, rco_key, &rco);
             for (int j = 0; j < rco.count; ++j) {
                 Id reldepIdFromSolvable = rco.elements[j];
 
@@ -1304,9 +1330,23 @@ Query::Impl::filterName(const Filter & f, Map *m)
         }
         return;
     }
-    
+
+    const bool icase = cmpType & HY_ICASE;
     for (auto match_union : f.getMatches()) {
         const char *match = match_union.str;
+        std::unique_ptr<GlobMatcher> matcher;
+        if ((cmpType & HY_SUBSTR) && (icase || !(cmpType & HY_GLOB)))
+            matcher.reset(new GlobMatcher(GlobMatcher::substring(match, icase)));
+        else if (icase && (cmpType & HY_EQ))
+            matcher.reset(new GlobMatcher(GlobMatcher::literal(match, icase)));
+        else if (cmpType & HY_GLOB)
+            matcher.reset(new GlobMatcher(match, icase));
+        else
+            continue;
+
+        // the same name Id is shared by many solvables, remember the result for the last one
+        Id lastName = 0;
+        bool lastMatched = false;
         Id id = -1;
         while (true) {
             id = resultPset->next(id);
@@ -1314,37 +1354,12 @@ Query::Impl::filterName(const Filter & f, Map *m)
                 break;
 
             Solvable *s = pool_id2solvable(pool, id);
-            if (cmpType & HY_ICASE) {
-                const char *name = pool_id2str(pool, s->name);
-                if (cmpType & HY_SUBSTR) {
-                    if (strcasestr(name, match) != NULL)
-                        MAPSET(m, id);
-                    continue;
-                }
-                if (cmpType & HY_EQ) {
-                    if (strcasecmp(name, match) == 0)
-                        MAPSET(m, id);
-                    continue;
-                }
-                if (cmpType & HY_GLOB) {
-                    if (fnmatch(match, name, FNM_CASEFOLD) == 0)
-                        MAPSET(m, id);
-                    continue;
-                }
-                continue;
-            }
-
-            const char *name = pool_id2str(pool, s->name);
-            if (cmpType & HY_GLOB) {
-                if (fnmatch(match, name, 0) == 0)
-                    MAPSET(m, id);
-                continue;
-            }
-            if (cmpType & HY_SUBSTR) {
-                if (strstr(name, match) != NULL)
-                    MAPSET(m, id);
-                continue;
+            if (s->name != lastName) {
+                lastName = s->name;
+                lastMatched = matcher->match(pool_id2str(pool, s->name));
             }
+            if (lastMatched)
+                MAPSET(m, id);
         }
     }
 }
@@ -1389,6 +1404,10 @@ Query::Impl::filterEvr(const Filter & f, Map *m)
 
     for (auto match : f.getMatches()) {
         Id match_evr = pool_str2id(pool, match.str, 1);
+        // the evr is compared once with evrs of the sack, packages are compared by the rank
+        bool exact;
+        int match_rank = dnf_sack_get_evr_rank_bound(sack, match_evr, &exact);
+        auto & ranks = dnf_sack_get_evr_ranks(sack);
 
         Id id = -1;
         while (true) {
@@ -1396,7 +1415,8 @@ Query::Impl::filterEvr(const Filter & f, Map *m)
             if (id == -1)
                 break;
             Solvable *s = pool_id2solvable(pool, id);
-            int cmp = pool_evrcmp(pool, s->evr, match_evr, EVRCMP_COMPARE);
+            int rank = ranks[s->evr];
+            int cmp = rank < match_rank ? -1 : (rank == match_rank && exact ? 0 : 1);
 
             if ((cmp > 0 && cmp_type & HY_GT) || (cmp < 0 && cmp_type & HY_LT) ||
                 (cmp == 0 && cmp_type & HY_EQ)) {
@@ -1411,7 +1431,7 @@ Query::Impl::filterNevra(const Filter & f, Map *m)
 {
     Pool *pool = dnf_sack_get_pool(sack);
     int cmp_type = f.getCmpType();
-    int fn_flags = (HY_ICASE & cmp_type) ? FNM_CASEFOLD : 0;
+    const bool icase = cmp_type & HY_ICASE;
     auto resultPset = result.get();
 
     for (auto match : f.getMatches()) {
@@ -1420,6 +1440,8 @@ Query::Impl::filterNevra(const Filter & f, Map *m)
             continue;
 
         gboolean present_epoch = strchr(nevra_pattern, ':') != NULL;
+        GlobMatcher matcher = (HY_GLOB & cmp_type) ? GlobMatcher(nevra_pattern, icase) :
+            GlobMatcher::literal(nevra_pattern, icase);
 
         Id id = -1;
         while (true) {
@@ -1429,17 +1451,8 @@ Query::Impl::filterNevra(const Filter & f, Map *m)
             Solvable* s = pool_id2solvable(pool, id);
 
             char* nevra = pool_solvable_epoch_optional_2str(pool, s, present_epoch);
-            if (!(HY_GLOB & cmp_type)) {
-                if (HY_ICASE & cmp_type) {
-                    if (strcasecmp(nevra_pattern, nevra) == 0)
-                        MAPSET(m, id);
-                } else {
-                    if (strcmp(nevra_pattern, nevra) == 0)
-                        MAPSET(m, id);
-                }
-            } else if (fnmatch(nevra_pattern, nevra, fn_flags) == 0) {
+            if (matcher.match(nevra))
                 MAPSET(m, id);
-            }
         }
     }
 }
@@ -1454,6 +1467,7 @@ Query::Impl::filterVersion(const Filter & f, Map *m)
     for (auto match_in : f.getMatches()) {
         const char *match = match_in.str;
         char *filter_vr = solv_dupjoin(match, "-0", NULL);
+        GlobMatcher matcher(match);
 
         Id id = -1;
         while (true) {
@@ -1469,7 +1483,7 @@ Query::Impl::filterVersion(const Filter & f, Map *m)
             pool_split_evr(pool, evr, &e, &v, &r);
 
             if (cmp_type & HY_GLOB) {
-                if (fnmatch(match, v, 0) == 0)
+                if (matcher.match(v))
                     MAPSET(m, id);
                 continue;
             }
@@ -1496,6 +1510,7 @@ Query::Impl::filterRelease(const Filter & f, Map *m)
     for (auto match_in : f.getMatches()) {
         const char *match = match_in.str;
         char *filter_vr = solv_dupjoin("0-", match, NULL);
+        GlobMatcher matcher(match);
 
         Id id = -1;
         while (true) {
@@ -1511,7 +1526,7 @@ Query::Impl::filterRelease(const Filter & f, Map *m)
             pool_split_evr(pool, evr, &e, &v, &r);
 
             if (cmp_type & HY_GLOB) {
-                if (fnmatch(match, r, 0) == 0)
+                if (matcher.match(r))
                     MAPSET(m, id);
                 continue;
             }
@@ -1545,6 +1560,10 @@ Query::Impl::filterArch(const Filter & f, Map *m)
             if (match_arch_id == 0)
                 continue;
         }
+        // there are only a few architectures, the glob is matched once per run of the same one
+        GlobMatcher matcher(match);
+        Id lastArch = 0;
+        bool lastMatched = false;
 
         Id id = -1;
         while (true) {
@@ -1557,9 +1576,12 @@ Query::Impl::filterArch(const Filter & f, Map *m)
                     MAPSET(m, id);
                 continue;
             }
-            const char *arch = pool_id2str(pool, s->arch);
             if (cmp_type & HY_GLOB) {
-                if (fnmatch(match, arch, 0) == 0)
+                if (s->arch != lastArch) {
+                    lastArch = s->arch;
+                    lastMatched = matcher.match(pool_id2str(pool, s->arch));
+                }
+                if (lastMatched)
                     MAPSET(m, id);
                 continue;
             }
@@ -1712,34 +1734,34 @@ void
 Query::Impl::filterReponame(const Filter & f, Map *m)
 {
     Pool *pool = dnf_sack_get_pool(sack);
-    Solvable *s;
     LibsolvRepo *r;
-    Id id;
-    bool ourids[pool->nrepos];
-    auto resultPset = result.get();
+    Id repoid;
+
+    int comparison = f.getCmpType() & ~HY_COMPARISON_FLAG_MASK;
+    if (comparison != HY_EQ)
+        assert(0);
 
-    for (id = 0; id < pool->nrepos; ++id)
-        ourids[id] = false;
-    FOR_REPOS(id, r) {
+    // whole ranges of solvables of matching repos are set, the result is intersected with them
+    // by the caller
+    FOR_REPOS(repoid, r) {
+        bool matched = false;
         for (auto match_in : f.getMatches()) {
             if (!strcmp(r->name, match_in.str)) {
-                ourids[id] = true;
+                matched = true;
                 break;
             }
         }
-    }
-
-    id = -1;
-    int comparison = f.getCmpType() & ~HY_COMPARISON_FLAG_MASK;
-    if (comparison != HY_EQ)
-        assert(0);
-    while (true) {
-        id = resultPset->next(id);
-        if (id == -1)
-            break;
-        s = pool_id2solvable(pool, id);
-        if (s->repo && ourids[s->repo->repoid])
-            MAPSET(m, id);
+        if (!matched)
+            continue;
+        if (r->end - r->start == r->nsolvables) {
+            map_set_range(m, r->start, r->end);
+            continue;
+        }
+        // solvables of other repos or freed ones are between solvables of the repo
+        for (Id id = r->start; id < r->end; ++id) {
+            if (pool->solvables[id].repo == r)
+                MAPSET(m, id);
+        }
     }
 }
 
@@ -1863,73 +1885,36 @@ Query::Impl::filterLatest(const Filter & f, Map *m)
 {
     int keyname = f.getKeyname(); 
     Pool *pool = dnf_sack_get_pool(sack);
-    auto resultPset = result.get();
+    auto resultMap = result->getMap();
+    bool byArch = keyname == HY_PKG_LATEST_PER_ARCH || keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY;
+
+    // packages of the result in the presorted order of the sack, the latest evr first
+    Queue samename;
+    queue_init(&samename);
+    result_to_ordered_queue(sack, resultMap, byArch, &samename);
+    if (keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY)
+        keep_highest_priority(pool, &samename);
 
     for (auto match_in : f.getMatches()) {
         int latest = match_in.num;
         if (latest == 0)
             continue;
-        Queue samename;
-
-        queue_init(&samename);
-        Id id = -1;
-        while (true) {
-            id = resultPset->next(id);
-            if (id == -1)
-                break;
-            queue_push(&samename, id);
-        }
 
-        if (keyname == HY_PKG_LATEST_PER_ARCH) {
-            solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp_byarch, pool);
-        } else if (keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY) {
-            solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp_byarch_bypriority, pool);
-        } else {
-            solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp, pool);
-        }
-
-        // Create blocks per name, arch and repo priority
-        // But call add_latest_to_map only for the block with highest priority
-        Solvable *considered, *highest = 0;
-        bool make_block = 1;
-        int start_block = -1;
-        int i;
-        for (i = 0; i < samename.count; ++i) {
-            Id p = samename.elements[i];
-            considered = pool->solvables + p;
-            if (!highest ||
-                highest->name != considered->name ||
-                ((keyname == HY_PKG_LATEST_PER_ARCH || keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY) &&
-                highest->arch != considered->arch)) {
-                /* start of a new block */
-                if (start_block == -1) {
-                    highest = considered;
-                    start_block = i;
+        // Create blocks per name (and arch)
+        int start_block = 0;
+        for (int i = 1; i <= samename.count; ++i) {
+            if (i < samename.count) {
+                Solvable *highest = pool->solvables + samename.elements[start_block];
+                Solvable *considered = pool->solvables + samename.elements[i];
+                if (highest->name == considered->name &&
+                    (!byArch || highest->arch == considered->arch))
                     continue;
-                }
-                if (make_block) {
-                    add_latest_to_map(pool, m, &samename, start_block, i, latest);
-                }
-                else {
-                    make_block = 1;
-                }
-                highest = considered;
-                start_block = i;
-            } else if (keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY &&
-                highest->repo->priority != considered->repo->priority &&
-                make_block) {
-                add_latest_to_map(pool, m, &samename, start_block, i, latest);
-                make_block = 0;
             }
-        }
-        if (start_block != -1 && make_block) { // Add last block to the map
             add_latest_to_map(pool, m, &samename, start_block, i, latest);
+            start_block = i;
         }
-        queue_free(&samename);
     }
+    queue_free(&samename);
 }
 
 void
@@ -1943,6 +1928,7 @@ Query::Impl::filterUpdown(const Filter & f, Map *m)
     if (!pool->installed) {
         return;
     }
+    auto & evrRanks = dnf_sack_get_evr_ranks(sack);
 
     for (auto match_in : f.getMatches()) {
         if (match_in.num == 0)
@@ -1957,9 +1943,9 @@ Query::Impl::filterUpdown(const Filter & f, Map *m)
             if (s->repo == pool->installed)
                 continue;
             if (f.getKeyname() == HY_PKG_DOWNGRADES) {
-                if (what_downgrades(pool, id) > 0)
+                if (what_downgrades(pool, id, evrRanks) > 0)
                     MAPSET(m, id);
-            } else if (what_upgrades(pool, id) > 0)
+            } else if (what_upgrades(pool, id, evrRanks) > 0)
                 MAPSET(m, id);
         }
     }
@@ -1976,6 +1962,7 @@ Query::Impl::filterUpdownByPriority(const Filter & f, Map *m)
     if (!repoInstalled) {
         return;
     }
+    auto & evrRanks = dnf_sack_get_evr_ranks(sack);
 
     for (auto match_in : f.getMatches()) {
         if (match_in.num == 0)
@@ -2000,12 +1987,12 @@ Query::Impl::filterUpdownByPriority(const Filter & f, Map *m)
                 name = candidate->name;
                 priority = candidate->repo->priority;
                 id = pool_solvable2id(pool, candidate);
-                if (what_upgrades(pool, id) > 0) {
+                if (what_upgrades(pool, id, evrRanks) > 0) {
                     MAPSET(m, id);
                 }
             } else if (priority == candidate->repo->priority) {
                 id = pool_solvable2id(pool, candidate);
-                if (what_upgrades(pool, id) > 0) {
+                if (what_upgrades(pool, id, evrRanks) > 0) {
                     MAPSET(m, id);
                 }
             }
@@ -2026,6 +2013,7 @@ Query::Impl::filterUpdownAble(const Filter  &f, Map *m)
         return;
     }
     auto resultMap = result->getMap();
+    auto & evrRanks = dnf_sack_get_evr_ranks(sack);
 
     for (auto match_in : f.getMatches()) {
         if (match_in.num == 0)
@@ -2043,8 +2031,8 @@ Query::Impl::filterUpdownAble(const Filter  &f, Map *m)
             if (s->repo == pool->installed)
                 continue;
 
-            what = (f.getKeyname() == HY_PKG_DOWNGRADABLE) ? what_downgrades(pool, p) :
-                what_upgrades(pool, p);
+            what = (f.getKeyname() == HY_PKG_DOWNGRADABLE) ? what_downgrades(pool, p, evrRanks) :
+                what_upgrades(pool, p, evrRanks);
             if (what != 0 && map_tst(resultMap, what))
                 map_set(m, what);
         }
@@ -2062,6 +2050,12 @@ Query::Impl::filterDataiterator(const Filter & f, Map *m)
 
     assert(f.getMatchType() == _HY_STR);
 
+    if (f.getKeyname() == HY_PKG_FILE) {
+        for (auto match_in : f.getMatches())
+            dnf_sack_load_lazy_filelists_for(sack, match_in.str, f.getCmpType());
+    }
+    if (keyname == SOLVABLE_DESCRIPTION || keyname == SOLVABLE_SUMMARY || keyname == SOLVABLE_URL)
+        dnf_sack_load_lazy_descriptions(sack, nullptr);
     for (auto match_in : f.getMatches()) {
         const char *match = match_in.str;
         Id id = -1;
@@ -2326,26 +2320,25 @@ Query::filterExtras()
     query_available.addFilter(HY_PKG_REPONAME, HY_NEQ, HY_SYSTEM_REPO_NAME);
     query_available.apply();
 
-    auto resultAvailable = query_available.pImpl->result.get();
-    Id id_available = -1;
-
-    // make vector of available solvables
-    std::vector<Solvable *> namesArch;
-    namesArch.reserve(resultAvailable->size());
-    while ((id_available = resultAvailable->next(id_available)) != -1) {
-        namesArch.push_back(pool_id2solvable(pool, id_available));
-    }
-    std::sort(namesArch.begin(), namesArch.end(), NameArchSolvableComparator);
-    Id id_installed = -1;
-    auto resultInstalled = query_installed.pImpl->result.get();
-
-    while ((id_installed = resultInstalled->next(id_installed)) != -1) {
-        Solvable * s_installed = pool_id2solvable(pool, id_installed);
-        auto low = std::lower_bound(namesArch.begin(), namesArch.end(), s_installed,
-                                    NameArchSolvableComparator);
-        if (low == namesArch.end() || (*low)->name != s_installed->name ||
-            (*low)->arch != s_installed->arch) {
-            MAPSET(resultMap, id_installed);
+    // walk blocks of the same name and arch, installed packages are extras if there is no available
+    // package in the block
+    auto availableMap = query_available.pImpl->result->getMap();
+    auto installedMap = query_installed.pImpl->result->getMap();
+    auto & ordered = dnf_sack_get_name_ordered_solvables(pImpl->sack, true);
+    for (size_t start = 0, end = 0; start < ordered.size(); start = end) {
+        Solvable * first = pool_id2solvable(pool, ordered[start]);
+        bool available = false;
+        for (end = start; end < ordered.size(); ++end) {
+            Solvable * considered = pool_id2solvable(pool, ordered[end]);
+            if (considered->name != first->name || considered->arch != first->arch)
+                break;
+            available = available || MAPTST(availableMap, ordered[end]);
+        }
+        if (available)
+            continue;
+        for (size_t i = start; i < end; ++i) {
+            if (ordered[i] < (installedMap->size << 3) && MAPTST(installedMap, ordered[i]))
+                MAPSET(resultMap, ordered[i]);
         }
     }
 }
@@ -2500,82 +2493,340 @@ Query::filterUserInstalled(const Swdb &swdb)
     swdb.filterUserinstalled(*getResultPset());
 }
 
+/**
+* @brief One NEVRA interpretation of a subject prepared for matching against solvables. It matches
+* the same packages as the filters added by Query::addFilter(HyNevra nevra, bool icase).
+*/
+struct SubjectNevraCandidate {
+public:
+    SubjectNevraCandidate(Pool * pool, Nevra && nevra, bool icase, std::size_t subject, int rank);
+    bool matches(Pool * pool, const Solvable * s) const;
+
+    Nevra nevra;
+    std::size_t subject;
+    /// Position of the form in the list of tried forms, lower rank wins
+    int rank;
+    /// False if no package can match, e.g. the exact name or arch is unknown to the pool
+    bool possible{true};
+    /// Id of the exact name or 0 if the name is a pattern or it is not restricted
+    Id nameId{0};
+    /// Literal beginning of a case sensitive name glob, every matching name starts with it
+    std::string namePrefix;
+    Id archId{0};
+
+private:
+    static bool isRestricted(const std::string & component);
+    bool matchesEvr(Pool * pool, const Solvable * s) const;
+
+    std::string filterVersion;
+    std::string filterRelease;
+    /// Patterns compiled for restricted components that are not matched by an Id or by evrcmp
+    std::unique_ptr<GlobMatcher> nameMatcher;
+    std::unique_ptr<GlobMatcher> versionMatcher;
+    std::unique_ptr<GlobMatcher> releaseMatcher;
+    std::unique_ptr<GlobMatcher> archMatcher;
+};
+
+bool
+SubjectNevraCandidate::isRestricted(const std::string & component)
+{
+    return !component.empty() && component != "*";
+}
+
+SubjectNevraCandidate::SubjectNevraCandidate(Pool * pool, Nevra && nevra, bool icase,
+    std::size_t subject, int rank)
+: nevra(std::move(nevra)), subject(subject), rank(rank)
+{
+    auto & name = this->nevra.getName();
+    if (isRestricted(name)) {
+        bool nameGlob = hy_is_glob_pattern(name.c_str());
+        if (!nameGlob && !icase) {
+            nameId = pool_str2id(pool, name.c_str(), 0);
+            possible = nameId != 0;
+        } else if (!nameGlob) {
+            nameMatcher.reset(new GlobMatcher(GlobMatcher::literal(name.c_str(), true)));
+        } else {
+            nameMatcher.reset(new GlobMatcher(name.c_str(), icase));
+            if (!icase)
+                namePrefix = name.substr(0, name.find_first_of("*[?\\"));
+        }
+    }
+    auto & version = this->nevra.getVersion();
+    if (isRestricted(version)) {
+        if (hy_is_glob_pattern(version.c_str()))
+            versionMatcher.reset(new GlobMatcher(version.c_str()));
+        else
+            filterVersion = version + "-0";
+    }
+    auto & release = this->nevra.getRelease();
+    if (isRestricted(release)) {
+        if (hy_is_glob_pattern(release.c_str()))
+            releaseMatcher.reset(new GlobMatcher(release.c_str()));
+        else
+            filterRelease = "0-" + release;
+    }
+    auto & arch = this->nevra.getArch();
+    if (isRestricted(arch)) {
+        if (hy_is_glob_pattern(arch.c_str())) {
+            archMatcher.reset(new GlobMatcher(arch.c_str()));
+        } else {
+            archId = pool_str2id(pool, arch.c_str(), 0);
+            possible = possible && archId != 0;
+        }
+    }
+}
+
+bool
+SubjectNevraCandidate::matches(Pool * pool, const Solvable * s) const
+{
+    if (nameId) {
+        if (s->name != nameId)
+            return false;
+    } else if (nameMatcher && !nameMatcher->match(pool_id2str(pool, s->name))) {
+        return false;
+    }
+    if (archId) {
+        if (s->arch != archId)
+            return false;
+    } else if (archMatcher && !archMatcher->match(pool_id2str(pool, s->arch))) {
+        return false;
+    }
+    return matchesEvr(pool, s);
+}
+
+bool
+SubjectNevraCandidate::matchesEvr(Pool * pool, const Solvable * s) const
+{
+    bool epochRestricted = nevra.getEpoch() != Nevra::EPOCH_NOT_SET;
+    bool versionRestricted = isRestricted(nevra.getVersion());
+    bool releaseRestricted = isRestricted(nevra.getRelease());
+    if (!epochRestricted && !versionRestricted && !releaseRestricted)
+        return true;
+    if (s->evr == ID_EMPTY)
+        return false;
+
+    const char * evr = pool_id2str(pool, s->evr);
+    if (epochRestricted &&
+        pool_get_epoch(pool, evr) != static_cast<unsigned long>(nevra.getEpoch()))
+        return false;
+    if (!versionRestricted && !releaseRestricted)
+        return true;
+
+    char *e, *v, *r;
+    pool_split_evr(pool, evr, &e, &v, &r);
+    if (!r)
+        r = const_cast<char *>("");
+    if (versionRestricted) {
+        if (versionMatcher) {
+            if (!versionMatcher->match(v))
+                return false;
+        } else {
+            char *vr = pool_tmpjoin(pool, v, "-0", NULL);
+            if (pool_evrcmp_str(pool, vr, filterVersion.c_str(), EVRCMP_COMPARE) != 0)
+                return false;
+        }
+    }
+    if (releaseRestricted) {
+        if (releaseMatcher) {
+            if (!releaseMatcher->match(r))
+                return false;
+        } else {
+            char *rr = pool_tmpjoin(pool, "0-", r, NULL);
+            if (pool_evrcmp_str(pool, rr, filterRelease.c_str(), EVRCMP_COMPARE) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+void
+Query::Impl::filterNevraCandidates(const std::vector<SubjectNevraCandidate> & candidates,
+    std::vector<int> & bestRanks, std::vector<std::vector<Id>> & matches)
+{
+    Pool *pool = dnf_sack_get_pool(sack);
+    auto resultPset = result.get();
+
+    // candidates with an exact name are looked up by the name Id of the solvable, name globs
+    // by their literal prefix, the rest is tried against every solvable
+    std::vector<std::pair<Id, std::size_t>> byName;
+    std::vector<std::pair<std::string, std::size_t>> byPrefix;
+    std::vector<std::size_t> prefixLengths;
+    std::vector<std::size_t> others;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        auto & candidate = candidates[i];
+        if (!candidate.possible)
+            continue;
+        if (candidate.nameId) {
+            byName.emplace_back(candidate.nameId, i);
+        } else if (!candidate.namePrefix.empty()) {
+            byPrefix.emplace_back(candidate.namePrefix, i);
+            prefixLengths.push_back(candidate.namePrefix.size());
+        } else {
+            others.push_back(i);
+        }
+    }
+    if (byName.empty() && byPrefix.empty() && others.empty())
+        return;
+    std::sort(byName.begin(), byName.end());
+    std::sort(byPrefix.begin(), byPrefix.end());
+    std::sort(prefixLengths.begin(), prefixLengths.end());
+    prefixLengths.erase(std::unique(prefixLengths.begin(), prefixLengths.end()),
+        prefixLengths.end());
+
+    auto tryCandidate = [&](std::size_t index, Id id, const Solvable * s) {
+        auto & candidate = candidates[index];
+        auto & bestRank = bestRanks[candidate.subject];
+        if (candidate.rank > bestRank || !candidate.matches(pool, s))
+            return;
+        auto & subjectMatches = matches[candidate.subject];
+        if (candidate.rank < bestRank) {
+            // all solvables visited so far were already tried against the better form
+            subjectMatches.clear();
+            bestRank = candidate.rank;
+        }
+        if (subjectMatches.empty() || subjectMatches.back() != id)
+            subjectMatches.push_back(id);
+    };
+
+    Id id = -1;
+    while (true) {
+        id = resultPset->next(id);
+        if (id == -1)
+            break;
+        Solvable *s = pool_id2solvable(pool, id);
+        auto low = std::lower_bound(byName.begin(), byName.end(),
+            std::pair<Id, std::size_t>(s->name, 0));
+        for (; low != byName.end() && low->first == s->name; ++low)
+            tryCandidate(low->second, id, s);
+        if (!byPrefix.empty()) {
+            const char * name = pool_id2str(pool, s->name);
+            std::size_t nameLen = strlen(name);
+            for (auto prefixLen : prefixLengths) {
+                if (prefixLen > nameLen)
+                    break;
+                auto isLower = [&](const std::pair<std::string, std::size_t> & item, int) {
+                    return item.first.compare(0, std::string::npos, name, prefixLen) < 0;
+                };
+                auto item = std::lower_bound(byPrefix.begin(), byPrefix.end(), 0, isLower);
+                for (; item != byPrefix.end() && item->first.size() == prefixLen &&
+                     item->first.compare(0, std::string::npos, name, prefixLen) == 0; ++item)
+                    tryCandidate(item->second, id, s);
+            }
+        }
+        for (auto index : others)
+            tryCandidate(index, id, s);
+    }
+}
+
+/**
+* @brief Filters the query by the subject interpreted as a NEVRA pattern, a provide or a file
+* pattern, in this order. Used when no NEVRA form of the subject matches any package.
+*/
+static bool
+filterSubjectFallback(Query & query, const char * subject, bool with_nevra, bool with_provides,
+    bool with_filenames)
+{
+    Query origQuery(query);
+
+    if (with_nevra) {
+        query.addFilter(HY_PKG_NEVRA, HY_GLOB, subject);
+        if (!query.empty()) {
+            return true;
+        }
+    }
+
+    if (with_provides) {
+        query.queryUnion(origQuery);
+        query.addFilter(HY_PKG_PROVIDES, HY_GLOB, subject);
+        if (!query.empty()) {
+            return true;
+        }
+    }
+
+    if (with_filenames && hy_is_file_pattern(subject)) {
+        query.queryUnion(origQuery);
+        query.addFilter(HY_PKG_FILE, HY_GLOB, subject);
+        if (!query.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::pair<bool, std::unique_ptr<Nevra>>
 Query::filterSubject(const char * subject, HyForm * forms, bool icase, bool with_nevra,
     bool with_provides, bool with_filenames)
+{
+    auto ret = filterSubjects(std::vector<const char *>{subject}, forms, icase, with_nevra,
+        with_provides, with_filenames);
+    return std::move(ret[0]);
+}
+
+std::vector<std::pair<bool, std::unique_ptr<Nevra>>>
+Query::filterSubjects(const std::vector<const char *> & subjects, HyForm * forms, bool icase,
+    bool with_nevra, bool with_provides, bool with_filenames)
 {
     apply();
-    Query origQuery(*this);
+    Pool *pool = dnf_sack_get_pool(pImpl->sack);
+    std::vector<std::pair<bool, std::unique_ptr<Nevra>>> ret(subjects.size());
 
+    std::vector<SubjectNevraCandidate> candidates;
     if (with_nevra) {
-        Nevra nevraObj;
         const HyForm * tryForms = !forms ? HY_FORMS_MOST_SPEC : forms;
-        for (std::size_t i = 0; tryForms[i] != _HY_FORM_STOP_; ++i) {
-            if (nevraObj.parse(subject, tryForms[i])) {
-                addFilter(&nevraObj, icase);
-                if (!empty()) {
-                    return {true, std::unique_ptr<Nevra>(new Nevra(std::move(nevraObj)))};
-                }
-                queryUnion(origQuery);
-            }
-        }
-        if (!forms) {
-            queryUnion(origQuery);
-            addFilter(HY_PKG_NEVRA, HY_GLOB, subject);
-            if (!empty()) {
-                return {true, std::unique_ptr<Nevra>()};
+        for (std::size_t subject = 0; subject < subjects.size(); ++subject) {
+            NevraSplitter splitter(subjects[subject]);
+            for (int i = 0; tryForms[i] != _HY_FORM_STOP_; ++i) {
+                Nevra nevraObj;
+                if (splitter.split(tryForms[i], nevraObj))
+                    candidates.emplace_back(pool, std::move(nevraObj), icase, subject, i);
             }
         }
     }
+    std::vector<int> bestRanks(subjects.size(), std::numeric_limits<int>::max());
+    std::vector<std::vector<Id>> nevraMatches(subjects.size());
+    pImpl->filterNevraCandidates(candidates, bestRanks, nevraMatches);
 
-    if (with_provides) {
-        queryUnion(origQuery);
-        addFilter(HY_PKG_PROVIDES, HY_GLOB, subject);
-        if (!empty()) {
-            return {true, std::unique_ptr<Nevra>()};
-        }
+    // a subject has one candidate per form, the one of the best rank gave the matches
+    std::vector<const SubjectNevraCandidate *> bestCandidates(subjects.size(), nullptr);
+    for (auto & candidate : candidates) {
+        if (candidate.rank == bestRanks[candidate.subject])
+            bestCandidates[candidate.subject] = &candidate;
     }
 
-    if (with_filenames && hy_is_file_pattern(subject)) {
-        queryUnion(origQuery);
-        addFilter(HY_PKG_FILE, HY_GLOB, subject);
-        if (!empty()) {
-            return {true, std::unique_ptr<Nevra>()};
+    Map matched;
+    map_init(&matched, pool->nsolvables);
+    for (std::size_t subject = 0; subject < subjects.size(); ++subject) {
+        if (!nevraMatches[subject].empty()) {
+            for (auto id : nevraMatches[subject])
+                MAPSET(&matched, id);
+            ret[subject].second.reset(new Nevra(bestCandidates[subject]->nevra));
+            ret[subject].first = true;
+            continue;
+        }
+        Query subjectQuery(*this);
+        if (filterSubjectFallback(subjectQuery, subjects[subject], with_nevra && !forms,
+                                  with_provides, with_filenames)) {
+            map_or(&matched, subjectQuery.getResult());
+            ret[subject].first = true;
         }
     }
-
-    addFilter(HY_PKG_EMPTY, HY_EQ, 1);
-    return {false, std::unique_ptr<Nevra>()};
+    map_and(pImpl->result->getMap(), &matched);
+    map_free(&matched);
+    return ret;
 }
 
 void
 hy_query_to_name_ordered_queue(HyQuery query, IdQueue * samename)
 {
     hy_query_apply(query);
-    Pool *pool = dnf_sack_get_pool(query->getSack());
-
-    const auto result = query->getResult();
-    for (int i = 1; i < pool->nsolvables; ++i)
-        if (MAPTST(result, i))
-            samename->pushBack(i);
-
-    solv_sort(samename->data(), samename->size(), sizeof(Id), filter_latest_sortcmp,
-        pool);
+    result_to_ordered_queue(query->getSack(), query->getResult(), false, samename->getQueue());
 }
 
 void
 hy_query_to_name_arch_ordered_queue(HyQuery query, IdQueue * samename)
 {
     hy_query_apply(query);
-    Pool *pool = dnf_sack_get_pool(query->getSack());
-
-    const auto result = query->getResult();
-    for (int i = 1; i < pool->nsolvables; ++i)
-        if (MAPTST(result, i))
-            samename->pushBack(i);
-
-    solv_sort(samename->data(), samename->size(), sizeof(Id),
-        filter_latest_sortcmp_byarch, pool);
+    result_to_ordered_queue(query->getSack(), query->getResult(), true, samename->getQueue());
 }
 
 }
@@ -206,6 +206,21 @@ public:
     */
     std::pair<bool, std::unique_ptr<Nevra>> filterSubject(const char * subject, HyForm * forms,
         bool icase, bool with_nevra, bool with_provides, bool with_filenames);
+
+    /**
+    * @brief Filter packages to match any of given subjects
+    *
+    * All NEVRA forms of all subjects are evaluated in a single pass over the query. Subjects
+    * without a NEVRA match fall back to provides and file search like in filterSubject().
+    * The query contains packages matched by any of the subjects.
+    *
+    * @param subjects subjects to match
+    * @return std::vector<std::pair<bool, std::unique_ptr<Nevra>>> The result of filterSubject()
+    *         for every subject, in the order of subjects
+    */
+    std::vector<std::pair<bool, std::unique_ptr<Nevra>>> filterSubjects(
+        const std::vector<const char *> & subjects, HyForm * forms, bool icase, bool with_nevra,
+        bool with_provides, bool with_filenames);
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
@@ -251,6 +251,49 @@ CompsEnvironmentItem::getTransactionItems(SQLite3Ptr conn, int64_t transactionId
     return result;
 }
 
+/**
+ * Load items of all transactions with ID in [firstTransactionId, lastTransactionId] at once.
+ * \return list of transaction items ordered by transaction ID
+ */
+std::vector< TransactionItemPtr >
+CompsEnvironmentItem::getTransactionItems(SQLite3Ptr conn,
+                                          int64_t firstTransactionId,
+                                          int64_t lastTransactionId)
+{
+    std::vector< TransactionItemPtr > result;
+
+    const char *sql = R"**(
+        SELECT
+            ti.trans_id,
+            ti.id as ti_id,
+            ti.action as ti_action,
+            ti.reason as ti_reason,
+            ti.state as ti_state,
+            i.item_id,
+            i.environmentid,
+            i.name,
+            i.translated_name,
+            i.pkg_types
+        FROM
+            trans_item ti
+        JOIN
+            comps_environment i USING (item_id)
+        WHERE
+            ti.trans_id BETWEEN ? AND ?
+        ORDER BY
+            ti.trans_id,
+            ti.id
+    )**";
+    SQLite3::Query query(*conn.get(), sql);
+    query.bindv(firstTransactionId, lastTransactionId);
+
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        result.push_back(compsEnvironmentTransactionItemFromQuery(
+            conn, query, query.get< int64_t >("trans_id")));
+    }
+    return result;
+}
+
 std::string
 CompsEnvironmentItem::toStr() const
 {
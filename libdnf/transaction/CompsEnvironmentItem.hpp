@@ -72,6 +72,9 @@ public:
         const std::string &pattern);
     static std::vector< TransactionItemPtr > getTransactionItems(SQLite3Ptr conn,
                                                                  int64_t transactionId);
+    static std::vector< TransactionItemPtr > getTransactionItems(SQLite3Ptr conn,
+                                                                 int64_t firstTransactionId,
+                                                                 int64_t lastTransactionId);
 
 protected:
     const ItemType itemType = ItemType::ENVIRONMENT;
@@ -164,12 +164,7 @@ MergedTransaction::getSoftwarePerformedWith() const
 std::vector< std::pair< int, std::string > >
 MergedTransaction::getConsoleOutput()
 {
-    std::vector< std::pair< int, std::string > > output;
-    for (auto t : transactions) {
-        auto tranOutput = t->getConsoleOutput();
-        output.insert(output.end(), tranOutput.begin(), tranOutput.end());
-    }
-    return output;
+    return Transaction::loadConsoleOutput(transactions);
 }
 
 
@@ -216,6 +211,9 @@ MergedTransaction::getItems()
 {
     ItemPairMap itemPairMap;
 
+    // load items of all the transactions at once
+    Transaction::loadItems(transactions);
+
     // iterate over transaction
     for (auto t : transactions) {
         auto transItems = t->getItems();
@@ -150,6 +150,54 @@ RPMItem::getTransactionItems(SQLite3Ptr conn, int64_t transaction_id)
     return result;
 }
 
+/**
+ * Load items of all transactions with ID in [firstTransactionId, lastTransactionId] at once.
+ * \return list of transaction items ordered by transaction ID
+ */
+std::vector< TransactionItemPtr >
+RPMItem::getTransactionItems(SQLite3Ptr conn,
+                             int64_t firstTransactionId,
+                             int64_t lastTransactionId)
+{
+    std::vector< TransactionItemPtr > result;
+
+    const char *sql =
+        "SELECT "
+        // trans_item
+        "  ti.id, "
+        "  ti.trans_id, "
+        "  ti.action, "
+        "  ti.reason, "
+        "  ti.state, "
+        // repo
+        "  r.repoid, "
+        // rpm
+        "  i.item_id, "
+        "  i.name, "
+        "  i.epoch, "
+        "  i.version, "
+        "  i.release, "
+        "  i.arch "
+        "FROM "
+        "  trans_item ti, "
+        "  repo r, "
+        "  rpm i "
+        "WHERE "
+        "  ti.trans_id BETWEEN ? AND ? "
+        "  AND ti.repo_id = r.id "
+        "  AND ti.item_id = i.item_id "
+        "ORDER BY "
+        "  ti.trans_id, "
+        "  ti.id";
+    SQLite3::Query query(*conn.get(), sql);
+    query.bindv(firstTransactionId, lastTransactionId);
+
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        result.push_back(transactionItemFromQuery(conn, query, query.get< int64_t >("trans_id")));
+    }
+    return result;
+}
+
 std::string
 RPMItem::getNEVRA() const
 {
@@ -54,7 +54,7 @@ Swdb::Swdb(SQLite3Ptr conn, bool autoClose)
     Transformer::migrateSchema(conn);
 }
 
-Swdb::Swdb(const std::string &path)
+Swdb::Swdb(const std::string &path, bool relaxedSync)
   : conn(nullptr)
   , autoClose(true)
 {
@@ -86,7 +86,7 @@ Swdb::Swdb(const std::string &path)
         if (geteuid() == 0) {
             // database exists, running under root
             try {
-                conn = std::make_shared<SQLite3>(path);
+                conn = std::make_shared<SQLite3>(path, relaxedSync);
                 // execute an update to detect if the database is writable
                 conn->exec("BEGIN; UPDATE config SET value='test' WHERE key='test'; ROLLBACK;");
             } catch (SQLite3::Error & ex) {
@@ -97,7 +97,7 @@ Swdb::Swdb(const std::string &path)
         } else {
             // database exists, running under unprivileged user
             try {
-                conn = std::make_shared<SQLite3>(path);
+                conn = std::make_shared<SQLite3>(path, relaxedSync);
                 // execute a select to detect if the database is readable
                 conn->exec("SELECT * FROM config WHERE key='test'");
             } catch (SQLite3::Error & ex) {
@@ -117,7 +117,7 @@ Swdb::Swdb(const std::string &path)
             try {
                 Transformer transformer(path.substr(0, found), path);
                 transformer.transform();
-                conn = std::make_shared<SQLite3>(path);
+                conn = std::make_shared<SQLite3>(path, relaxedSync);
             } catch (SQLite3::Error & ex) {
                 // root must have the database writable -> log and re-throw the exception
                 logger->error(tfm::format("History database cannot be created: %s", ex.what()));
@@ -127,7 +127,7 @@ Swdb::Swdb(const std::string &path)
             try {
                 // database doesn't exist, running under unprivileged user
                 // connect to a new database and initialize it; old data is not migrated
-                conn = std::make_shared<SQLite3>(path);
+                conn = std::make_shared<SQLite3>(path, relaxedSync);
                 Transformer::createDatabase(conn);
             } catch (SQLite3::Error & ex) {
                 // unpriviledged user may have insufficient permissions to create the database -> in-memory fallback
@@ -357,21 +357,35 @@ Swdb::getLastTransaction()
 }
 
 std::vector< TransactionPtr >
-Swdb::listTransactions()
+Swdb::listTransactions(int64_t limit, int64_t offset)
 {
     const char *sql = R"**(
         SELECT
-            id
+            id,
+            dt_begin,
+            dt_end,
+            rpmdb_version_begin,
+            rpmdb_version_end,
+            releasever,
+            user_id,
+            cmdline,
+            state,
+            comment
         FROM
             trans
         ORDER BY
             id
+        LIMIT ? OFFSET ?
     )**";
-    SQLite3::Statement query(*conn, sql);
+    SQLite3::Query query(*conn, sql);
+    query.bindv(limit, offset);
     std::vector< TransactionPtr > result;
+    auto batch = std::make_shared< std::vector< std::weak_ptr< Transaction > > >();
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
-        auto transId = query.get< int64_t >(0);
-        auto transaction = std::make_shared< Transaction >(conn, transId);
+        // the constructor is accessible only to friends, std::make_shared can't be used
+        TransactionPtr transaction(new Transaction(conn, query));
+        transaction->batch = batch;
+        batch->push_back(transaction);
         result.push_back(transaction);
     }
     return result;
@@ -47,7 +47,7 @@ namespace libdnf {
 struct Swdb {
 public:
     explicit Swdb(SQLite3Ptr conn);
-    explicit Swdb(const std::string &path);
+    explicit Swdb(const std::string &path, bool relaxedSync = false);
     ~Swdb();
 
     SQLite3Ptr getConn() { return conn; }
@@ -74,8 +74,14 @@ public:
     std::vector< TransactionItemPtr > getItems() { return transactionInProgress->getItems(); }
 
     TransactionPtr getLastTransaction();
-    std::vector< TransactionPtr >
-    listTransactions(); // std::vector<long long> transactionIds);
+    /**
+     * @brief List transactions ordered by ID, loaded by a single query.
+     * Items of the listed transactions are loaded together on the first Transaction::getItems() call.
+     *
+     * @param limit maximal number of returned transactions, a negative value means no limit
+     * @param offset number of skipped transactions
+     */
+    std::vector< TransactionPtr > listTransactions(int64_t limit = -1, int64_t offset = 0);
 
     // TransactionItems
     TransactionItemPtr addItem(ItemPtr item,
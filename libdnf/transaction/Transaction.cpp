@@ -24,8 +24,15 @@
 #include "RPMItem.hpp"
 #include "TransactionItem.hpp"
 
+#include <algorithm>
+#include <map>
+#include <set>
+
 namespace libdnf {
 
+/// Transactions whose IDs differ by at most this are loaded by a single range query
+static constexpr int64_t MAX_TRANSACTION_ID_GAP = 64;
+
 Transaction::Transaction(SQLite3Ptr conn, int64_t pk)
   : conn{conn}
 {
@@ -37,6 +44,13 @@ Transaction::Transaction(SQLite3Ptr conn)
 {
 }
 
+Transaction::Transaction(SQLite3Ptr conn, SQLite3::Query &query)
+  : conn{conn}
+{
+    id = query.get< int64_t >("id");
+    dbSelectFromQuery(query);
+}
+
 bool
 Transaction::operator==(const Transaction &other) const
 {
@@ -93,6 +107,12 @@ Transaction::dbSelect(int64_t pk)
     query.step();
 
     id = pk;
+    dbSelectFromQuery(query);
+}
+
+void
+Transaction::dbSelectFromQuery(SQLite3::Query &query)
+{
     dtBegin = query.get< int >("dt_begin");
     dtEnd = query.get< int >("dt_end");
     rpmdbVersionBegin = query.get< std::string >("rpmdb_version_begin");
@@ -104,13 +124,107 @@ Transaction::dbSelect(int64_t pk)
     comment = query.get< std::string >("comment");
 }
 
+/**
+ * Load items of all transactions with ID in [firstTransactionId, lastTransactionId].
+ * The items of each transaction keep the order of items loaded for a single transaction.
+ */
+static std::vector< TransactionItemPtr >
+getRangeItems(SQLite3Ptr conn, int64_t firstTransactionId, int64_t lastTransactionId)
+{
+    std::vector< TransactionItemPtr > result;
+    auto rpms = RPMItem::getTransactionItems(conn, firstTransactionId, lastTransactionId);
+    result.insert(result.end(), rpms.begin(), rpms.end());
+
+    auto compsGroups = CompsGroupItem::getTransactionItems(conn, firstTransactionId, lastTransactionId);
+    result.insert(result.end(), compsGroups.begin(), compsGroups.end());
+
+    auto compsEnvironments =
+        CompsEnvironmentItem::getTransactionItems(conn, firstTransactionId, lastTransactionId);
+    result.insert(result.end(), compsEnvironments.begin(), compsEnvironments.end());
+    return result;
+}
+
+/**
+ * Fill the replaced-by relations of the items of transactions with ID in
+ * [firstTransactionId, lastTransactionId] with a single query.
+ * \param itemById loaded items; the replacing items of other transactions are loaded and added
+ */
+static void
+loadReplacedBy(SQLite3Ptr conn,
+               int64_t firstTransactionId,
+               int64_t lastTransactionId,
+               std::map< int64_t, TransactionItemPtr > &itemById)
+{
+    const char *sql = R"**(
+        SELECT
+            r.trans_item_id,
+            r.by_trans_item_id,
+            bti.trans_id AS by_trans_id
+        FROM
+            item_replaced_by r
+        JOIN
+            trans_item ti ON r.trans_item_id = ti.id
+        JOIN
+            trans_item bti ON r.by_trans_item_id = bti.id
+        WHERE
+            ti.trans_id BETWEEN ? AND ?
+        ORDER BY
+            r.trans_item_id,
+            r.by_trans_item_id
+    )**";
+    SQLite3::Query query(*conn, sql);
+    query.bindv(firstTransactionId, lastTransactionId);
+
+    std::vector< std::pair< int64_t, int64_t > > relations;
+    std::set< int64_t > otherTransactions;
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        auto itemId = query.get< int64_t >("trans_item_id");
+        auto byItemId = query.get< int64_t >("by_trans_item_id");
+        if (itemById.find(itemId) == itemById.end()) {
+            continue;
+        }
+        relations.emplace_back(itemId, byItemId);
+        if (itemById.find(byItemId) == itemById.end()) {
+            otherTransactions.insert(query.get< int64_t >("by_trans_id"));
+        }
+    }
+
+    for (auto transId : otherTransactions) {
+        for (const auto &item : getRangeItems(conn, transId, transId)) {
+            itemById.emplace(item->getId(), item);
+        }
+    }
+
+    for (const auto &relation : relations) {
+        auto item = itemById.find(relation.first);
+        auto byItem = itemById.find(relation.second);
+        if (item != itemById.end() && byItem != itemById.end()) {
+            item->second->addReplacedBy(byItem->second);
+        }
+    }
+}
+
 /**
  * Loader for the transaction items.
+ * Items of transactions listed together are loaded at once and cached.
  * \return list of transaction items associated with the transaction
  */
 std::vector< TransactionItemPtr >
 Transaction::getItems()
 {
+    if (!itemsLoaded && batch) {
+        std::vector< TransactionPtr > transactions;
+        for (const auto &weak : *batch) {
+            if (auto trans = weak.lock()) {
+                transactions.push_back(trans);
+            }
+        }
+        loadItems(transactions);
+    }
+    if (itemsLoaded) {
+        return loadedItems;
+    }
+
     std::vector< TransactionItemPtr > result;
     auto rpms = RPMItem::getTransactionItems(conn, getId());
     result.insert(result.end(), rpms.begin(), rpms.end());
@@ -121,6 +235,12 @@ Transaction::getItems()
     auto comps_environments = CompsEnvironmentItem::getTransactionItems(conn, getId());
     result.insert(result.end(), comps_environments.begin(), comps_environments.end());
 
+    std::map< int64_t, TransactionItemPtr > itemById;
+    for (const auto &item : result) {
+        itemById[item->getId()] = item;
+    }
+    loadReplacedBy(conn, getId(), getId(), itemById);
+
     return result;
 }
 
@@ -178,4 +298,125 @@ Transaction::getConsoleOutput() const
     return result;
 }
 
+/**
+ * Split IDs of the transactions into ranges covering close IDs.
+ * \return list of [first, last] ID pairs in ascending order
+ */
+static std::vector< std::pair< int64_t, int64_t > >
+getIdRanges(const std::vector< TransactionPtr > &transactions)
+{
+    std::vector< int64_t > ids;
+    for (const auto &trans : transactions) {
+        ids.push_back(trans->getId());
+    }
+    std::sort(ids.begin(), ids.end());
+
+    std::vector< std::pair< int64_t, int64_t > > ranges;
+    for (auto id : ids) {
+        if (ranges.empty() || id - ranges.back().second > MAX_TRANSACTION_ID_GAP) {
+            ranges.emplace_back(id, id);
+        } else {
+            ranges.back().second = id;
+        }
+    }
+    return ranges;
+}
+
+/**
+ * Load items of all given transactions, including their replaced-by relations, with a few
+ * queries per range of transaction IDs. The items are cached in the transactions
+ * and returned by their getItems().
+ * \param transactions transactions loaded from the same database
+ */
+void
+Transaction::loadItems(const std::vector< TransactionPtr > &transactions)
+{
+    if (std::all_of(transactions.begin(), transactions.end(),
+                    [](const TransactionPtr &trans) { return trans->itemsLoaded; })) {
+        return;
+    }
+    auto conn = transactions.front()->conn;
+
+    std::map< int64_t, Transaction * > transById;
+    for (const auto &trans : transactions) {
+        trans->loadedItems.clear();
+        transById[trans->getId()] = trans.get();
+    }
+
+    auto ranges = getIdRanges(transactions);
+    std::map< int64_t, TransactionItemPtr > itemById;
+    for (const auto &range : ranges) {
+        for (const auto &item : getRangeItems(conn, range.first, range.second)) {
+            auto it = transById.find(item->getTransactionId());
+            if (it == transById.end()) {
+                continue;
+            }
+            it->second->loadedItems.push_back(item);
+            itemById[item->getId()] = item;
+        }
+    }
+
+    // the relations are loaded after all ranges, so items replaced within the batch are shared
+    for (const auto &range : ranges) {
+        loadReplacedBy(conn, range.first, range.second, itemById);
+    }
+
+    for (const auto &trans : transactions) {
+        trans->itemsLoaded = true;
+    }
+}
+
+/**
+ * Load console output of all given transactions with a single query per range of transaction IDs.
+ * \param transactions transactions loaded from the same database
+ * \return console output lines of the transactions in the order of the transactions
+ */
+std::vector< std::pair< int, std::string > >
+Transaction::loadConsoleOutput(const std::vector< TransactionPtr > &transactions)
+{
+    std::vector< std::pair< int, std::string > > result;
+    if (transactions.empty()) {
+        return result;
+    }
+    auto conn = transactions.front()->conn;
+
+    const char *sql = R"**(
+        SELECT
+            trans_id,
+            file_descriptor,
+            line
+        FROM
+            console_output
+        WHERE
+            trans_id BETWEEN ? AND ?
+        ORDER BY
+            id
+    )**";
+    SQLite3::Query query(*conn, sql);
+
+    std::map< int64_t, std::vector< std::pair< int, std::string > > > outputByTransId;
+    for (const auto &trans : transactions) {
+        outputByTransId[trans->getId()];
+    }
+    for (const auto &range : getIdRanges(transactions)) {
+        query.reset();
+        query.bindv(range.first, range.second);
+        while (query.step() == SQLite3::Statement::StepResult::ROW) {
+            auto it = outputByTransId.find(query.get< int64_t >("trans_id"));
+            if (it == outputByTransId.end()) {
+                continue;
+            }
+            auto fileDescriptor = query.get< int >("file_descriptor");
+            auto line = query.get< std::string >("line");
+            it->second.push_back(std::make_pair(fileDescriptor, line));
+        }
+    }
+
+    for (const auto &trans : transactions) {
+        auto &output = outputByTransId[trans->getId()];
+        result.insert(result.end(), output.begin(), output.end());
+    }
+    return result;
+}
+
 } // namespace libdnf
@@ -24,6 +24,8 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "../utils/sqlite3/Sqlite3.hpp"
 
@@ -62,14 +64,27 @@ public:
     const std::set< std::shared_ptr< RPMItem > > getSoftwarePerformedWith() const;
     std::vector< std::pair< int, std::string > > getConsoleOutput() const;
 
+    static void loadItems(const std::vector< TransactionPtr > &transactions);
+    static std::vector< std::pair< int, std::string > >
+    loadConsoleOutput(const std::vector< TransactionPtr > &transactions);
+
 protected:
     explicit Transaction(SQLite3Ptr conn);
+    // load from a row of a query selecting all columns of the trans table
+    Transaction(SQLite3Ptr conn, SQLite3::Query &query);
     void dbSelect(int64_t transaction_id);
+    void dbSelectFromQuery(SQLite3::Query &query);
     std::set< std::shared_ptr< RPMItem > > softwarePerformedWith;
 
+    friend class Swdb;
     friend class TransactionItem;
     SQLite3Ptr conn;
 
+    // transactions listed together; items of all of them are loaded on the first getItems() call
+    std::shared_ptr< std::vector< std::weak_ptr< Transaction > > > batch;
+    bool itemsLoaded = false;
+    std::vector< TransactionItemPtr > loadedItems;
+
     int64_t id = 0;
     int64_t dtBegin = 0;
     int64_t dtEnd = 0;
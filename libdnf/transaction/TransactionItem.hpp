@@ -107,7 +107,7 @@ public:
 
     uint32_t getInstalledBy() const;
 
-    // int64_t getTransactionId() const noexcept { return trans.getId(); }
+    int64_t getTransactionId() const noexcept;
 
     const std::vector< TransactionItemPtr > &getReplacedBy() const noexcept { return replacedBy; }
     void addReplacedBy(TransactionItemPtr value) { if (value) replacedBy.push_back(value); }
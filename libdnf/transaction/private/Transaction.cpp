@@ -29,28 +29,46 @@
 
 namespace libdnf {
 
+/// Console output lines written to the database at once
+static constexpr std::size_t CONSOLE_OUTPUT_BATCH_SIZE = 64;
+
 swdb_private::Transaction::Transaction(SQLite3Ptr conn)
   : libdnf::Transaction(conn)
 {
 }
 
+swdb_private::Transaction::~Transaction()
+{
+    // keep the output of a transaction that was not finished
+    try {
+        saveConsoleOutput();
+    } catch (const std::exception &) {
+    }
+}
+
 void
 swdb_private::Transaction::begin()
 {
     if (id != 0) {
         throw std::runtime_error(_("Transaction has already began!"));
     }
+    // write the transaction and all its items at once
+    SQLite3::Savepoint savepoint(*conn);
     dbInsert();
     saveItems();
+    savepoint.commit();
 }
 
 void
 swdb_private::Transaction::finish(TransactionState state)
 {
     // save states to the database before checking for UNKNOWN state
+    SQLite3::Savepoint savepoint(*conn);
+    saveConsoleOutput();
     for (auto i : getItems()) {
         i->saveState();
     }
+    savepoint.commit();
 
     for (auto i : getItems()) {
         if (i->getState() == TransactionItemState::UNKNOWN) {
@@ -233,6 +251,7 @@ swdb_private::Transaction::addSoftwarePerformedWith(std::shared_ptr< RPMItem > s
 /**
  * Save console output line for current transaction to the database. Transaction has
  *  to be saved in advance, otherwise an exception will be thrown.
+ * The lines are written in batches, the rest of them when the transaction is finished.
  * \param fileDescriptor UNIX file descriptor index (1 = stdout, 2 = stderr).
  * \param line console output content
  */
@@ -243,6 +262,22 @@ swdb_private::Transaction::addConsoleOutputLine(int fileDescriptor, const std::s
         throw std::runtime_error(_("Can't add console output to unsaved transaction"));
     }
 
+    consoleOutput.emplace_back(fileDescriptor, line);
+    if (consoleOutput.size() >= CONSOLE_OUTPUT_BATCH_SIZE) {
+        saveConsoleOutput();
+    }
+}
+
+/**
+ * Write the pending console output lines to the database in a single savepoint.
+ */
+void
+swdb_private::Transaction::saveConsoleOutput()
+{
+    if (consoleOutput.empty()) {
+        return;
+    }
+
     const char *sql = R"**(
         INSERT INTO
             console_output (
@@ -253,9 +288,19 @@ swdb_private::Transaction::addConsoleOutputLine(int fileDescriptor, const std::s
         VALUES
             (?, ?, ?);
     )**";
+    SQLite3::Savepoint savepoint(*conn);
     SQLite3::Statement query(*conn, sql);
-    query.bindv(getId(), fileDescriptor, line);
-    query.step();
+    bool first = true;
+    for (const auto &output : consoleOutput) {
+        if (!first) {
+            query.reset();
+        }
+        first = false;
+        query.bindv(getId(), output.first, output.second);
+        query.step();
+    }
+    savepoint.commit();
+    consoleOutput.clear();
 }
 
 } // namespace libdnf
@@ -33,6 +33,7 @@ class Transaction : public libdnf::Transaction {
 public:
     // create an empty object, don't read from db
     explicit Transaction(SQLite3Ptr conn);
+    ~Transaction() override;
 
     void setId(int64_t value) { id = value; }
     void setDtBegin(int64_t value) { dtBegin = value; }
@@ -59,8 +60,12 @@ public:
 
 protected:
     void saveItems();
+    void saveConsoleOutput();
     std::vector< TransactionItemPtr > items;
 
+    /// Console output lines not written to the database yet
+    std::vector< std::pair< int, std::string > > consoleOutput;
+
     void dbInsert();
     void dbUpdate();
 };
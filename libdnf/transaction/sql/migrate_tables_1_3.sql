@@ -0,0 +1,15 @@
+R"**(
+BEGIN TRANSACTION;
+    /* covers lookups of the latest reason by name and arch (resolveTransactionItemReason) */
+    CREATE INDEX IF NOT EXISTS rpm_name_arch ON rpm(name, arch, item_id);
+    /* covers lookups of transaction items of an rpm (getRPMRepo, getTransactionItem, searchTransactions) */
+    CREATE INDEX IF NOT EXISTS trans_item_item_id_trans_id
+        ON trans_item(item_id, trans_id, action, reason, repo_id);
+    /* prefixes of the indexes above */
+    DROP INDEX IF EXISTS rpm_name;
+    DROP INDEX IF EXISTS trans_item_item_id;
+    UPDATE config
+        SET value = '1.3'
+        WHERE key = 'version';
+COMMIT;
+)**"
@@ -1,6 +1,5 @@
 #include "CompressedFile.hpp"
 #include <utility>
-#include <sstream>
 
 extern "C" {
 #   include <solv/solv_xfopen.h>
@@ -36,21 +35,23 @@ std::string CompressedFile::getContent()
         throw NotOpenedException(filePath);
     }
 
-    constexpr size_t bufferSize = 4096;
-    char buffer[bufferSize];
-    std::ostringstream ss;
+    // the content is read directly into the string, which grows geometrically
+    constexpr size_t chunkSize = 128 * 1024;
+    std::string content;
     size_t bytesRead;
 
     do {
+        auto size = content.size();
+        content.resize(size + chunkSize);
         try {
-            bytesRead = read(buffer, bufferSize);
+            bytesRead = read(&content[size], chunkSize);
         } catch (const ReadError & e) {
             throw ReadError(std::string(e.what()) + " Likely the archive is damaged.");
         }
-        ss.write(buffer, bytesRead);
-    } while (bytesRead == bufferSize);
+        content.resize(size + bytesRead);
+    } while (bytesRead == chunkSize);
 
-    return ss.str();
+    return content;
 }
 
 }
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "GlobMatcher.hpp"
+
+#include <fnmatch.h>
+
+namespace libdnf {
+
+namespace {
+
+inline char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline char asciiUpper(char c)
+{
+    return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+bool equal(const char * str, const std::string & segment, bool icase)
+{
+    if (!icase)
+        return memcmp(str, segment.data(), segment.size()) == 0;
+    for (std::size_t i = 0; i < segment.size(); ++i) {
+        if (asciiLower(str[i]) != asciiLower(segment[i]))
+            return false;
+    }
+    return true;
+}
+
+/// Returns the leftmost occurrence of the non-empty segment in [begin, end) or nullptr
+const char * find(const char * begin, const char * end, const std::string & segment, bool icase)
+{
+    if (static_cast<std::size_t>(end - begin) < segment.size())
+        return nullptr;
+    if (!icase)
+        return static_cast<const char *>(memmem(begin, end - begin, segment.data(), segment.size()));
+
+    // candidates are found by the first character, memchr() is used when it has no case
+    char lower = asciiLower(segment[0]);
+    bool caseless = lower == asciiUpper(segment[0]);
+    const char * last = end - segment.size();
+    for (const char * candidate = begin; candidate <= last; ++candidate) {
+        if (caseless) {
+            candidate = static_cast<const char *>(memchr(candidate, lower, last - candidate + 1));
+            if (!candidate)
+                return nullptr;
+        } else if (asciiLower(*candidate) != lower) {
+            continue;
+        }
+        if (equal(candidate, segment, true))
+            return candidate;
+    }
+    return nullptr;
+}
+
+}
+
+GlobMatcher::GlobMatcher(const char * pattern, bool icase)
+: kind(Kind::FNMATCH), icase(icase), pattern(pattern)
+{
+    for (const char * c = pattern; *c; ++c) {
+        // character classes, escapes and case folding of non-ASCII characters are left to fnmatch()
+        if (*c == '?' || *c == '[' || *c == '\\' || (icase && (*c & 0x80)))
+            return;
+    }
+
+    const char * begin = pattern;
+    const char * star;
+    while ((star = strchr(begin, '*'))) {
+        // the first segment is anchored even if it is empty, empty middle segments match anything
+        if (segments.empty() || star != begin)
+            segments.emplace_back(begin, star);
+        begin = star + 1;
+    }
+    segments.emplace_back(begin);
+
+    if (segments.size() == 1) {
+        kind = Kind::LITERAL;
+    } else if (segments.size() == 2) {
+        if (segments.front().empty())
+            kind = segments.back().empty() ? Kind::ANY : Kind::SUFFIX;
+        else
+            kind = segments.back().empty() ? Kind::PREFIX : Kind::SEGMENTS;
+    } else if (segments.size() == 3 && segments.front().empty() && segments.back().empty()) {
+        kind = Kind::CONTAINS;
+    } else {
+        kind = Kind::SEGMENTS;
+    }
+}
+
+GlobMatcher::GlobMatcher(Kind kind, const char * pattern, bool icase)
+: kind(kind), icase(icase), pattern(pattern)
+{}
+
+GlobMatcher
+GlobMatcher::literal(const char * str, bool icase)
+{
+    GlobMatcher matcher(Kind::LITERAL, str, icase);
+    matcher.segments.emplace_back(str);
+    return matcher;
+}
+
+GlobMatcher
+GlobMatcher::substring(const char * str, bool icase)
+{
+    if (*str == '\0') {
+        GlobMatcher matcher(Kind::ANY, str, icase);
+        matcher.segments.resize(2);
+        return matcher;
+    }
+    GlobMatcher matcher(Kind::CONTAINS, str, icase);
+    matcher.segments.resize(3);
+    matcher.segments[1] = str;
+    return matcher;
+}
+
+bool
+GlobMatcher::match(const char * str, std::size_t length) const
+{
+    switch (kind) {
+        case Kind::ANY:
+            return true;
+        case Kind::LITERAL:
+            return length == segments[0].size() && equal(str, segments[0], icase);
+        case Kind::FNMATCH:
+            return fnmatch(pattern.c_str(), str, icase ? FNM_CASEFOLD : 0) == 0;
+        default:
+            break;
+    }
+
+    auto & first = segments.front();
+    auto & last = segments.back();
+    if (length < first.size() + last.size())
+        return false;
+    if (!equal(str, first, icase) || !equal(str + length - last.size(), last, icase))
+        return false;
+
+    // the leftmost occurrence of every middle segment leaves the most space for the next ones
+    const char * begin = str + first.size();
+    const char * end = str + length - last.size();
+    for (std::size_t i = 1; i + 1 < segments.size(); ++i) {
+        begin = find(begin, end, segments[i], icase);
+        if (!begin)
+            return false;
+        begin += segments[i].size();
+    }
+    return true;
+}
+
+}
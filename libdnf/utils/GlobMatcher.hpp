@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef LIBDNF_UTILS_GLOBMATCHER_HPP
+#define LIBDNF_UTILS_GLOBMATCHER_HPP
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace libdnf {
+
+/**
+* @brief Pattern compiled once and matched against many strings.
+*
+* Globs containing only '*' wildcards are split into literal segments and matched by comparing
+* and searching the segments, other globs are passed to fnmatch(). The result is always the same
+* as of fnmatch() without flags, or with FNM_CASEFOLD for case insensitive matchers.
+*/
+class GlobMatcher {
+public:
+    enum class Kind {
+        ANY,        // "*", matches everything
+        LITERAL,    // "abc"
+        PREFIX,     // "abc*"
+        SUFFIX,     // "*abc"
+        CONTAINS,   // "*abc*"
+        SEGMENTS,   // "a*b*c", segments are searched from the left
+        FNMATCH     // the pattern contains '?', '[' or '\'
+    };
+
+    /**
+    * @brief Compiles a glob pattern
+    *
+    * @param pattern glob pattern with fnmatch() syntax
+    * @param icase true - letters are compared without sensitivity to case
+    */
+    explicit GlobMatcher(const char * pattern, bool icase = false);
+
+    /// Matcher of strings equal to str, wildcards in str have no special meaning
+    static GlobMatcher literal(const char * str, bool icase = false);
+
+    /// Matcher of strings containing str, wildcards in str have no special meaning
+    static GlobMatcher substring(const char * str, bool icase = false);
+
+    Kind getKind() const noexcept { return kind; }
+    bool match(const char * str) const { return match(str, strlen(str)); }
+    bool match(const char * str, std::size_t length) const;
+
+private:
+    GlobMatcher(Kind kind, const char * pattern, bool icase);
+
+    Kind kind;
+    bool icase;
+    std::string pattern;
+    /// Literal parts between '*', the first and the last one are anchored and can be empty
+    std::vector<std::string> segments;
+};
+
+}
+
+#endif // LIBDNF_UTILS_GLOBMATCHER_HPP
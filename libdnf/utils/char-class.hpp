@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef LIBDNF_UTILS_CHARCLASS_HPP
+#define LIBDNF_UTILS_CHARCLASS_HPP
+
+namespace libdnf {
+
+/**
+* @brief Character classes used by the NEVRA, NSVCAP and reldep splitters.
+* A character can belong to more classes at once.
+*/
+enum CharClass : unsigned char {
+    CHAR_CLASS_SPACE = 1 << 0,          // [[:space:]]
+    CHAR_CLASS_NEVRA_INVALID = 1 << 1,  // "(/=<> " - never part of a NEVRA
+    CHAR_CLASS_DIGIT = 1 << 2,          // [0-9]
+    CHAR_CLASS_MODULE_NAME = 1 << 3,    // module name, stream, arch and profile, globs allowed
+    CHAR_CLASS_MODULE_VERSION = 1 << 4, // module version, globs allowed
+    CHAR_CLASS_MODULE_CONTEXT = 1 << 5  // module context, globs allowed
+};
+
+#define CHAR_CLASS_GLOB "][*?!"
+#define CHAR_CLASS_DIGITS "0123456789"
+#define CHAR_CLASS_LETTERS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+
+constexpr bool charIsOneOf(char c, const char * set)
+{
+    return *set != '\0' && (*set == c || charIsOneOf(c, set + 1));
+}
+
+constexpr unsigned char charClassOf(char c)
+{
+    return (charIsOneOf(c, " \t\n\v\f\r") ? CHAR_CLASS_SPACE : 0) |
+        (charIsOneOf(c, "(/=<> ") ? CHAR_CLASS_NEVRA_INVALID : 0) |
+        (charIsOneOf(c, CHAR_CLASS_DIGITS) ? CHAR_CLASS_DIGIT : 0) |
+        (charIsOneOf(c, CHAR_CLASS_GLOB CHAR_CLASS_LETTERS CHAR_CLASS_DIGITS "+._-")
+            ? CHAR_CLASS_MODULE_NAME : 0) |
+        (charIsOneOf(c, CHAR_CLASS_GLOB CHAR_CLASS_DIGITS "-")
+            ? CHAR_CLASS_MODULE_VERSION : 0) |
+        (charIsOneOf(c, CHAR_CLASS_GLOB CHAR_CLASS_DIGITS "abcdef-")
+            ? CHAR_CLASS_MODULE_CONTEXT : 0);
+}
+
+#undef CHAR_CLASS_GLOB
+#undef CHAR_CLASS_DIGITS
+#undef CHAR_CLASS_LETTERS
+
+struct CharClassTable {
+    unsigned char classes[256];
+};
+
+template<int... Chars>
+struct CharIndices {};
+
+template<int N, int... Chars>
+struct MakeCharIndices : MakeCharIndices<N - 1, N - 1, Chars...> {};
+
+template<int... Chars>
+struct MakeCharIndices<0, Chars...> {
+    typedef CharIndices<Chars...> type;
+};
+
+template<int... Chars>
+constexpr CharClassTable makeCharClassTable(CharIndices<Chars...>)
+{
+    return CharClassTable{{charClassOf(static_cast<char>(Chars))...}};
+}
+
+struct CharClasses {
+    /// Lookup table generated at compile time, indexed by unsigned char, defined in char-class.cpp
+    static constexpr CharClassTable TABLE = makeCharClassTable(MakeCharIndices<256>::type());
+};
+
+/**
+* @brief Returns true if the character belongs to at least one of classes in the mask
+*/
+inline bool charHasClass(char c, unsigned char mask) noexcept
+{
+    return (CharClasses::TABLE.classes[static_cast<unsigned char>(c)] & mask) != 0;
+}
+
+/**
+* @brief Returns true if all characters in [begin, end) belong to the class
+*/
+inline bool charsHaveClass(const char * begin, const char * end, unsigned char charClass) noexcept
+{
+    for (; begin != end; ++begin) {
+        if (!charHasClass(*begin, charClass))
+            return false;
+    }
+    return true;
+}
+
+}
+
+#endif // LIBDNF_UTILS_CHARCLASS_HPP
@@ -39,8 +39,12 @@ SQLite3::open()
         sqlite3_file_control(db, "main", SQLITE_FCNTL_PERSIST_WAL, &enabled);
         if (sqlite3_db_readonly(db, "main") == 1)
             exec("PRAGMA locking_mode = NORMAL; PRAGMA foreign_keys = ON;");
-        else
+        else {
             exec("PRAGMA locking_mode = NORMAL; PRAGMA journal_mode = WAL; PRAGMA foreign_keys = ON;");
+            // with WAL a commit doesn't need to sync the database, only checkpoints do
+            if (relaxedSync)
+                exec("PRAGMA synchronous = NORMAL;");
+        }
 #else
         // Journal mode WAL in readonly mode is supported from sqlite version 3.22.0
         exec("PRAGMA locking_mode = NORMAL; PRAGMA journal_mode = TRUNCATE; PRAGMA foreign_keys = ON;");
@@ -53,6 +57,7 @@ SQLite3::close()
 {
     if (db == nullptr)
         return;
+    clearStatementCache();
     auto result = sqlite3_close(db);
     if (result == SQLITE_BUSY) {
         sqlite3_stmt *res;
@@ -67,6 +72,50 @@ SQLite3::close()
     db = nullptr;
 }
 
+/**
+ * Return a prepared statement for the SQL. A statement released before is reused, so the SQL
+ * is compiled only once per connection.
+ */
+sqlite3_stmt *
+SQLite3::acquireStatement(const std::string &sql)
+{
+    auto it = statementCache.find(sql);
+    if (it != statementCache.end()) {
+        auto stmt = it->second;
+        statementCache.erase(it);
+        return stmt;
+    }
+
+    sqlite3_stmt *stmt;
+    auto result = sqlite3_prepare_v2(db, sql.c_str(), sql.length() + 1, &stmt, nullptr);
+    if (result != SQLITE_OK) {
+        throw Error(*this, result, "Creating statement failed");
+    }
+    return stmt;
+}
+
+void
+SQLite3::releaseStatement(const std::string &sql, sqlite3_stmt *stmt)
+{
+    if (db != nullptr && statementCache.size() < STATEMENT_CACHE_SIZE &&
+        statementCache.find(sql) == statementCache.end()) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        statementCache.emplace(sql, stmt);
+        return;
+    }
+    sqlite3_finalize(stmt);
+}
+
+void
+SQLite3::clearStatementCache()
+{
+    for (auto &item : statementCache) {
+        sqlite3_finalize(item.second);
+    }
+    statementCache.clear();
+}
+
 void
 SQLite3::backup(const std::string &outputFile)
 {
@@ -76,18 +76,16 @@ public:
 
         Statement(SQLite3 &db, const char *sql)
           : db(db)
+          , sql(sql)
         {
-            auto result = sqlite3_prepare_v2(db.db, sql, -1, &stmt, nullptr);
-            if (result != SQLITE_OK)
-                throw SQLite3::Error(db, result, "Creating statement failed");
+            stmt = db.acquireStatement(this->sql);
         };
 
         Statement(SQLite3 &db, const std::string &sql)
           : db(db)
+          , sql(sql)
         {
-            auto result = sqlite3_prepare_v2(db.db, sql.c_str(), sql.length() + 1, &stmt, nullptr);
-            if (result != SQLITE_OK)
-                throw SQLite3::Error(db, result, "Creating statement failed");
+            stmt = db.acquireStatement(this->sql);
         };
 
         void bind(int pos, int val)
@@ -234,7 +232,7 @@ public:
         ~Statement()
         {
             freeExpandedSql();
-            sqlite3_finalize(stmt);
+            db.releaseStatement(sql, stmt);
         };
 
     protected:
@@ -277,10 +275,49 @@ public:
         }
 
         SQLite3 &db;
+        std::string sql;
         sqlite3_stmt *stmt;
         char *expandSql{nullptr};
     };
 
+    /**
+     * Groups the statements executed during the lifetime of the object into a single database
+     * transaction, so the changes are synced to the disk at once.
+     * The changes are kept by commit(), otherwise they are rolled back in the destructor.
+     * Savepoints can be nested.
+     */
+    class Savepoint {
+    public:
+        explicit Savepoint(SQLite3 &db)
+          : db(db)
+        {
+            db.exec("SAVEPOINT libdnf");
+        }
+
+        Savepoint(const Savepoint &) = delete;
+        Savepoint &operator=(const Savepoint &) = delete;
+
+        ~Savepoint()
+        {
+            if (active) {
+                try {
+                    db.exec("ROLLBACK TO libdnf; RELEASE libdnf");
+                } catch (const Error &) {
+                }
+            }
+        }
+
+        void commit()
+        {
+            db.exec("RELEASE libdnf");
+            active = false;
+        }
+
+    private:
+        SQLite3 &db;
+        bool active{true};
+    };
+
     class Query : public Statement {
     public:
         Query(SQLite3 &db, const char *sql)
@@ -326,8 +363,15 @@ public:
     SQLite3(const SQLite3 &) = delete;
     SQLite3 &operator=(const SQLite3 &) = delete;
 
-    SQLite3(const std::string &dbPath)
+    /**
+     * Open the database.
+     * \param dbPath path to the database file
+     * \param relaxedSync use synchronous=NORMAL in WAL mode, commits are then synced only
+     *                    at checkpoints; the last commits may be lost on a power failure
+     */
+    SQLite3(const std::string &dbPath, bool relaxedSync = false)
       : path{dbPath}
+      , relaxedSync{relaxedSync}
       , db{nullptr}
     {
         open();
@@ -359,9 +403,20 @@ public:
     void restore(const std::string &inputFile);
 
 protected:
+    /// Maximal number of prepared statements kept for reuse
+    static constexpr std::size_t STATEMENT_CACHE_SIZE = 64;
+
+    sqlite3_stmt *acquireStatement(const std::string &sql);
+    void releaseStatement(const std::string &sql, sqlite3_stmt *stmt);
+    void clearStatementCache();
+
     std::string path;
+    bool relaxedSync;
 
     sqlite3 *db;
+
+    /// Prepared statements that are not in use, indexed by their SQL
+    std::map< std::string, sqlite3_stmt * > statementCache;
 };
 
 typedef std::shared_ptr< SQLite3 > SQLite3Ptr;
@@ -287,9 +287,9 @@ void decompress(const char * inPath, const char * outPath, mode_t outMode, const
         fclose(inFile);
         throw std::runtime_error(tfm::format("Error opening %s: %s", outPath, strerror(err)));
     }
-    char buf[4096];
-    while (auto readBytes = fread(buf, 1, sizeof(buf), inFile)) {
-        auto writtenBytes = write(outFd, buf, readBytes);
+    std::vector<char> buf(128 * 1024);
+    while (auto readBytes = fread(buf.data(), 1, buf.size(), inFile)) {
+        auto writtenBytes = write(outFd, buf.data(), readBytes);
         if (writtenBytes == -1) {
             int err = errno;
             close(outFd);
@@ -175,13 +175,14 @@ get_nevra_possibilities(_SubjectObject *self, PyObject *args, PyObject *kwds)
         }
         else if (PyList_Check(forms)) {
             bool error = false;
+            libdnf::NevraSplitter splitter(self->pattern);
             for (Py_ssize_t i = 0; i < PyList_Size(forms); ++i) {
                 PyObject *form = PyList_GetItem(forms, i);
                 if (!PyInt_Check(form)) {
                     error = true;
                     break;
                 }
-                if (nevraObj.parse(self->pattern, static_cast<HyForm>(PyLong_AsLong(form)))) {
+                if (splitter.split(static_cast<HyForm>(PyLong_AsLong(form)), nevraObj)) {
                     if (!addNevraToPyList(list.get(), std::move(nevraObj)))
                         return NULL;
                 }
@@ -192,8 +193,9 @@ get_nevra_possibilities(_SubjectObject *self, PyObject *args, PyObject *kwds)
         PyErr_SetString(PyExc_TypeError, "Malformed subject forms.");
         return NULL;
     } else {
+        libdnf::NevraSplitter splitter(self->pattern);
         for (std::size_t i = 0; HY_FORMS_MOST_SPEC[i] != _HY_FORM_STOP_; ++i) {
-            if (nevraObj.parse(self->pattern, HY_FORMS_MOST_SPEC[i])) {
+            if (splitter.split(HY_FORMS_MOST_SPEC[i], nevraObj)) {
                 if (!addNevraToPyList(list.get(), std::move(nevraObj)))
                     return NULL;
             }
@@ -240,13 +242,14 @@ nsvcap_possibilities(_SubjectObject *self, PyObject *args, PyObject *kwds)
         }
         else if (PyList_Check(forms)) {
             bool error = false;
+            libdnf::NsvcapSplitter splitter(self->pattern);
             for (Py_ssize_t i = 0; i < PyList_Size(forms); ++i) {
                 PyObject *form = PyList_GetItem(forms, i);
                 if (!PyInt_Check(form)) {
                     error = true;
                     break;
                 }
-                if (nsvcapObj.parse(self->pattern, static_cast<HyModuleForm>(PyLong_AsLong(form)))) {
+                if (splitter.split(static_cast<HyModuleForm>(PyLong_AsLong(form)), nsvcapObj)) {
                     if (!addNsvcapToPyList(list.get(), std::move(nsvcapObj)))
                         return NULL;
                 }
@@ -257,8 +260,9 @@ nsvcap_possibilities(_SubjectObject *self, PyObject *args, PyObject *kwds)
         PyErr_SetString(PyExc_TypeError, "Malformed subject forms.");
         return NULL;
     } else {
+        libdnf::NsvcapSplitter splitter(self->pattern);
         for (std::size_t i = 0; HY_MODULE_FORMS_MOST_SPEC[i] != _HY_MODULE_FORM_STOP_; ++i) {
-            if (nsvcapObj.parse(self->pattern, HY_MODULE_FORMS_MOST_SPEC[i])) {
+            if (splitter.split(HY_MODULE_FORMS_MOST_SPEC[i], nsvcapObj)) {
                 if (!addNsvcapToPyList(list.get(), std::move(nsvcapObj)))
                     return NULL;
             }
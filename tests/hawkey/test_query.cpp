@@ -28,6 +28,7 @@
 #include "libdnf/hy-query-private.hpp"
 #include "libdnf/hy-package.h"
 #include "libdnf/hy-packageset.h"
+#include "libdnf/nevra.hpp"
 #include "libdnf/dnf-reldep.h"
 #include "libdnf/dnf-reldep-list.h"
 #include "libdnf/dnf-sack-private.hpp"
@@ -161,6 +162,16 @@ START_TEST(test_query_evr)
     fail_unless(query_count_results(q) == 3);
     hy_query_free(q);
 
+    q = hy_query_create(test_globals.sack);
+    hy_query_filter(q, HY_PKG_EVR, HY_EQ, "0:6.0-0");
+    fail_unless(query_count_results(q) == 1);
+    hy_query_free(q);
+
+    q = hy_query_create(test_globals.sack);
+    hy_query_filter(q, HY_PKG_EVR, HY_GT, "100-0");
+    fail_unless(query_count_results(q) == 0);
+    hy_query_free(q);
+
     const char *evrs[] = {"6.0-0", "2-9", "5.0-0", "0-100", NULL};
     q = hy_query_create(test_globals.sack);
     hy_query_filter_in(q, HY_PKG_EVR, HY_EQ, evrs);
@@ -463,6 +474,50 @@ START_TEST(test_query_conflicts)
 }
 END_TEST
 
+START_TEST(test_query_requires)
+{
+    DnfSack *sack = test_globals.sack;
+    HyQuery q = hy_query_create(sack);
+    DnfReldep *reldep = dnf_reldep_new(sack, "semolina", HY_GT, "1");
+
+    fail_unless(reldep != NULL);
+    hy_query_filter_reldep(q, HY_PKG_REQUIRES, reldep);
+    fail_unless(query_count_results(q) == 1);
+    hy_query_clear(q);
+    delete reldep;
+
+    // packages requiring what the packages in the set provide
+    HyQuery q_pkgs = hy_query_create(sack);
+    hy_query_filter(q_pkgs, HY_PKG_NAME, HY_EQ, "penny-lib");
+    DnfPackageSet *pset = hy_query_run_set(q_pkgs);
+    hy_query_free(q_pkgs);
+    fail_if(hy_query_filter_package_in(q, HY_PKG_REQUIRES, HY_EQ, pset));
+    GPtrArray *plist = hy_query_run(q);
+    fail_unless(plist->len == 2);
+    for (guint i = 0; i < plist->len; ++i) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, i));
+        ck_assert_str_eq(dnf_package_get_name(pkg), "flying");
+    }
+    g_ptr_array_unref(plist);
+    hy_query_clear(q);
+    delete pset;
+
+    // file requires are matched as well
+    q_pkgs = hy_query_create(sack);
+    hy_query_filter(q_pkgs, HY_PKG_NAME, HY_EQ, "tour");
+    pset = hy_query_run_set(q_pkgs);
+    hy_query_free(q_pkgs);
+    fail_if(hy_query_filter_package_in(q, HY_PKG_REQUIRES, HY_EQ, pset));
+    plist = hy_query_run(q);
+    fail_unless(plist->len == 1);
+    auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, 0));
+    ck_assert_str_eq(dnf_package_get_name(pkg), "pigs");
+    g_ptr_array_unref(plist);
+    delete pset;
+    hy_query_free(q);
+}
+END_TEST
+
 START_TEST(test_upgrades_sanity)
 {
     Pool *pool = dnf_sack_get_pool(test_globals.sack);
@@ -545,6 +600,33 @@ START_TEST(test_filter_latest_archs)
 }
 END_TEST
 
+START_TEST(test_filter_latest_name)
+{
+    // flying is available in noarch and x86_64, the latest versions ignore the architecture
+    HyQuery q = hy_query_create(test_globals.sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "flying");
+    hy_query_filter_latest(q, 1);
+    GPtrArray *plist = hy_query_run(q);
+    fail_unless(plist->len == 1);
+    auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, 0));
+    fail_if(strcmp(dnf_package_get_evr(pkg), "3.2-0"));
+    hy_query_free(q);
+    g_ptr_array_unref(plist);
+
+    q = hy_query_create(test_globals.sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "flying");
+    hy_query_filter_latest(q, 2);
+    fail_unless(query_count_results(q) == 2);
+    hy_query_free(q);
+
+    q = hy_query_create(test_globals.sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "flying");
+    hy_query_filter_latest(q, -1);
+    fail_unless(query_count_results(q) == 4);
+    hy_query_free(q);
+}
+END_TEST
+
 START_TEST(test_upgrade_already_installed)
 {
     /* if pkg is installed in two versions and the later is available in repos,
@@ -608,6 +690,12 @@ START_TEST(test_query_provides_glob)
         ck_assert_int_eq(query_count_results(q), 6);
         hy_query_free(q);
 
+        // an escaped character ends the literal prefix of the pattern
+        q = hy_query_create(test_globals.sack);
+        hy_query_filter(q, HY_PKG_PROVIDES, HY_GLOB, "pen\\ny*");
+        ck_assert_int_eq(query_count_results(q), 6);
+        hy_query_free(q);
+
         HyQuery q1 = hy_query_create(test_globals.sack);
         HyQuery q2 = hy_query_create(test_globals.sack);
         hy_query_filter(q1, HY_PKG_PROVIDES, HY_GLOB, "P-l*b >= 3");
@@ -688,6 +776,35 @@ START_TEST(test_query_reldep)
 }
 END_TEST
 
+START_TEST(test_query_subjects)
+{
+    libdnf::Query query(test_globals.sack);
+    auto ret = query.filterSubjects({"jay-5.0-0.x86_64", "penny-lib.i686", "P-lib", "lane"},
+                                    nullptr, false, true, true, false);
+    ck_assert_int_eq(ret.size(), 4);
+
+    fail_unless(ret[0].first);
+    ck_assert_str_eq(ret[0].second->getName().c_str(), "jay");
+    ck_assert_str_eq(ret[0].second->getArch().c_str(), "x86_64");
+
+    fail_unless(ret[1].first);
+    ck_assert_str_eq(ret[1].second->getName().c_str(), "penny-lib");
+    ck_assert_str_eq(ret[1].second->getArch().c_str(), "i686");
+
+    fail_unless(ret[2].first);
+    fail_unless(ret[2].second == nullptr);
+
+    fail_if(ret[3].first);
+
+    // two jays, penny-lib.i686 and all P-lib providers
+    ck_assert_int_eq(query.size(), 5);
+
+    libdnf::Query single(test_globals.sack);
+    fail_if(single.filterSubject("lane", nullptr, false, true, true, false).first);
+    fail_unless(single.empty());
+}
+END_TEST
+
 START_TEST(test_query_reldep_arbitrary)
 {
     DnfSack *sack = test_globals.sack;
@@ -796,6 +913,92 @@ START_TEST(test_filter_reponames)
 }
 END_TEST
 
+/* Checks the repo filter against a loop over the solvables of an unfiltered query */
+static void
+check_reponames_filter(DnfSack *sack, int cmp_type, const char **repolist)
+{
+    Pool *pool = dnf_sack_get_pool(sack);
+
+    HyQuery q = hy_query_create_flags(sack, HY_IGNORE_EXCLUDES);
+    g_autoptr(DnfPackageSet) all = hy_query_run_set(q);
+    hy_query_free(q);
+
+    libdnf::PackageSet expected(sack);
+    for (Id id = all->next(-1); id != -1; id = all->next(id)) {
+        bool matched = false;
+        for (const char **name = repolist; *name; ++name)
+            if (strcmp(pool_id2solvable(pool, id)->repo->name, *name) == 0)
+                matched = true;
+        if (matched == (cmp_type == HY_EQ))
+            expected.set(id);
+    }
+
+    q = hy_query_create_flags(sack, HY_IGNORE_EXCLUDES);
+    hy_query_filter_in(q, HY_PKG_REPONAME, cmp_type, repolist);
+    g_autoptr(DnfPackageSet) result = hy_query_run_set(q);
+    hy_query_free(q);
+
+    fail_unless(result->size() == expected.size());
+    for (Id id = expected.next(-1); id != -1; id = expected.next(id))
+        fail_unless(result->has(id));
+}
+
+START_TEST(test_filter_reponames_ranges)
+{
+    DnfSack *sack = test_globals.sack;
+    const char *system[] = {HY_SYSTEM_REPO_NAME, NULL};
+    const char *main_updates[] = {"main", "updates", NULL};
+    const char *all[] = {HY_SYSTEM_REPO_NAME, "main", "updates", NULL};
+    const char *unknown[] = {"foo", NULL};
+
+    check_reponames_filter(sack, HY_EQ, system);
+    check_reponames_filter(sack, HY_NEQ, system);
+    check_reponames_filter(sack, HY_EQ, main_updates);
+    check_reponames_filter(sack, HY_NEQ, main_updates);
+    check_reponames_filter(sack, HY_EQ, all);
+    check_reponames_filter(sack, HY_NEQ, all);
+    check_reponames_filter(sack, HY_EQ, unknown);
+    check_reponames_filter(sack, HY_NEQ, unknown);
+}
+END_TEST
+
+START_TEST(test_filter_reponames_interleaved)
+{
+    const char *main_only[] = {"main", NULL};
+    const char *updates_only[] = {"updates", NULL};
+    DnfSack *sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_set_arch(sack, TEST_FIXED_ARCH, NULL));
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    Pool *pool = dnf_sack_get_pool(sack);
+    const char *main_path = pool_tmpjoin(pool, test_globals.repo_dir, "main.repo", NULL);
+    fail_if(load_repo(pool, "main", main_path, 0));
+    const char *updates_path = pool_tmpjoin(pool, test_globals.repo_dir, "updates.repo", NULL);
+    fail_if(load_repo(pool, "updates", updates_path, 0));
+
+    // more solvables of main after the ones of updates, the range of main is not contiguous
+    Repo *main_repo = NULL;
+    Id repoid;
+    Repo *r;
+    FOR_REPOS(repoid, r)
+        if (!strcmp(r->name, "main"))
+            main_repo = r;
+    fail_unless(main_repo != NULL);
+    FILE *fp = fopen(updates_path, "r");
+    fail_unless(fp != NULL);
+    testcase_add_testtags(main_repo, fp, 0);
+    fclose(fp);
+    fail_if(main_repo->end - main_repo->start == main_repo->nsolvables);
+
+    check_reponames_filter(sack, HY_EQ, main_only);
+    check_reponames_filter(sack, HY_NEQ, main_only);
+    check_reponames_filter(sack, HY_EQ, updates_only);
+    check_reponames_filter(sack, HY_NEQ, updates_only);
+
+    g_object_unref(sack);
+}
+END_TEST
+
 START_TEST(test_excluded)
 {
     DnfSack *sack = test_globals.sack;
@@ -1071,15 +1274,20 @@ query_suite(void)
     tcase_add_test(tc, test_query_enhances);
     tcase_add_test(tc, test_query_reldep);
     tcase_add_test(tc, test_query_reldep_arbitrary);
+    tcase_add_test(tc, test_query_subjects);
     tcase_add_test(tc, test_query_conflicts);
+    tcase_add_test(tc, test_query_requires);
     suite_add_tcase(s, tc);
 
     tc = tcase_create("Full");
     tcase_add_unchecked_fixture(tc, fixture_all, teardown);
     tcase_add_test(tc, test_filter_latest2);
     tcase_add_test(tc, test_filter_latest_archs);
+    tcase_add_test(tc, test_filter_latest_name);
     tcase_add_test(tc, test_filter_obsoletes);
     tcase_add_test(tc, test_filter_reponames);
+    tcase_add_test(tc, test_filter_reponames_ranges);
+    tcase_add_test(tc, test_filter_reponames_interleaved);
     suite_add_tcase(s, tc);
 
     tc = tcase_create("Filelists etc.");
@@ -30,6 +30,7 @@
 #include "testsys.h"
 #include "libdnf/repo/solvable/DependencyContainer.hpp"
 #include "libdnf/repo/solvable/Dependency.hpp"
+#include "libdnf/repo/DependencySplitter.hpp"
 
 START_TEST(test_reldeplist_add)
 {
@@ -51,6 +52,65 @@ START_TEST(test_reldeplist_add)
 }
 END_TEST
 
+START_TEST(test_dependency_splitter)
+{
+    libdnf::DependencySplitter splitter;
+
+    fail_unless(splitter.parse("foo"));
+    ck_assert_str_eq(splitter.getNameCStr(), "foo");
+    fail_unless(splitter.getEVRCStr() == NULL);
+    ck_assert_int_eq(splitter.getCmpType(), 0);
+
+    fail_unless(splitter.parse("foo >= 1.2-3"));
+    ck_assert_str_eq(splitter.getNameCStr(), "foo");
+    ck_assert_str_eq(splitter.getEVRCStr(), "1.2-3");
+    ck_assert_int_eq(splitter.getCmpType(), HY_GT | HY_EQ);
+
+    // whitespaces around the operator are optional, repeated ones are skipped
+    fail_unless(splitter.parse("foo  <\t2"));
+    ck_assert_str_eq(splitter.getNameCStr(), "foo");
+    ck_assert_str_eq(splitter.getEVRCStr(), "2");
+    ck_assert_int_eq(splitter.getCmpType(), HY_LT);
+
+    fail_unless(splitter.parse("foo =1"));
+    ck_assert_str_eq(splitter.getEVRCStr(), "1");
+    ck_assert_int_eq(splitter.getCmpType(), HY_EQ);
+
+    // without a whitespace after the name, the operator is a part of the name
+    fail_unless(splitter.parse("foo>=1"));
+    ck_assert_str_eq(splitter.getNameCStr(), "foo>=1");
+    fail_unless(splitter.getEVRCStr() == NULL);
+    ck_assert_int_eq(splitter.getCmpType(), 0);
+
+    // the operator is matched greedily
+    fail_unless(splitter.parse("a ==1"));
+    ck_assert_str_eq(splitter.getNameCStr(), "a");
+    ck_assert_str_eq(splitter.getEVRCStr(), "1");
+    ck_assert_int_eq(splitter.getCmpType(), HY_EQ);
+
+    fail_unless(splitter.parse("a <=1"));
+    ck_assert_str_eq(splitter.getEVRCStr(), "1");
+    ck_assert_int_eq(splitter.getCmpType(), HY_LT | HY_EQ);
+
+    fail_unless(splitter.parse("a = =1"));
+    ck_assert_str_eq(splitter.getEVRCStr(), "=1");
+    ck_assert_int_eq(splitter.getCmpType(), HY_EQ);
+
+    // a name with a whitespace, e.g. a file name
+    fail_unless(splitter.parse("hello world.jpg"));
+    ck_assert_str_eq(splitter.getNameCStr(), "hello world.jpg");
+    fail_unless(splitter.getEVRCStr() == NULL);
+    ck_assert_int_eq(splitter.getCmpType(), 0);
+
+    fail_if(splitter.parse(""));
+    fail_if(splitter.parse(" foo"));
+    fail_if(splitter.parse("foo >="));
+    fail_if(splitter.parse("foo >= 1 2"));
+    fail_if(splitter.parse("foo <> 1"));
+    fail_if(splitter.parse("foo =< 1"));
+}
+END_TEST
+
 Suite *
 reldep_suite(void)
 {
@@ -58,6 +118,7 @@ reldep_suite(void)
     TCase *tc = tcase_create("Core");
     tcase_add_unchecked_fixture(tc, fixture_with_updates, teardown);
     tcase_add_test(tc, test_reldeplist_add);
+    tcase_add_test(tc, test_dependency_splitter);
     suite_add_tcase(s, tc);
 
     return s;
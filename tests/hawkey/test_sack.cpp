@@ -24,18 +24,28 @@
 #include <unistd.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <solv/testcase.h>
 
 #include <glib/gstdio.h>
 
+#include <rpm/rpmlib.h>
+#include <rpm/rpmmacro.h>
+#include <rpm/rpmts.h>
+
 #include <libdnf/repo/Repo-private.hpp>
 #include "libdnf/dnf-types.h"
 #include "libdnf/hy-package-private.hpp"
+#include "libdnf/hy-query.h"
 #include "libdnf/hy-repo-private.hpp"
 #include "libdnf/dnf-sack-private.hpp"
+#include "libdnf/dnf-context.hpp"
 #include "libdnf/hy-util.h"
 #include "libdnf/hy-iutil-private.hpp"
+#include "libdnf/sack/packageset.hpp"
 #include "fixtures.h"
 #include "testsys.h"
 #include "test_suites.h"
@@ -138,6 +148,93 @@ START_TEST(test_repo_written)
 }
 END_TEST
 
+START_TEST(test_repo_written_async)
+{
+    DnfSack *sack = dnf_sack_new();
+    Pool *pool = dnf_sack_get_pool(sack);
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    char *filename = dnf_sack_give_cache_fn(sack, "test_sack_written_async", NULL);
+    char *fn_filelists = dnf_sack_give_cache_fn(sack, "test_sack_written_async",
+                                                HY_EXT_FILENAMES);
+    const char *repo_path = pool_tmpjoin(pool, test_globals.repo_dir, YUM_DIR_SUFFIX, NULL);
+    HyRepo repo = glob_for_repofiles(pool, "test_sack_written_async", repo_path);
+
+    fail_unless(dnf_sack_load_repo(sack, repo,
+                                   DNF_SACK_LOAD_FLAG_BUILD_CACHE |
+                                   DNF_SACK_LOAD_FLAG_BUILD_CACHE_ASYNC |
+                                   DNF_SACK_LOAD_FLAG_USE_FILELISTS, NULL));
+    fail_unless(dnf_sack_count(sack) == TEST_EXPECT_YUM_NSOLVABLES);
+    fail_unless(dnf_sack_wait_cache_writes(sack, NULL));
+    auto repoImpl = libdnf::repoGetImpl(repo);
+    fail_unless(repoImpl->state_main == _HY_WRITTEN);
+    fail_unless(repoImpl->state_filelists == _HY_WRITTEN);
+    fail_if(access(filename, R_OK|W_OK));
+    fail_if(access(fn_filelists, R_OK|W_OK));
+    /* nothing is pending anymore */
+    fail_unless(dnf_sack_wait_cache_writes(sack, NULL));
+
+    hy_repo_free(repo);
+    g_free(fn_filelists);
+    g_free(filename);
+    g_object_unref(sack);
+}
+END_TEST
+
+static void
+check_compact_summary(DnfSack *sack, HyRepo repo)
+{
+    HyQuery q = hy_query_create(sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "tour");
+    GPtrArray *plist = hy_query_run(q);
+    fail_unless(plist->len == 1);
+    auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, 0));
+    ck_assert_str_eq(dnf_package_get_summary(pkg), "tour package");
+    fail_if(libdnf::repoGetImpl(repo)->descriptions_pending);
+    g_ptr_array_unref(plist);
+    hy_query_free(q);
+}
+
+START_TEST(test_repo_compact)
+{
+    const int flags = DNF_SACK_LOAD_FLAG_BUILD_CACHE | DNF_SACK_LOAD_FLAG_COMPACT;
+    DnfSack *sack = dnf_sack_new();
+    Pool *pool = dnf_sack_get_pool(sack);
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    char *fn_resolver = dnf_sack_give_cache_fn(sack, "test_sack_compact", HY_EXT_RESOLVER);
+    char *fn_descriptions = dnf_sack_give_cache_fn(sack, "test_sack_compact",
+                                                   HY_EXT_DESCRIPTIONS);
+    const char *repo_path = pool_tmpjoin(pool, test_globals.repo_dir, YUM_DIR_SUFFIX, NULL);
+    HyRepo repo = glob_for_repofiles(pool, "test_sack_compact", repo_path);
+
+    fail_unless(dnf_sack_load_repo(sack, repo, flags, NULL));
+    fail_unless(libdnf::repoGetImpl(repo)->state_main == _HY_WRITTEN);
+    fail_if(access(fn_resolver, R_OK));
+    fail_if(access(fn_descriptions, R_OK));
+    fail_unless(libdnf::repoGetImpl(repo)->descriptions_pending);
+    check_compact_summary(sack, repo);
+    hy_repo_free(repo);
+    g_object_unref(sack);
+
+    // the second load uses the written files
+    sack = dnf_sack_new();
+    pool = dnf_sack_get_pool(sack);
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    repo = glob_for_repofiles(pool, "test_sack_compact", repo_path);
+    fail_unless(dnf_sack_load_repo(sack, repo, flags, NULL));
+    fail_unless(libdnf::repoGetImpl(repo)->state_main == _HY_LOADED_CACHE);
+    fail_unless(libdnf::repoGetImpl(repo)->descriptions_pending);
+    check_compact_summary(sack, repo);
+
+    hy_repo_free(repo);
+    g_free(fn_descriptions);
+    g_free(fn_resolver);
+    g_object_unref(sack);
+}
+END_TEST
+
 START_TEST(test_add_cmdline_package)
 {
     g_autoptr(DnfSack) sack = dnf_sack_new();
@@ -161,6 +258,198 @@ START_TEST(test_add_cmdline_package)
 }
 END_TEST
 
+static void *
+rpmdb_fixture_notify(const void *arg, const rpmCallbackType what, const rpm_loff_t amount,
+                     const rpm_loff_t total, fnpyKey key, rpmCallbackData data)
+{
+    auto fd = static_cast<FD_t *>(data);
+    if (what == RPMCALLBACK_INST_OPEN_FILE) {
+        *fd = Fopen(static_cast<const char *>(key), "r.ufdio");
+        return *fd;
+    }
+    if (what == RPMCALLBACK_INST_CLOSE_FILE && *fd) {
+        Fclose(*fd);
+        *fd = NULL;
+    }
+    return NULL;
+}
+
+/* Installs the rpm files into and erases the named packages from the rpmdb
+ * under root, only the database is changed */
+static void
+change_rpmdb(const char *root, const char * const *install, const char * const *erase)
+{
+    g_autofree gchar *dbpath = g_build_filename(root, "var/lib/rpm", NULL);
+    fail_if(g_mkdir_with_parents(dbpath, 0755));
+    fail_if(rpmReadConfigFiles(NULL, NULL));
+    /* an absolute _dbpath with "/" as the root dir needs no chroot */
+    rpmPushMacro(NULL, "_dbpath", NULL, dbpath, RMIL_CMDLINE);
+    rpmts ts = rpmtsCreate();
+    rpmtsSetRootDir(ts, "/");
+    fail_if(rpmtsInitDB(ts, 0644));
+    rpmtsSetVSFlags(ts, _RPMVSF_NOSIGNATURES | _RPMVSF_NODIGESTS);
+    rpmtsSetFlags(ts, RPMTRANS_FLAG_JUSTDB | RPMTRANS_FLAG_NOSCRIPTS |
+                      RPMTRANS_FLAG_NOTRIGGERS | RPMTRANS_FLAG_NOCONTEXTS);
+    for (; install && *install; ++install) {
+        FD_t fd = Fopen(*install, "r.ufdio");
+        fail_if(fd == NULL || Ferror(fd));
+        Header h = NULL;
+        fail_unless(rpmReadPackageFile(ts, fd, *install, &h) == RPMRC_OK);
+        fail_if(rpmtsAddInstallElement(ts, h, (fnpyKey) *install, 0, NULL));
+        headerFree(h);
+        Fclose(fd);
+    }
+    for (; erase && *erase; ++erase) {
+        rpmdbMatchIterator mi = rpmtsInitIterator(ts, RPMDBI_NAME, *erase, 0);
+        Header h;
+        while ((h = rpmdbNextIterator(mi)) != NULL)
+            fail_if(rpmtsAddEraseElement(ts, h, rpmdbGetIteratorOffset(mi)));
+        rpmdbFreeIterator(mi);
+    }
+    FD_t fd = NULL;
+    rpmtsSetNotifyCallback(ts, rpmdb_fixture_notify, &fd);
+    fail_if(rpmtsRun(ts, NULL, RPMPROB_FILTER_IGNOREOS | RPMPROB_FILTER_IGNOREARCH |
+                               RPMPROB_FILTER_REPLACEPKG | RPMPROB_FILTER_OLDPACKAGE |
+                               RPMPROB_FILTER_REPLACENEWFILES | RPMPROB_FILTER_REPLACEOLDFILES |
+                               RPMPROB_FILTER_DISKSPACE | RPMPROB_FILTER_DISKNODES));
+    rpmtsFree(ts);
+    rpmPopMacro(NULL, "_dbpath");
+}
+
+START_TEST(test_refresh_system_repo)
+{
+    g_autofree gchar *root = g_build_filename(test_globals.tmpdir, "refresh-root", NULL);
+    g_autofree gchar *tour_old = g_build_filename(test_globals.repo_dir,
+                                                  "yum_oldrpms/tour-4-5.noarch.rpm", NULL);
+    g_autofree gchar *tour_new = g_build_filename(test_globals.repo_dir,
+                                                  "yum/tour-4-6.noarch.rpm", NULL);
+    g_autofree gchar *mystery = g_build_filename(test_globals.repo_dir,
+                                                 "yum/mystery-devel-19.67-1.noarch.rpm", NULL);
+    const char *installed[] = {tour_old, mystery, NULL};
+    change_rpmdb(root, installed, NULL);
+
+    DnfSack *sack = dnf_sack_new();
+    dnf_sack_set_rootdir(sack, root);
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    fail_unless(dnf_sack_load_system_repo(sack, NULL, DNF_SACK_LOAD_FLAG_NONE, NULL));
+    fail_unless(dnf_sack_count(sack) == 2);
+
+    HyQuery q = hy_query_create(sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "mystery-devel");
+    g_autoptr(DnfPackageSet) pset = hy_query_run_set(q);
+    dnf_sack_add_excludes(sack, pset);
+    hy_query_free(q);
+
+    // tour is updated behind the back of the sack
+    const char *updated[] = {tour_new, NULL};
+    const char *erased[] = {"tour", NULL};
+    change_rpmdb(root, updated, erased);
+    auto & mainConf = libdnf::getGlobalMainConfig();
+    mainConf.excludepkgs().set(libdnf::Option::Priority::RUNTIME, "tour");
+    fail_unless(dnf_sack_refresh_system_repo(sack, NULL));
+    mainConf.excludepkgs().set(libdnf::Option::Priority::RUNTIME, std::vector<std::string>());
+
+    q = hy_query_create_flags(sack, HY_IGNORE_EXCLUDES);
+    hy_query_filter(q, HY_PKG_REPONAME, HY_EQ, HY_SYSTEM_REPO_NAME);
+    GPtrArray *plist = hy_query_run(q);
+    fail_unless(plist->len == 2);
+    for (guint i = 0; i < plist->len; ++i) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, i));
+        const char *nevra = dnf_package_get_nevra(pkg);
+        fail_unless(g_strcmp0(nevra, "tour-4-6.noarch") == 0 ||
+                    g_strcmp0(nevra, "mystery-devel-19.67-1.noarch") == 0, nevra);
+    }
+    g_ptr_array_unref(plist);
+    hy_query_free(q);
+
+    // the kept package keeps its exclude, the new one gets the main excludes
+    q = hy_query_create(sack);
+    hy_query_filter(q, HY_PKG_REPONAME, HY_EQ, HY_SYSTEM_REPO_NAME);
+    plist = hy_query_run(q);
+    fail_unless(plist->len == 0);
+    g_ptr_array_unref(plist);
+    hy_query_free(q);
+
+    g_object_unref(sack);
+}
+END_TEST
+
+/* Computes the rpmdb version from the rpmdb under root the way it is documented for
+ * dnf_sack_get_rpmdb_version(), independently of the sack */
+static std::string
+rpmdb_version_of(const char *root)
+{
+    g_autofree gchar *dbpath = g_build_filename(root, "var/lib/rpm", NULL);
+    std::vector<std::string> checksums;
+    fail_if(rpmReadConfigFiles(NULL, NULL));
+    rpmPushMacro(NULL, "_dbpath", NULL, dbpath, RMIL_CMDLINE);
+    rpmts ts = rpmtsCreate();
+    rpmtsSetRootDir(ts, "/");
+    rpmdbMatchIterator mi = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+    Header h;
+    while ((h = rpmdbNextIterator(mi)) != NULL) {
+        if (g_strcmp0(headerGetString(h, RPMTAG_NAME), "gpg-pubkey") == 0)
+            continue;
+        checksums.push_back(headerGetString(h, RPMTAG_SHA1HEADER));
+    }
+    rpmdbFreeIterator(mi);
+    rpmtsFree(ts);
+    rpmPopMacro(NULL, "_dbpath");
+
+    std::sort(checksums.begin(), checksums.end());
+    g_autoptr(GChecksum) sha1 = g_checksum_new(G_CHECKSUM_SHA1);
+    for (const auto & checksum : checksums)
+        g_checksum_update(sha1, reinterpret_cast<const guchar *>(checksum.c_str()), checksum.size());
+    return std::to_string(checksums.size()) + ":" + g_checksum_get_string(sha1);
+}
+
+START_TEST(test_rpmdb_version)
+{
+    g_autofree gchar *root = g_build_filename(test_globals.tmpdir, "rpmdb-version-root", NULL);
+    g_autofree gchar *tour_old = g_build_filename(test_globals.repo_dir,
+                                                  "yum_oldrpms/tour-4-5.noarch.rpm", NULL);
+    g_autofree gchar *tour_new = g_build_filename(test_globals.repo_dir,
+                                                  "yum/tour-4-6.noarch.rpm", NULL);
+    g_autofree gchar *mystery = g_build_filename(test_globals.repo_dir,
+                                                 "yum/mystery-devel-19.67-1.noarch.rpm", NULL);
+    const char *installed[] = {tour_old, mystery, NULL};
+    change_rpmdb(root, installed, NULL);
+
+    DnfSack *sack = dnf_sack_new();
+    dnf_sack_set_rootdir(sack, root);
+    dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    fail_unless(dnf_sack_load_system_repo(sack, NULL, DNF_SACK_LOAD_FLAG_NONE, NULL));
+
+    std::string version = dnf_sack_get_rpmdb_version(sack);
+    ck_assert_str_eq(version.c_str(), rpmdb_version_of(root).c_str());
+    fail_unless(version.compare(0, 2, "2:") == 0, version.c_str());
+    // the cached value
+    ck_assert_str_eq(dnf_sack_get_rpmdb_version(sack).c_str(), version.c_str());
+
+    // tour is updated behind the back of the sack, the version changes with the reload
+    const char *updated[] = {tour_new, NULL};
+    const char *erased[] = {"tour", NULL};
+    change_rpmdb(root, updated, erased);
+    fail_unless(dnf_sack_refresh_system_repo(sack, NULL));
+    std::string refreshed = dnf_sack_get_rpmdb_version(sack);
+    fail_if(refreshed == version);
+    ck_assert_str_eq(refreshed.c_str(), rpmdb_version_of(root).c_str());
+
+    // a new sack computes the same version from scratch
+    DnfSack *fresh = dnf_sack_new();
+    dnf_sack_set_rootdir(fresh, root);
+    dnf_sack_set_cachedir(fresh, test_globals.tmpdir);
+    fail_unless(dnf_sack_setup(fresh, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+    fail_unless(dnf_sack_load_system_repo(fresh, NULL, DNF_SACK_LOAD_FLAG_NONE, NULL));
+    ck_assert_str_eq(dnf_sack_get_rpmdb_version(fresh).c_str(), refreshed.c_str());
+
+    g_object_unref(fresh);
+    g_object_unref(sack);
+}
+END_TEST
+
 START_TEST(test_repo_load)
 {
     fail_unless(dnf_sack_count(test_globals.sack) ==
@@ -225,6 +514,86 @@ START_TEST(test_filelist_from_cache)
 }
 END_TEST
 
+START_TEST(test_filelist_lazy)
+{
+    // without a valid cache the filelists are loaded at once, the second sack defers them
+    for (int i = 0; i < 2; ++i) {
+        DnfSack *sack = dnf_sack_new();
+        Pool *pool = dnf_sack_get_pool(sack);
+        dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+        fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+        const char *repo_path = pool_tmpjoin(pool, test_globals.repo_dir, YUM_DIR_SUFFIX, NULL);
+        HyRepo repo = glob_for_repofiles(pool, "test_sack_lazy", repo_path);
+
+        fail_unless(dnf_sack_load_repo(sack, repo,
+                                       DNF_SACK_LOAD_FLAG_BUILD_CACHE |
+                                       DNF_SACK_LOAD_FLAG_USE_FILELISTS |
+                                       DNF_SACK_LOAD_FLAG_LAZY_FILELISTS, NULL));
+        auto repoImpl = libdnf::repoGetImpl(repo);
+        fail_unless(repoImpl->state_filelists == (i == 0 ? _HY_WRITTEN : _HY_NEW));
+
+        // files in primary do not need filelists
+        HyQuery q = hy_query_create(sack);
+        hy_query_filter(q, HY_PKG_FILE, HY_EQ, "/usr/bin/tour");
+        hy_query_apply(q);
+        hy_query_free(q);
+        fail_unless(repoImpl->state_filelists == (i == 0 ? _HY_WRITTEN : _HY_NEW));
+
+        q = hy_query_create(sack);
+        hy_query_filter(q, HY_PKG_FILE, HY_EQ, "/usr/lib/python2.7/site-packages/tour/today.pyc");
+        GPtrArray *plist = hy_query_run(q);
+        fail_unless(plist->len == 1);
+        g_ptr_array_unref(plist);
+        hy_query_free(q);
+        fail_unless(repoImpl->state_filelists == (i == 0 ? _HY_WRITTEN : _HY_LOADED_CACHE));
+        check_filelist(pool);
+
+        hy_repo_free(repo);
+        g_object_unref(sack);
+    }
+}
+END_TEST
+
+START_TEST(test_filelist_lazy_updateinfo)
+{
+    // the first sack writes the filelists cache, the second one defers loading it
+    for (int i = 0; i < 2; ++i) {
+        DnfSack *sack = dnf_sack_new();
+        Pool *pool = dnf_sack_get_pool(sack);
+        dnf_sack_set_cachedir(sack, test_globals.tmpdir);
+        fail_unless(dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, NULL));
+        const char *repo_path = pool_tmpjoin(pool, test_globals.repo_dir, YUM_DIR_SUFFIX, NULL);
+        HyRepo repo = glob_for_repofiles(pool, "test_sack_lazy_updateinfo", repo_path);
+
+        fail_unless(dnf_sack_load_repo(sack, repo,
+                                       DNF_SACK_LOAD_FLAG_BUILD_CACHE |
+                                       DNF_SACK_LOAD_FLAG_USE_FILELISTS |
+                                       DNF_SACK_LOAD_FLAG_LAZY_FILELISTS |
+                                       DNF_SACK_LOAD_FLAG_USE_UPDATEINFO, NULL));
+        auto repoImpl = libdnf::repoGetImpl(repo);
+        Repo *r = repoImpl->libsolvRepo;
+        // the advisories follow the packages
+        fail_unless(r->end > repoImpl->main_end);
+        int end = r->end;
+        int nsolvables = r->nsolvables;
+
+        HyQuery q = hy_query_create(sack);
+        hy_query_filter(q, HY_PKG_FILE, HY_EQ, "/usr/lib/python2.7/site-packages/tour/today.pyc");
+        GPtrArray *plist = hy_query_run(q);
+        fail_unless(plist->len == 1);
+        g_ptr_array_unref(plist);
+        hy_query_free(q);
+        fail_unless(repoImpl->state_filelists == (i == 0 ? _HY_WRITTEN : _HY_LOADED_CACHE));
+        fail_unless(r->end == end);
+        fail_unless(r->nsolvables == nsolvables);
+        check_filelist(pool);
+
+        hy_repo_free(repo);
+        g_object_unref(sack);
+    }
+}
+END_TEST
+
 static void
 check_prestoinfo(Pool *pool)
 {
@@ -285,7 +654,11 @@ sack_suite(void)
     tcase_add_test(tc, test_list_arches);
     tcase_add_test(tc, test_load_repo_err);
     tcase_add_test(tc, test_repo_written);
+    tcase_add_test(tc, test_repo_written_async);
+    tcase_add_test(tc, test_repo_compact);
     tcase_add_test(tc, test_add_cmdline_package);
+    tcase_add_test(tc, test_refresh_system_repo);
+    tcase_add_test(tc, test_rpmdb_version);
     suite_add_tcase(s, tc);
 
     tc = tcase_create("Repos");
@@ -297,6 +670,8 @@ sack_suite(void)
     tcase_add_unchecked_fixture(tc, fixture_yum, teardown);
     tcase_add_test(tc, test_filelist);
     tcase_add_test(tc, test_filelist_from_cache);
+    tcase_add_test(tc, test_filelist_lazy);
+    tcase_add_test(tc, test_filelist_lazy_updateinfo);
     tcase_add_test(tc, test_presto);
     tcase_add_test(tc, test_presto_from_cache);
     suite_add_tcase(s, tc);
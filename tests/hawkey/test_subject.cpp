@@ -153,6 +153,57 @@ START_TEST(na)
 }
 END_TEST
 
+START_TEST(nevra_splitter_forms)
+{
+    libdnf::NevraSplitter splitter(inp_fof);
+    libdnf::Nevra nevra;
+    ck_assert(splitter.split(HY_FORM_NEVRA, nevra));
+    ck_assert_str_eq(nevra.getName().c_str(), "four-of-fish");
+    ck_assert_int_eq(nevra.getEpoch(), 8);
+    ck_assert_str_eq(nevra.getArch().c_str(), "x86_64");
+
+    ck_assert(splitter.split(HY_FORM_NEVR, nevra));
+    ck_assert_str_eq(nevra.getRelease().c_str(), "11.fc100.x86_64");
+    fail_unless(nevra.getArch().empty());
+
+    ck_assert(!splitter.matches(HY_FORM_NEV));
+
+    ck_assert(!splitter.matches(HY_FORM_NA));
+    ck_assert(!splitter.matches(HY_FORM_NAME));
+}
+END_TEST
+
+START_TEST(nsvcap_splitter_forms)
+{
+    libdnf::NsvcapSplitter splitter(module_nsvcap);
+    libdnf::Nsvcap nsvcap;
+    ck_assert(splitter.split(HY_MODULE_FORM_NSVCAP, nsvcap));
+    ck_assert_str_eq(nsvcap.getName().c_str(), "module-name");
+    ck_assert_str_eq(nsvcap.getContext().c_str(), "b86c854");
+    ck_assert_str_eq(nsvcap.getArch().c_str(), "x86_64");
+    ck_assert_str_eq(nsvcap.getProfile().c_str(), "profile");
+
+    ck_assert(!splitter.matches(HY_MODULE_FORM_NSVCA));
+    ck_assert(!splitter.matches(HY_MODULE_FORM_NSVAP));
+    ck_assert(!splitter.matches(HY_MODULE_FORM_NSVCP));
+
+    // a failed split keeps the components
+    ck_assert(!splitter.split(HY_MODULE_FORM_NSP, nsvcap));
+    ck_assert_str_eq(nsvcap.getContext().c_str(), "b86c854");
+
+    // the arch follows the context after one or two colons
+    libdnf::NsvcapSplitter two_colons("module-name:stream:1:b86c854::x86_64");
+    ck_assert(two_colons.split(HY_MODULE_FORM_NSVCA, nsvcap));
+    ck_assert_str_eq(nsvcap.getContext().c_str(), "b86c854");
+    ck_assert_str_eq(nsvcap.getArch().c_str(), "x86_64");
+    fail_unless(nsvcap.getProfile().empty());
+
+    libdnf::NsvcapSplitter bad_version("module-name:stream:abc");
+    ck_assert(!bad_version.matches(HY_MODULE_FORM_NSV));
+    ck_assert(!bad_version.matches(HY_MODULE_FORM_NS));
+}
+END_TEST
+
 START_TEST(module_form_nsvcap)
 {
     libdnf::Nsvcap nsvcap;
@@ -320,6 +371,8 @@ subject_suite(void)
     tcase_add_test(tc, nevr_fail);
     tcase_add_test(tc, nev);
     tcase_add_test(tc, na);
+    tcase_add_test(tc, nevra_splitter_forms);
+    tcase_add_test(tc, nsvcap_splitter_forms);
     tcase_add_test(tc, module_form_nsvcap);
     tcase_add_test(tc, module_form_nsvap);
     tcase_add_test(tc, module_form_nsvca);
@@ -23,6 +23,9 @@
 #include <glib-object.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include <glib/gstdio.h>
 #include "libdnf/libdnf.h"
 
@@ -1106,6 +1109,1003 @@ dnf_repo_loader_cache_dir_check_func(void)
 }
 
 
+static void
+copy_dir_files(const gchar *src_dir, const gchar *dst_dir)
+{
+    const gchar *name;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GDir) dir = g_dir_open(src_dir, 0, &error);
+    g_assert_no_error(error);
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        g_autofree gchar *src = g_build_filename(src_dir, name, NULL);
+        g_autofree gchar *dst = g_build_filename(dst_dir, name, NULL);
+        g_autofree gchar *contents = NULL;
+        gsize length;
+        g_assert(g_file_get_contents(src, &contents, &length, &error));
+        g_assert(g_file_set_contents(dst, contents, length, &error));
+    }
+}
+
+static void
+dnf_repo_check_verified_cookie_func(void)
+{
+    DnfRepo *repo;
+    DnfState *state;
+    gboolean ret;
+    struct stat st;
+    int fd;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *cache_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *repodata_dir = NULL;
+    g_autofree gchar *cookie_fn = NULL;
+    g_autofree gchar *cookie = NULL;
+    g_autofree gchar *cookie_new = NULL;
+    g_autofree gchar *primary = NULL;
+    g_autofree gchar *primary_orig = NULL;
+    gsize primary_len;
+
+    /* a remote repo with its metadata already in the cache */
+    tmp_dir = g_dir_make_tmp("libdnf-cookie-XXXXXX", &error);
+    g_assert_no_error(error);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "cookie.repo", NULL);
+    ret = g_file_set_contents(repo_fn,
+                              "[cookie]\n"
+                              "name=cookie\n"
+                              "baseurl=http://127.0.0.1/cookie/\n"
+                              "enabled=1\n"
+                              "gpgcheck=0\n", -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cache_dir = g_build_filename(tmp_dir, "cache", NULL);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, cache_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    state = dnf_context_get_state(ctx);
+
+    repo_loader = dnf_repo_loader_new(ctx);
+    repo = dnf_repo_loader_get_repo_by_id(repo_loader, "cookie", &error);
+    g_assert_no_error(error);
+    g_assert(repo != NULL);
+    g_assert_cmpint(dnf_repo_get_kind(repo), ==, DNF_REPO_KIND_REMOTE);
+
+    src_dir = dnf_test_get_filename("modules/modules/httpd-2.4-2/x86_64/repodata");
+    repodata_dir = g_build_filename(dnf_repo_get_location(repo), "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_dir, repodata_dir);
+
+    /* the first check verifies the checksums and writes the cookie */
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cookie_fn = g_build_filename(repodata_dir, ".verified", NULL);
+    ret = g_file_get_contents(cookie_fn, &cookie, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* the cookie is reused while the files keep their inode, size and mtime,
+     * even a file damaged behind our back is not hashed again */
+    primary = g_strdup(dnf_repo_get_filename_md(repo, "primary"));
+    g_assert(primary != NULL);
+    ret = g_file_get_contents(primary, &primary_orig, &primary_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(stat(primary, &st), ==, 0);
+    fd = open(primary, O_WRONLY);
+    g_assert_cmpint(fd, !=, -1);
+    g_assert_cmpint(write(fd, "damaged", 7), ==, 7);
+    g_assert_cmpint(close(fd), ==, 0);
+    struct timespec times[2] = { st.st_atim, st.st_mtim };
+    g_assert_cmpint(utimensat(AT_FDCWD, primary, times, 0), ==, 0);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* a changed mtime invalidates the cookie, the checksums are verified */
+    times[1].tv_sec += 1;
+    g_assert_cmpint(utimensat(AT_FDCWD, primary, times, 0), ==, 0);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_REPO_NOT_AVAILABLE);
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* a good file is verified and gets a new cookie */
+    ret = g_file_set_contents(primary, primary_orig, primary_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    ret = g_file_get_contents(cookie_fn, &cookie_new, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpstr(cookie, !=, cookie_new);
+
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
+static void
+dnf_repo_update_after_verified_cookie_func(void)
+{
+    DnfRepo *repo;
+    DnfState *state;
+    gboolean ret;
+    int fd;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *repo_data = NULL;
+    g_autofree gchar *served_dir = NULL;
+    g_autofree gchar *served_repodata_dir = NULL;
+    g_autofree gchar *mirrorlist_fn = NULL;
+    g_autofree gchar *mirrorlist = NULL;
+    g_autofree gchar *cache_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *repodata_dir = NULL;
+    g_autofree gchar *repomd = NULL;
+    g_autofree gchar *cookie_fn = NULL;
+    g_autofree gchar *primary_basename = NULL;
+    g_autofree gchar *served_primary = NULL;
+    g_autofree gchar *primary_orig = NULL;
+    gsize primary_len;
+
+    /* the repo is served from a directory, the mirrorlist keeps it a remote
+     * repo with its metadata cached apart */
+    tmp_dir = g_dir_make_tmp("libdnf-cookie-XXXXXX", &error);
+    g_assert_no_error(error);
+    src_dir = dnf_test_get_filename("modules/modules/httpd-2.4-2/x86_64/repodata");
+    served_dir = g_build_filename(tmp_dir, "served", NULL);
+    served_repodata_dir = g_build_filename(served_dir, "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(served_repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_dir, served_repodata_dir);
+    mirrorlist_fn = g_build_filename(tmp_dir, "mirrorlist", NULL);
+    mirrorlist = g_strdup_printf("file://%s/\n", served_dir);
+    ret = g_file_set_contents(mirrorlist_fn, mirrorlist, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "cookie.repo", NULL);
+    repo_data = g_strdup_printf("[cookie]\n"
+                                "name=cookie\n"
+                                "mirrorlist=file://%s\n"
+                                "enabled=1\n"
+                                "gpgcheck=0\n", mirrorlist_fn);
+    ret = g_file_set_contents(repo_fn, repo_data, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cache_dir = g_build_filename(tmp_dir, "cache", NULL);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, cache_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    state = dnf_context_get_state(ctx);
+
+    repo_loader = dnf_repo_loader_new(ctx);
+    repo = dnf_repo_loader_get_repo_by_id(repo_loader, "cookie", &error);
+    g_assert_no_error(error);
+    g_assert(repo != NULL);
+    g_assert_cmpint(dnf_repo_get_kind(repo), ==, DNF_REPO_KIND_REMOTE);
+
+    /* a cache downloaded an hour ago */
+    repodata_dir = g_build_filename(dnf_repo_get_location(repo), "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_dir, repodata_dir);
+    repomd = g_build_filename(repodata_dir, "repomd.xml", NULL);
+    struct timespec times[2] = { { time(NULL) - 3600, 0 }, { time(NULL) - 3600, 0 } };
+    g_assert_cmpint(utimensat(AT_FDCWD, repomd, times, 0), ==, 0);
+
+    /* the first check writes the cookie, the second one finds it and
+     * finds the cache too old */
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cookie_fn = g_build_filename(repodata_dir, ".verified", NULL);
+    g_assert(g_file_test(cookie_fn, G_FILE_TEST_EXISTS));
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, 60, state, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_INTERNAL_ERROR);
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* the update verifies the checksums of the downloaded metadata */
+    primary_basename = g_path_get_basename(dnf_repo_get_filename_md(repo, "primary"));
+    served_primary = g_build_filename(served_repodata_dir, primary_basename, NULL);
+    ret = g_file_get_contents(served_primary, &primary_orig, &primary_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    fd = open(served_primary, O_WRONLY);
+    g_assert_cmpint(fd, !=, -1);
+    g_assert_cmpint(write(fd, "damaged", 7), ==, 7);
+    g_assert_cmpint(close(fd), ==, 0);
+    dnf_state_reset(state);
+    ret = dnf_repo_update(repo, DNF_REPO_UPDATE_FLAG_FORCE, state, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_CANNOT_FETCH_SOURCE);
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* good metadata are downloaded */
+    ret = g_file_set_contents(served_primary, primary_orig, primary_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_repo_update(repo, DNF_REPO_UPDATE_FLAG_FORCE, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
+/* the first failure of checking the packages of @goal one by one */
+static GError *
+gpgcheck_serial_error(DnfTransaction *transaction, HyGoal goal)
+{
+    GError *error = NULL;
+    g_autoptr(GPtrArray) install = NULL;
+
+    install = dnf_goal_get_packages(goal,
+                                    DNF_PACKAGE_INFO_INSTALL,
+                                    DNF_PACKAGE_INFO_REINSTALL,
+                                    DNF_PACKAGE_INFO_DOWNGRADE,
+                                    DNF_PACKAGE_INFO_UPDATE,
+                                    -1);
+    for (guint i = 0; i < install->len; i++) {
+        DnfPackage *pkg = g_ptr_array_index(install, i);
+        if (!dnf_transaction_gpgcheck_package(transaction, pkg, &error))
+            break;
+    }
+    return error;
+}
+
+static void
+dnf_transaction_gpgcheck_func(void)
+{
+    gboolean ret;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GError) serial_error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autoptr(DnfSack) sack = NULL;
+    g_autoptr(DnfTransaction) transaction = NULL;
+    g_autoptr(DnfPackage) pkg_unsigned = NULL;
+    g_autoptr(DnfPackage) pkg_tour = NULL;
+    g_autoptr(DnfPackage) pkg_kernel_doc = NULL;
+    g_autoptr(GPtrArray) repos = NULL;
+    HyGoal goal;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *key_src = NULL;
+    g_autofree gchar *key_dir = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *repo_data = NULL;
+    g_autofree gchar *unsigned_fn = NULL;
+    g_autofree gchar *tour_fn = NULL;
+    g_autofree gchar *kernel_doc_fn = NULL;
+    g_autofree gchar *kernel_doc_orig = NULL;
+    gsize kernel_doc_len;
+
+    /* the signed packages and the test key are in a local repo */
+    tmp_dir = g_dir_make_tmp("libdnf-gpgcheck-XXXXXX", &error);
+    g_assert_no_error(error);
+    src_dir = dnf_test_get_filename("gpgcheck");
+    copy_dir_files(src_dir, tmp_dir);
+    key_src = dnf_test_get_filename("gpgkey");
+    key_dir = g_build_filename(tmp_dir, "gpgkey", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(key_dir, 0755), ==, 0);
+    copy_dir_files(key_src, key_dir);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "gpgcheck.repo", NULL);
+    repo_data = g_strdup_printf("[gpgcheck]\n"
+                                "name=gpgcheck\n"
+                                "baseurl=file://%s/gpgkey\n"
+                                "enabled=1\n"
+                                "gpgcheck=1\n"
+                                "gpgkey=file://%s/gpgkey/signing_key.pub\n",
+                                tmp_dir, tmp_dir);
+    ret = g_file_set_contents(repo_fn, repo_data, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, tmp_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    dnf_context_set_write_history(ctx, FALSE);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    repo_loader = dnf_repo_loader_new(ctx);
+    repos = dnf_repo_loader_get_repos(repo_loader, &error);
+    g_assert_no_error(error);
+    g_assert(repos != NULL);
+
+    transaction = dnf_transaction_new(ctx);
+    dnf_transaction_set_repos(transaction, repos);
+    dnf_transaction_set_flags(transaction, DNF_TRANSACTION_FLAG_ONLY_TRUSTED);
+    ret = dnf_transaction_import_keys(transaction, &error);
+    if (g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+        g_debug("skipping tests: %s", error->message);
+        dnf_remove_recursive(tmp_dir, NULL);
+        return;
+    }
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* an unsigned package between the signed ones */
+    sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, tmp_dir);
+    ret = dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    unsigned_fn = dnf_test_get_filename("hawkey/yum/mystery-devel-19.67-1.noarch.rpm");
+    tour_fn = g_build_filename(tmp_dir, "tour-4-6.noarch.rpm", NULL);
+    kernel_doc_fn = g_build_filename(tmp_dir, "kernel-doc-3.10.0-514.noarch.rpm", NULL);
+    pkg_unsigned = dnf_sack_add_cmdline_package(sack, unsigned_fn);
+    pkg_tour = dnf_sack_add_cmdline_package(sack, tour_fn);
+    pkg_kernel_doc = dnf_sack_add_cmdline_package(sack, kernel_doc_fn);
+    g_assert(pkg_unsigned != NULL);
+    g_assert(pkg_tour != NULL);
+    g_assert(pkg_kernel_doc != NULL);
+
+    /* the signed packages pass */
+    goal = hy_goal_create(sack);
+    hy_goal_install(goal, pkg_tour);
+    hy_goal_install(goal, pkg_kernel_doc);
+    g_assert_cmpint(hy_goal_run_flags(goal, DNF_NONE), ==, 0);
+    ret = dnf_transaction_check_untrusted(transaction, goal, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    hy_goal_free(goal);
+
+    /* the unsigned one fails */
+    goal = hy_goal_create(sack);
+    hy_goal_install(goal, pkg_tour);
+    hy_goal_install(goal, pkg_unsigned);
+    hy_goal_install(goal, pkg_kernel_doc);
+    g_assert_cmpint(hy_goal_run_flags(goal, DNF_NONE), ==, 0);
+    ret = dnf_transaction_check_untrusted(transaction, goal, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_GPG_SIGNATURE_INVALID);
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* with an unreadable signed package too, the error of the package
+     * coming first is reported, the same as when checking one by one */
+    ret = g_file_get_contents(kernel_doc_fn, &kernel_doc_orig, &kernel_doc_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(g_unlink(kernel_doc_fn), ==, 0);
+    serial_error = gpgcheck_serial_error(transaction, goal);
+    g_assert(serial_error != NULL);
+    ret = dnf_transaction_check_untrusted(transaction, goal, &error);
+    g_assert(!ret);
+    g_assert(error != NULL);
+    g_assert_cmpint(error->code, ==, serial_error->code);
+    g_assert_cmpstr(error->message, ==, serial_error->message);
+    g_clear_error(&error);
+    hy_goal_free(goal);
+
+    /* once readable again, the signed packages pass again */
+    ret = g_file_set_contents(kernel_doc_fn, kernel_doc_orig, kernel_doc_len, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    goal = hy_goal_create(sack);
+    hy_goal_install(goal, pkg_kernel_doc);
+    hy_goal_install(goal, pkg_tour);
+    g_assert_cmpint(hy_goal_run_flags(goal, DNF_NONE), ==, 0);
+    ret = dnf_transaction_check_untrusted(transaction, goal, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    hy_goal_free(goal);
+
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
+/* the package @name of @repo, with the repo set */
+static DnfPackage *
+check_filename_get_package(DnfSack *sack, DnfRepo *repo, const gchar *name)
+{
+    HyQuery query;
+    DnfPackage *pkg;
+    g_autoptr(GPtrArray) pkglist = NULL;
+
+    query = hy_query_create(sack);
+    hy_query_filter(query, HY_PKG_REPONAME, HY_EQ, dnf_repo_get_id(repo));
+    hy_query_filter(query, HY_PKG_NAME, HY_EQ, name);
+    pkglist = hy_query_run(query);
+    hy_query_free(query);
+    g_assert_cmpint(pkglist->len, ==, 1);
+    pkg = g_object_ref(g_ptr_array_index(pkglist, 0));
+    dnf_package_set_repo(pkg, repo);
+    return pkg;
+}
+
+/* checks @packages at once and one by one, the results must be the same */
+static gboolean
+check_filename_compare(GPtrArray *packages, gboolean *valid, GError **error)
+{
+    gboolean ret;
+    gboolean ret_serial = TRUE;
+    g_autoptr(GError) error_serial = NULL;
+
+    ret = dnf_package_array_check_filename(packages, valid, error);
+    for (guint i = 0; i < packages->len; i++) {
+        DnfPackage *pkg = g_ptr_array_index(packages, i);
+        gboolean valid_serial;
+        ret_serial = dnf_package_check_filename(pkg, &valid_serial, &error_serial);
+        if (!ret_serial)
+            break;
+        g_assert_cmpint(valid[i], ==, valid_serial);
+    }
+    g_assert_cmpint(ret, ==, ret_serial);
+    if (!ret) {
+        g_assert(error == NULL || *error != NULL);
+        if (error != NULL) {
+            g_assert_cmpint((*error)->code, ==, error_serial->code);
+            g_assert_cmpstr((*error)->message, ==, error_serial->message);
+        }
+    }
+    return ret;
+}
+
+static void
+dnf_package_array_check_filename_func(void)
+{
+    DnfRepo *repo_local;
+    DnfRepo *repo_remote;
+    DnfState *state;
+    gboolean ret;
+    gboolean valid[3];
+    g_autoptr(GError) error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autoptr(DnfSack) sack = NULL;
+    g_autoptr(GPtrArray) packages = NULL;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *src_repodata_dir = NULL;
+    g_autofree gchar *served_dir = NULL;
+    g_autofree gchar *served_repodata_dir = NULL;
+    g_autofree gchar *mirrorlist_fn = NULL;
+    g_autofree gchar *mirrorlist = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *repo_data = NULL;
+    g_autofree gchar *cache_dir = NULL;
+    g_autofree gchar *repodata_dir = NULL;
+    g_autofree gchar *fn = NULL;
+    const gchar *names[] = { "httpd", "httpd-doc", "libnghttp2" };
+
+    /* the same packages in a local repo and in a remote one */
+    tmp_dir = g_dir_make_tmp("libdnf-check-filename-XXXXXX", &error);
+    g_assert_no_error(error);
+    src_dir = dnf_test_get_filename("modules/modules/httpd-2.4-2/x86_64");
+    src_repodata_dir = g_build_filename(src_dir, "repodata", NULL);
+    served_dir = g_build_filename(tmp_dir, "served", NULL);
+    served_repodata_dir = g_build_filename(served_dir, "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(served_repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_repodata_dir, served_repodata_dir);
+    mirrorlist_fn = g_build_filename(tmp_dir, "mirrorlist", NULL);
+    mirrorlist = g_strdup_printf("file://%s/\n", served_dir);
+    ret = g_file_set_contents(mirrorlist_fn, mirrorlist, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "check-filename.repo", NULL);
+    repo_data = g_strdup_printf("[local]\n"
+                                "name=local\n"
+                                "baseurl=file://%s\n"
+                                "enabled=1\n"
+                                "gpgcheck=0\n"
+                                "[remote]\n"
+                                "name=remote\n"
+                                "mirrorlist=file://%s\n"
+                                "enabled=1\n"
+                                "gpgcheck=0\n", served_dir, mirrorlist_fn);
+    ret = g_file_set_contents(repo_fn, repo_data, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cache_dir = g_build_filename(tmp_dir, "cache", NULL);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, cache_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    state = dnf_context_get_state(ctx);
+
+    repo_loader = dnf_repo_loader_new(ctx);
+    repo_local = dnf_repo_loader_get_repo_by_id(repo_loader, "local", &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(dnf_repo_get_kind(repo_local), ==, DNF_REPO_KIND_LOCAL);
+    repo_remote = dnf_repo_loader_get_repo_by_id(repo_loader, "remote", &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(dnf_repo_get_kind(repo_remote), ==, DNF_REPO_KIND_REMOTE);
+    repodata_dir = g_build_filename(dnf_repo_get_location(repo_remote), "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_repodata_dir, repodata_dir);
+
+    sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, cache_dir);
+    ret = dnf_sack_set_arch(sack, "x86_64", &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    ret = dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo_local, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_sack_add_repo(sack, repo_local, G_MAXUINT, DNF_SACK_ADD_FLAG_NONE, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo_remote, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_sack_add_repo(sack, repo_remote, G_MAXUINT, DNF_SACK_ADD_FLAG_NONE, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* httpd is valid, httpd-doc is damaged and libnghttp2 is missing */
+    g_assert_cmpint(g_mkdir_with_parents(dnf_repo_get_packages(repo_remote), 0755), ==, 0);
+    for (guint i = 0; i < 2; i++) {
+        g_autofree gchar *src = NULL;
+        g_autofree gchar *contents = NULL;
+        gsize length;
+        g_autoptr(DnfPackage) pkg = check_filename_get_package(sack, repo_local, names[i]);
+        g_autofree gchar *basename = g_path_get_basename(dnf_package_get_location(pkg));
+        src = g_build_filename(src_dir, basename, NULL);
+        ret = g_file_get_contents(src, &contents, &length, &error);
+        g_assert_no_error(error);
+        g_assert(ret);
+        if (i == 1)
+            contents[length / 2] ^= 0xff;
+        g_free(fn);
+        fn = g_build_filename(served_dir, basename, NULL);
+        ret = g_file_set_contents(fn, contents, length, &error);
+        g_assert_no_error(error);
+        g_assert(ret);
+        g_free(fn);
+        fn = g_build_filename(dnf_repo_get_packages(repo_remote), basename, NULL);
+        ret = g_file_set_contents(fn, contents, length, &error);
+        g_assert_no_error(error);
+        g_assert(ret);
+    }
+
+    /* a remote package can be downloaded again, only the valid one is valid */
+    packages = g_ptr_array_new_with_free_func((GDestroyNotify) g_object_unref);
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++)
+        g_ptr_array_add(packages, check_filename_get_package(sack, repo_remote, names[i]));
+    ret = check_filename_compare(packages, valid, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert(valid[0]);
+    g_assert(!valid[1]);
+    g_assert(!valid[2]);
+    g_ptr_array_set_size(packages, 0);
+
+    /* a local package cannot, the first failing one is reported */
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++)
+        g_ptr_array_add(packages, check_filename_get_package(sack, repo_local, names[i]));
+    ret = check_filename_compare(packages, valid, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_INTERNAL_ERROR);
+    g_assert(g_str_has_prefix(error->message, "Checksum mismatch"));
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* the missing one when it comes first */
+    g_ptr_array_remove_index(packages, 1);
+    g_ptr_array_remove_index(packages, 0);
+    g_ptr_array_add(packages, check_filename_get_package(sack, repo_local, "httpd-doc"));
+    ret = check_filename_compare(packages, valid, &error);
+    g_assert_error(error, DNF_ERROR, DNF_ERROR_INTERNAL_ERROR);
+    g_assert(g_str_has_prefix(error->message, "File missing"));
+    g_assert(!ret);
+    g_clear_error(&error);
+
+    /* and none for the valid one */
+    g_ptr_array_set_size(packages, 0);
+    g_ptr_array_add(packages, check_filename_get_package(sack, repo_local, "httpd"));
+    ret = check_filename_compare(packages, valid, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert(valid[0]);
+
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
+typedef struct {
+    const gchar *directory;
+    GHashTable *ready;
+} DownloadReadyData;
+
+static void
+download_ready_cb(DnfPackage *pkg, const gchar *filename, gpointer user_data)
+{
+    DownloadReadyData *data = user_data;
+    const gchar *name = dnf_package_get_name(pkg);
+    g_autofree gchar *basename = g_path_get_basename(dnf_package_get_location(pkg));
+    g_autofree gchar *expected = g_build_filename(data->directory, basename, NULL);
+
+    g_assert_cmpstr(filename, ==, expected);
+    g_assert(g_file_test(filename, G_FILE_TEST_EXISTS));
+    g_hash_table_insert(data->ready, (gpointer) name,
+                        GUINT_TO_POINTER(GPOINTER_TO_UINT(g_hash_table_lookup(data->ready, name)) + 1));
+}
+
+static void
+dnf_repo_download_ready_func(void)
+{
+    DnfRepo *repo;
+    DnfState *state;
+    gboolean ret;
+    DownloadReadyData data;
+    HyQuery query;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autoptr(DnfSack) sack = NULL;
+    g_autoptr(GPtrArray) packages = NULL;
+    g_autoptr(GHashTable) ready = NULL;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *src_repodata_dir = NULL;
+    g_autofree gchar *mirrorlist_fn = NULL;
+    g_autofree gchar *mirrorlist = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *repo_data = NULL;
+    g_autofree gchar *cache_dir = NULL;
+    g_autofree gchar *repodata_dir = NULL;
+    g_autofree gchar *download_dir = NULL;
+
+    /* the packages are served through a mirrorlist, so they are downloaded */
+    tmp_dir = g_dir_make_tmp("libdnf-download-XXXXXX", &error);
+    g_assert_no_error(error);
+    src_dir = dnf_test_get_filename("modules/modules/httpd-2.4-2/x86_64");
+    src_repodata_dir = g_build_filename(src_dir, "repodata", NULL);
+    mirrorlist_fn = g_build_filename(tmp_dir, "mirrorlist", NULL);
+    mirrorlist = g_strdup_printf("file://%s/\n", src_dir);
+    ret = g_file_set_contents(mirrorlist_fn, mirrorlist, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "download.repo", NULL);
+    repo_data = g_strdup_printf("[download]\n"
+                                "name=download\n"
+                                "mirrorlist=file://%s\n"
+                                "enabled=1\n"
+                                "gpgcheck=0\n", mirrorlist_fn);
+    ret = g_file_set_contents(repo_fn, repo_data, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cache_dir = g_build_filename(tmp_dir, "cache", NULL);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, cache_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    state = dnf_context_get_state(ctx);
+
+    repo_loader = dnf_repo_loader_new(ctx);
+    repo = dnf_repo_loader_get_repo_by_id(repo_loader, "download", &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(dnf_repo_get_kind(repo), ==, DNF_REPO_KIND_REMOTE);
+    repodata_dir = g_build_filename(dnf_repo_get_location(repo), "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_repodata_dir, repodata_dir);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, cache_dir);
+    ret = dnf_sack_set_arch(sack, "x86_64", &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    ret = dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_sack_add_repo(sack, repo, G_MAXUINT, DNF_SACK_ADD_FLAG_NONE, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    query = hy_query_create(sack);
+    hy_query_filter(query, HY_PKG_REPONAME, HY_EQ, dnf_repo_get_id(repo));
+    packages = hy_query_run(query);
+    hy_query_free(query);
+    g_assert_cmpint(packages->len, ==, 3);
+
+    /* each package is reported once, as soon as it is downloaded */
+    download_dir = g_build_filename(tmp_dir, "download", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(download_dir, 0755), ==, 0);
+    data.directory = download_dir;
+    data.ready = ready = g_hash_table_new(g_str_hash, g_str_equal);
+    dnf_state_reset(state);
+    ret = dnf_repo_download_packages_full(repo, packages, download_dir,
+                                          download_ready_cb, &data, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(g_hash_table_size(ready), ==, packages->len);
+    for (guint i = 0; i < packages->len; i++) {
+        DnfPackage *pkg = g_ptr_array_index(packages, i);
+        g_assert_cmpint(GPOINTER_TO_UINT(g_hash_table_lookup(ready, dnf_package_get_name(pkg))), ==, 1);
+    }
+
+    /* and once again when it is already downloaded */
+    g_hash_table_remove_all(ready);
+    dnf_state_reset(state);
+    ret = dnf_repo_download_packages_full(repo, packages, download_dir,
+                                          download_ready_cb, &data, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(g_hash_table_size(ready), ==, packages->len);
+    for (guint i = 0; i < packages->len; i++) {
+        DnfPackage *pkg = g_ptr_array_index(packages, i);
+        g_assert_cmpint(GPOINTER_TO_UINT(g_hash_table_lookup(ready, dnf_package_get_name(pkg))), ==, 1);
+    }
+
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
+typedef struct {
+    guint last;
+    guint decreased;
+} DeltaProgressData;
+
+static void
+delta_percentage_changed_cb(DnfState *state, guint value, gpointer user_data)
+{
+    DeltaProgressData *data = user_data;
+    if (value < data->last)
+        data->decreased++;
+    data->last = value;
+}
+
+static void
+delta_log_cb(const gchar *log_domain, GLogLevelFlags log_level,
+             const gchar *message, gpointer user_data)
+{
+    DeltaProgressData *data = user_data;
+    if (strstr(message, "should not go down") != NULL)
+        data->decreased++;
+}
+
+static void
+delta_copy_file(const gchar *src, const gchar *dst)
+{
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *contents = NULL;
+    gsize length;
+    g_assert(g_file_get_contents(src, &contents, &length, &error));
+    g_assert(g_file_set_contents(dst, contents, length, &error));
+}
+
+static void
+dnf_repo_download_deltas_func(void)
+{
+    DnfRepo *repo;
+    DnfState *state;
+    HyRepo system_repo;
+    HyQuery query;
+    gboolean ret;
+    guint log_handler;
+    DownloadReadyData data;
+    DeltaProgressData progress = { 0, };
+    g_autoptr(GError) error = NULL;
+    g_autoptr(DnfContext) ctx = NULL;
+    g_autoptr(DnfRepoLoader) repo_loader = NULL;
+    g_autoptr(DnfSack) sack = NULL;
+    g_autoptr(GPtrArray) packages = NULL;
+    g_autoptr(GHashTable) ready = NULL;
+    g_autofree gchar *tmp_dir = NULL;
+    g_autofree gchar *src_dir = NULL;
+    g_autofree gchar *src_repodata_dir = NULL;
+    g_autofree gchar *src_drpms_dir = NULL;
+    g_autofree gchar *src_rpm = NULL;
+    g_autofree gchar *system_repomd = NULL;
+    g_autofree gchar *system_primary = NULL;
+    g_autofree gchar *served_dir = NULL;
+    g_autofree gchar *served_repodata_dir = NULL;
+    g_autofree gchar *served_drpms_dir = NULL;
+    g_autofree gchar *served_rpm = NULL;
+    g_autofree gchar *served_drpm = NULL;
+    g_autofree gchar *mirrorlist_fn = NULL;
+    g_autofree gchar *mirrorlist = NULL;
+    g_autofree gchar *repos_dir = NULL;
+    g_autofree gchar *repo_fn = NULL;
+    g_autofree gchar *repo_data = NULL;
+    g_autofree gchar *cache_dir = NULL;
+    g_autofree gchar *repodata_dir = NULL;
+    g_autofree gchar *download_dir = NULL;
+    g_autofree gchar *downloaded_rpm = NULL;
+
+    /* the packages are rebuilt only by the tool from the deltarpm package */
+    if (!g_file_test("/usr/bin/applydeltarpm", G_FILE_TEST_IS_EXECUTABLE)) {
+        g_debug("skipping tests: applydeltarpm is not available");
+        return;
+    }
+
+    /* the repo is served through a mirrorlist, local repos never use deltas */
+    tmp_dir = g_dir_make_tmp("libdnf-deltas-XXXXXX", &error);
+    g_assert_no_error(error);
+    src_dir = dnf_test_get_filename("deltas/repo");
+    src_repodata_dir = g_build_filename(src_dir, "repodata", NULL);
+    src_drpms_dir = g_build_filename(src_dir, "drpms", NULL);
+    src_rpm = g_build_filename(src_dir, "tour-4-6.noarch.rpm", NULL);
+    served_dir = g_build_filename(tmp_dir, "served", NULL);
+    served_repodata_dir = g_build_filename(served_dir, "repodata", NULL);
+    served_drpms_dir = g_build_filename(served_dir, "drpms", NULL);
+    served_rpm = g_build_filename(served_dir, "tour-4-6.noarch.rpm", NULL);
+    served_drpm = g_build_filename(served_drpms_dir, "tour-4-5_4-6.noarch.drpm", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(served_repodata_dir, 0755), ==, 0);
+    g_assert_cmpint(g_mkdir_with_parents(served_drpms_dir, 0755), ==, 0);
+    copy_dir_files(src_repodata_dir, served_repodata_dir);
+    copy_dir_files(src_drpms_dir, served_drpms_dir);
+    delta_copy_file(src_rpm, served_rpm);
+    mirrorlist_fn = g_build_filename(tmp_dir, "mirrorlist", NULL);
+    mirrorlist = g_strdup_printf("file://%s/\n", served_dir);
+    ret = g_file_set_contents(mirrorlist_fn, mirrorlist, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    repos_dir = g_build_filename(tmp_dir, "yum.repos.d", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repos_dir, 0755), ==, 0);
+    repo_fn = g_build_filename(repos_dir, "deltas.repo", NULL);
+    repo_data = g_strdup_printf("[deltas]\n"
+                                "name=deltas\n"
+                                "mirrorlist=file://%s\n"
+                                "enabled=1\n"
+                                "gpgcheck=0\n", mirrorlist_fn);
+    ret = g_file_set_contents(repo_fn, repo_data, -1, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    cache_dir = g_build_filename(tmp_dir, "cache", NULL);
+
+    ctx = dnf_context_new();
+    dnf_context_set_repo_dir(ctx, repos_dir);
+    dnf_context_set_solv_dir(ctx, "/tmp");
+    dnf_context_set_cache_dir(ctx, cache_dir);
+    dnf_context_set_lock_dir(ctx, tmp_dir);
+    ret = dnf_context_setup(ctx, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    state = dnf_context_get_state(ctx);
+
+    repo_loader = dnf_repo_loader_new(ctx);
+    repo = dnf_repo_loader_get_repo_by_id(repo_loader, "deltas", &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(dnf_repo_get_kind(repo), ==, DNF_REPO_KIND_REMOTE);
+    dnf_repo_add_metadata_type_to_download(repo, "prestodelta");
+    repodata_dir = g_build_filename(dnf_repo_get_location(repo), "repodata", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(repodata_dir, 0755), ==, 0);
+    copy_dir_files(src_repodata_dir, repodata_dir);
+    dnf_state_reset(state);
+    ret = dnf_repo_check(repo, G_MAXUINT, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* the presto metadata is not requested, the download loads it */
+    sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, cache_dir);
+    ret = dnf_sack_set_arch(sack, "x86_64", &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    ret = dnf_sack_setup(sack, DNF_SACK_SETUP_FLAG_MAKE_CACHE_DIR, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    dnf_state_reset(state);
+    ret = dnf_sack_add_repo(sack, repo, G_MAXUINT, DNF_SACK_ADD_FLAG_NONE, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* the old version the delta applies to, its files are not installed */
+    system_repomd = dnf_test_get_filename("deltas/system/repodata/repomd.xml");
+    system_primary = dnf_test_get_filename("deltas/system/repodata/primary.xml");
+    system_repo = hy_repo_create(HY_SYSTEM_REPO_NAME);
+    hy_repo_set_string(system_repo, HY_REPO_MD_FN, system_repomd);
+    hy_repo_set_string(system_repo, HY_REPO_PRIMARY_FN, system_primary);
+    ret = dnf_sack_load_repo(sack, system_repo, DNF_SACK_LOAD_FLAG_NONE, &error);
+    hy_repo_free(system_repo);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    query = hy_query_create(sack);
+    hy_query_filter(query, HY_PKG_REPONAME, HY_EQ, dnf_repo_get_id(repo));
+    packages = hy_query_run(query);
+    hy_query_free(query);
+    g_assert_cmpint(packages->len, ==, 1);
+
+    download_dir = g_build_filename(tmp_dir, "download", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(download_dir, 0755), ==, 0);
+    downloaded_rpm = g_build_filename(download_dir, "tour-4-6.noarch.rpm", NULL);
+    data.directory = download_dir;
+    data.ready = ready = g_hash_table_new(g_str_hash, g_str_equal);
+    dnf_state_set_enable_profile(state, TRUE);
+    g_signal_connect(state, "percentage-changed", G_CALLBACK(delta_percentage_changed_cb), &progress);
+    log_handler = g_log_set_handler(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, delta_log_cb, &progress);
+
+    /* the delta rpm is downloaded but cannot be rebuilt, the package is downloaded in full */
+    dnf_state_reset(state);
+    progress.last = 0;
+    ret = dnf_repo_download_packages_full(repo, packages, download_dir,
+                                          download_ready_cb, &data, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(g_hash_table_size(ready), ==, 1);
+    g_assert_cmpint(GPOINTER_TO_UINT(g_hash_table_lookup(ready, "tour")), ==, 1);
+    g_assert(g_file_test(downloaded_rpm, G_FILE_TEST_EXISTS));
+    g_assert_cmpint(progress.decreased, ==, 0);
+
+    /* the delta rpm fails to download, the other downloads go on and the package
+     * is downloaded in full */
+    g_assert_cmpint(g_unlink(served_drpm), ==, 0);
+    g_assert_cmpint(g_unlink(downloaded_rpm), ==, 0);
+    g_hash_table_remove_all(ready);
+    dnf_state_reset(state);
+    progress.last = 0;
+    ret = dnf_repo_download_packages_full(repo, packages, download_dir,
+                                          download_ready_cb, &data, state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+    g_assert_cmpint(g_hash_table_size(ready), ==, 1);
+    g_assert_cmpint(GPOINTER_TO_UINT(g_hash_table_lookup(ready, "tour")), ==, 1);
+    g_assert(g_file_test(downloaded_rpm, G_FILE_TEST_EXISTS));
+    g_assert_cmpint(progress.decreased, ==, 0);
+
+    g_log_remove_handler(G_LOG_DOMAIN, log_handler);
+    g_signal_handlers_disconnect_by_data(state, &progress);
+    dnf_state_set_enable_profile(state, FALSE);
+    dnf_remove_recursive(tmp_dir, &error);
+    g_assert_no_error(error);
+}
+
 static void
 touch_file(const char *filename)
 {
@@ -1211,6 +2211,12 @@ main(int argc, char **argv)
     g_test_add_func("/libdnf/repo_loader", dnf_repo_loader_func);
     g_test_add_func("/libdnf/repo_loader{gpg-no-pubkey}", dnf_repo_loader_gpg_no_pubkey_func);
     g_test_add_func("/libdnf/repo_loader{cache-dir-check}", dnf_repo_loader_cache_dir_check_func);
+    g_test_add_func("/libdnf/repo{verified-cookie}", dnf_repo_check_verified_cookie_func);
+    g_test_add_func("/libdnf/repo{update-after-verified-cookie}", dnf_repo_update_after_verified_cookie_func);
+    g_test_add_func("/libdnf/transaction{gpgcheck}", dnf_transaction_gpgcheck_func);
+    g_test_add_func("/libdnf/package{array-check-filename}", dnf_package_array_check_filename_func);
+    g_test_add_func("/libdnf/repo{download-ready-func}", dnf_repo_download_ready_func);
+    g_test_add_func("/libdnf/repo{download-deltas}", dnf_repo_download_deltas_func);
     g_test_add_func("/libdnf/context", dnf_context_func);
     g_test_add_func("/libdnf/context{cache-clean-check}", dnf_context_cache_clean_check_func);
     g_test_add_func("/libdnf/lock", dnf_lock_func);
@@ -4,8 +4,18 @@ CPPUNIT_TEST_SUITE_REGISTRATION(ModulePackageContainerTest);
 
 #include "libdnf/log.hpp"
 #include "libdnf/dnf-sack-private.hpp"
+#include "libdnf/sack/packageset.hpp"
 
 #include <algorithm>
+#include <memory>
+
+static bool
+samePackages(const libdnf::PackageSet & first, const libdnf::PackageSet & second)
+{
+    libdnf::PackageSet difference(first);
+    difference -= second;
+    return first.size() == second.size() && difference.size() == 0;
+}
 
 void ModulePackageContainerTest::setUp()
 {
@@ -149,3 +159,63 @@ void ModulePackageContainerTest::testRemoveProfile()
 
     modules->save();
 }
+
+void ModulePackageContainerTest::testExcludesFollowContainer()
+{
+    const char * hotfixRepos[] = {nullptr};
+    auto sack = dnf_context_get_sack(context);
+
+    dnf_sack_filter_modules_v2(sack, modules, hotfixRepos, TESTDATADIR "/modules/", "platform:26",
+                               true, false);
+    std::unique_ptr<DnfPackageSet> excludes(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(excludes && excludes->size() > 0);
+
+    // a container without modules excludes nothing
+    libdnf::ModulePackageContainer empty(dnf_sack_get_all_arch(sack), TESTDATADIR "/modules/",
+                                         dnf_sack_get_arch(sack));
+    auto previous = dnf_sack_set_module_container(sack, &empty);
+    dnf_sack_filter_modules_v2(sack, &empty, hotfixRepos, TESTDATADIR "/modules/", "platform:26",
+                               true, false);
+    std::unique_ptr<DnfPackageSet> emptyExcludes(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(!emptyExcludes || emptyExcludes->size() == 0);
+
+    dnf_sack_set_module_container(sack, previous);
+    dnf_sack_filter_modules_v2(sack, modules, hotfixRepos, TESTDATADIR "/modules/", "platform:26",
+                               true, false);
+    std::unique_ptr<DnfPackageSet> restored(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(restored && samePackages(*excludes, *restored));
+}
+
+void ModulePackageContainerTest::testExcludesOfRefilledContainer()
+{
+    const char * hotfixRepos[] = {nullptr};
+    auto sack = dnf_context_get_sack(context);
+
+    dnf_sack_filter_modules_v2(sack, modules, hotfixRepos, TESTDATADIR "/modules/", "platform:26",
+                               true, false);
+    std::unique_ptr<DnfPackageSet> excludes(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(excludes && excludes->size() > 0);
+
+    // the same modules in another container give the same excludes
+    std::unique_ptr<libdnf::ModulePackageContainer> refilled(new libdnf::ModulePackageContainer(
+        dnf_sack_get_all_arch(sack), TESTDATADIR "/modules/", dnf_sack_get_arch(sack)));
+    auto previous = dnf_sack_set_module_container(sack, refilled.get());
+    dnf_sack_filter_modules_v2(sack, refilled.get(), hotfixRepos, TESTDATADIR "/modules/",
+                               "platform:26", false, false);
+    std::unique_ptr<DnfPackageSet> refilledExcludes(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(refilledExcludes && samePackages(*excludes, *refilledExcludes));
+
+    // the artifacts of the disabled stream are excluded in addition
+    refilled->disable("httpd");
+    dnf_sack_filter_modules_v2(sack, refilled.get(), hotfixRepos, TESTDATADIR "/modules/",
+                               "platform:26", true, false);
+    std::unique_ptr<DnfPackageSet> disabledExcludes(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(disabledExcludes && disabledExcludes->size() > excludes->size());
+
+    dnf_sack_set_module_container(sack, previous);
+    refilled.reset();
+    dnf_sack_filter_modules_v2(sack, modules, hotfixRepos, TESTDATADIR "/modules/", "platform:26",
+                               true, false);
+    std::unique_ptr<DnfPackageSet> restored(dnf_sack_get_module_excludes(sack));
+    CPPUNIT_ASSERT(restored && samePackages(*excludes, *restored));
+}
@@ -0,0 +1,85 @@
+#include "DownloadQueueTest.hpp"
+
+#include "libdnf/dnf-repo.hpp"
+#include "libdnf/hy-package.h"
+#include <libdnf/repo/Repo-private.hpp>
+#include <solv/repo.h>
+
+#include <string>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadQueueTest);
+
+void DownloadQueueTest::setUp()
+{
+    g_autoptr(GError) error = nullptr;
+    sack = dnf_sack_new();
+    repo = hy_repo_create("repo");
+    libdnf::repoGetImpl(repo)->attachLibsolvRepo(repo_create(dnf_sack_get_pool(sack), "repo"));
+    dnf_sack_load_repo(sack, repo, 0, &error);
+    packages = g_ptr_array_new_with_free_func(g_object_unref);
+}
+
+void DownloadQueueTest::tearDown()
+{
+    g_ptr_array_unref(packages);
+    hy_repo_free(repo);
+    g_object_unref(sack);
+}
+
+DnfPackage *DownloadQueueTest::addPackage(const char *name, unsigned long long downloadsize)
+{
+    Pool *pool = dnf_sack_get_pool(sack);
+    Repo *libsolvRepo = libdnf::repoGetImpl(repo)->libsolvRepo;
+
+    Id id = repo_add_solvable(libsolvRepo);
+    Solvable *solvable = pool_id2solvable(pool, id);
+    solvable->name = pool_str2id(pool, name, 1);
+    solvable->evr = pool_str2id(pool, "1.0-1", 1);
+    solvable->arch = pool_str2id(pool, "noarch", 1);
+    solvable_set_num(solvable, SOLVABLE_DOWNLOADSIZE, downloadsize);
+    repo_internalize(libsolvRepo);
+
+    auto pkg = dnf_package_new(sack, id);
+    g_ptr_array_add(packages, pkg);
+    return pkg;
+}
+
+static std::vector<std::string> names(const std::vector<DnfPackage *> &queue)
+{
+    std::vector<std::string> result;
+    for (auto pkg : queue) {
+        result.push_back(dnf_package_get_name(pkg));
+    }
+    return result;
+}
+
+void DownloadQueueTest::testLargestFirst()
+{
+    addPackage("small", 10);
+    addPackage("large", 3000);
+    addPackage("medium", 200);
+    addPackage("huge", 40000);
+
+    auto queue = dnf_repo_get_download_queue(packages);
+    std::vector<std::string> expected{"huge", "large", "medium", "small"};
+    CPPUNIT_ASSERT(expected == names(queue));
+
+    // the array itself is left as it is
+    CPPUNIT_ASSERT_EQUAL(std::string("small"),
+                         std::string(dnf_package_get_name(
+                             static_cast<DnfPackage *>(g_ptr_array_index(packages, 0)))));
+}
+
+void DownloadQueueTest::testEqualSizesKeepOrder()
+{
+    addPackage("first", 100);
+    addPackage("small", 10);
+    addPackage("second", 100);
+    addPackage("large", 1000);
+    addPackage("third", 100);
+
+    auto queue = dnf_repo_get_download_queue(packages);
+    std::vector<std::string> expected{"large", "first", "second", "third", "small"};
+    CPPUNIT_ASSERT(expected == names(queue));
+}
@@ -0,0 +1,33 @@
+#ifndef LIBDNF_DOWNLOADQUEUETEST_HPP
+#define LIBDNF_DOWNLOADQUEUETEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "libdnf/dnf-sack.h"
+#include "libdnf/hy-repo.h"
+
+class DownloadQueueTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(DownloadQueueTest);
+        CPPUNIT_TEST(testLargestFirst);
+        CPPUNIT_TEST(testEqualSizesKeepOrder);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testLargestFirst();
+    void testEqualSizesKeepOrder();
+
+private:
+    DnfPackage *addPackage(const char *name, unsigned long long downloadsize);
+
+    DnfSack *sack;
+    HyRepo repo;
+    GPtrArray *packages;
+};
+
+
+#endif //LIBDNF_DOWNLOADQUEUETEST_HPP
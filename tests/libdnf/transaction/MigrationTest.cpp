@@ -1,3 +1,4 @@
+#include <set>
 #include <string>
 
 #include "libdnf/transaction/Swdb.hpp"
@@ -74,6 +75,21 @@ MigrationTest::testNonEmptyCommentAfterMigration()
     CPPUNIT_ASSERT_EQUAL(trans.getComment(), std::string("Test comment"));
 }
 
+void
+MigrationTest::testIndexesAfterMigration()
+{
+    Swdb swdb(history); // migrate
+    SQLite3::Query query(*history, "select name from sqlite_master where type = 'index' and tbl_name in ('rpm', 'trans_item');");
+    std::set< std::string > indexes;
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        indexes.insert(query.get< std::string >("name"));
+    }
+    CPPUNIT_ASSERT(indexes.count("rpm_name_arch") == 1);
+    CPPUNIT_ASSERT(indexes.count("trans_item_item_id_trans_id") == 1);
+    CPPUNIT_ASSERT(indexes.count("rpm_name") == 0);
+    CPPUNIT_ASSERT(indexes.count("trans_item_item_id") == 0);
+}
+
 void
 MigrationTest::tearDown()
 {
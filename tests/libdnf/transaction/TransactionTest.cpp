@@ -1,6 +1,8 @@
 #include "libdnf/hy-subject.h"
 #include "libdnf/nevra.hpp"
+#include "libdnf/transaction/MergedTransaction.hpp"
 #include "libdnf/transaction/RPMItem.hpp"
+#include "libdnf/transaction/Swdb.hpp"
 #include "libdnf/transaction/Transaction.hpp"
 #include "libdnf/transaction/private/Transaction.hpp"
 #include "libdnf/transaction/Transformer.hpp"
@@ -122,6 +124,31 @@ TransactionTest::testUpdate()
     CPPUNIT_ASSERT_EQUAL(TransactionState::DONE, trans2.getState());
 }
 
+void
+TransactionTest::testConsoleOutput()
+{
+    libdnf::swdb_private::Transaction trans(conn);
+    trans.setState(TransactionState::ERROR);
+
+    // console output can be added only to a saved transaction
+    CPPUNIT_ASSERT_THROW(trans.addConsoleOutputLine(1, "line"), std::runtime_error);
+
+    trans.begin();
+    // more lines than fit into a single batch
+    for (int i = 0; i < 150; ++i) {
+        trans.addConsoleOutputLine(i % 2 + 1, "line " + std::to_string(i));
+    }
+    trans.finish(TransactionState::DONE);
+
+    libdnf::Transaction trans2(conn, trans.getId());
+    auto output = trans2.getConsoleOutput();
+    CPPUNIT_ASSERT_EQUAL((size_t)150, output.size());
+    for (int i = 0; i < 150; ++i) {
+        CPPUNIT_ASSERT_EQUAL(i % 2 + 1, output.at(i).first);
+        CPPUNIT_ASSERT_EQUAL("line " + std::to_string(i), output.at(i).second);
+    }
+}
+
 void
 TransactionTest::testComparison()
 {
@@ -153,3 +180,101 @@ TransactionTest::testComparison()
     second.setRpmdbVersionBegin("0");
     CPPUNIT_ASSERT(first == second);
 }
+
+/// IDs of the items replacing the item
+static std::vector< int64_t >
+replacedByIds(const TransactionItemPtr &item)
+{
+    std::vector< int64_t > result;
+    for (const auto &byItem : item->getReplacedBy()) {
+        result.push_back(byItem->getId());
+    }
+    return result;
+}
+
+void
+TransactionTest::testListTransactions()
+{
+    std::vector< TransactionItemPtr > upgrades;
+    for (int i = 1; i <= 3; ++i) {
+        libdnf::swdb_private::Transaction trans(conn);
+        trans.setDtBegin(i);
+        trans.setDtEnd(i + 1);
+        trans.setRpmdbVersionBegin("begin " + std::to_string(i));
+        trans.setRpmdbVersionEnd("end " + std::to_string(i));
+        trans.setReleasever("26");
+        trans.setUserId(1000);
+        trans.setCmdline("dnf upgrade foo");
+        trans.setState(TransactionState::DONE);
+
+        auto upgraded = trans.addItem(nevraToRPMItem(conn, "foo-" + std::to_string(i) + "-1.noarch"),
+                                      "base",
+                                      TransactionItemAction::UPGRADED,
+                                      TransactionItemReason::USER);
+        auto upgrade = trans.addItem(nevraToRPMItem(conn, "foo-" + std::to_string(i + 1) + "-1.noarch"),
+                                     "updates",
+                                     TransactionItemAction::UPGRADE,
+                                     TransactionItemReason::USER);
+        upgraded->addReplacedBy(upgrade);
+        upgraded->setState(TransactionItemState::DONE);
+        upgrade->setState(TransactionItemState::DONE);
+        trans.begin();
+        trans.addConsoleOutputLine(1, "line " + std::to_string(i));
+        trans.finish(TransactionState::DONE);
+        upgrades.push_back(upgrade);
+    }
+
+    // the package installed by the second transaction is replaced in the third one
+    upgrades.at(1)->addReplacedBy(upgrades.at(2));
+    upgrades.at(1)->saveReplacedBy();
+
+    Swdb swdb(conn);
+    auto transactions = swdb.listTransactions();
+    CPPUNIT_ASSERT_EQUAL((size_t)3, transactions.size());
+    for (int i = 0; i < 3; ++i) {
+        auto trans = transactions.at(i);
+        CPPUNIT_ASSERT_EQUAL((int64_t)(i + 1), trans->getId());
+        CPPUNIT_ASSERT_EQUAL((int64_t)(i + 2), trans->getDtEnd());
+        CPPUNIT_ASSERT_EQUAL(std::string("end ") + std::to_string(i + 1), trans->getRpmdbVersionEnd());
+        CPPUNIT_ASSERT_EQUAL(TransactionState::DONE, trans->getState());
+
+        // items loaded in bulk must match items loaded for the single transaction
+        auto items = trans->getItems();
+        auto expected = libdnf::Transaction(conn, trans->getId()).getItems();
+        CPPUNIT_ASSERT_EQUAL(expected.size(), items.size());
+        for (size_t j = 0; j < items.size(); ++j) {
+            CPPUNIT_ASSERT_EQUAL(expected.at(j)->getId(), items.at(j)->getId());
+            CPPUNIT_ASSERT_EQUAL(trans->getId(), items.at(j)->getTransactionId());
+            CPPUNIT_ASSERT_EQUAL(expected.at(j)->getItem()->getItemType(),
+                                 items.at(j)->getItem()->getItemType());
+            CPPUNIT_ASSERT_EQUAL(expected.at(j)->getRepoid(), items.at(j)->getRepoid());
+            CPPUNIT_ASSERT_EQUAL(expected.at(j)->getAction(), items.at(j)->getAction());
+            CPPUNIT_ASSERT(replacedByIds(expected.at(j)) == replacedByIds(items.at(j)));
+        }
+        CPPUNIT_ASSERT_EQUAL(std::string("base"), items.at(0)->getRepoid());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, items.at(0)->getReplacedBy().size());
+        CPPUNIT_ASSERT(items.at(0)->getReplacedBy().at(0) == items.at(1));
+    }
+
+    // replacing items in another transaction of the batch are shared
+    auto replacedBy = transactions.at(1)->getItems().at(1)->getReplacedBy();
+    CPPUNIT_ASSERT_EQUAL((size_t)1, replacedBy.size());
+    CPPUNIT_ASSERT(replacedBy.at(0) == transactions.at(2)->getItems().at(1));
+
+    // paging, the replacing item is loaded from outside of the page
+    auto page = swdb.listTransactions(1, 1);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, page.size());
+    CPPUNIT_ASSERT_EQUAL((int64_t)2, page.at(0)->getId());
+    auto pageItems = page.at(0)->getItems();
+    CPPUNIT_ASSERT_EQUAL((size_t)2, pageItems.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, pageItems.at(1)->getReplacedBy().size());
+    CPPUNIT_ASSERT_EQUAL(upgrades.at(2)->getId(), pageItems.at(1)->getReplacedBy().at(0)->getId());
+    CPPUNIT_ASSERT_EQUAL((int64_t)3, pageItems.at(1)->getReplacedBy().at(0)->getTransactionId());
+
+    MergedTransaction merged(transactions.at(2));
+    merged.merge(transactions.at(0));
+    auto output = merged.getConsoleOutput();
+    CPPUNIT_ASSERT_EQUAL((size_t)2, output.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("line 1"), output.at(0).second);
+    CPPUNIT_ASSERT_EQUAL(std::string("line 3"), output.at(1).second);
+}
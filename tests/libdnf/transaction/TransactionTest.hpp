@@ -11,7 +11,9 @@ class TransactionTest : public CppUnit::TestCase {
     CPPUNIT_TEST(testInsert);
     CPPUNIT_TEST(testInsertWithSpecifiedId);
     CPPUNIT_TEST(testUpdate);
+    CPPUNIT_TEST(testConsoleOutput);
     CPPUNIT_TEST(testComparison);
+    CPPUNIT_TEST(testListTransactions);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -21,7 +23,9 @@ public:
     void testInsert();
     void testInsertWithSpecifiedId();
     void testUpdate();
+    void testConsoleOutput();
     void testComparison();
+    void testListTransactions();
 
 private:
     std::shared_ptr< SQLite3 > conn;
@@ -0,0 +1,66 @@
+#include "GlobMatcherTest.hpp"
+
+#include "libdnf/utils/GlobMatcher.hpp"
+
+#include <fnmatch.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GlobMatcherTest);
+
+using libdnf::GlobMatcher;
+
+void GlobMatcherTest::testKind()
+{
+    CPPUNIT_ASSERT(GlobMatcher("*").getKind() == GlobMatcher::Kind::ANY);
+    CPPUNIT_ASSERT(GlobMatcher("**").getKind() == GlobMatcher::Kind::ANY);
+    CPPUNIT_ASSERT(GlobMatcher("penny").getKind() == GlobMatcher::Kind::LITERAL);
+    CPPUNIT_ASSERT(GlobMatcher("penny*").getKind() == GlobMatcher::Kind::PREFIX);
+    CPPUNIT_ASSERT(GlobMatcher("*-lib").getKind() == GlobMatcher::Kind::SUFFIX);
+    CPPUNIT_ASSERT(GlobMatcher("*nn*").getKind() == GlobMatcher::Kind::CONTAINS);
+    CPPUNIT_ASSERT(GlobMatcher("p*n*b").getKind() == GlobMatcher::Kind::SEGMENTS);
+    CPPUNIT_ASSERT(GlobMatcher("p?nny").getKind() == GlobMatcher::Kind::FNMATCH);
+    CPPUNIT_ASSERT(GlobMatcher("[pP]enny").getKind() == GlobMatcher::Kind::FNMATCH);
+    CPPUNIT_ASSERT(GlobMatcher("penny\\*").getKind() == GlobMatcher::Kind::FNMATCH);
+}
+
+void GlobMatcherTest::testMatch()
+{
+    const char * patterns[] = {"*", "", "penny", "penny*", "*lib", "*nn*", "p*n*b", "p*y-*",
+        "*-*-*", "pe*nny", "p?nny*", "[a-p]*", "Penny*", "*.x86_64", nullptr};
+    const char * strings[] = {"", "penny", "penny-lib", "penny-lib-devel", "Penny", "pennypenny",
+        "pen", "p", "penny-1-2.x86_64", "pe-nny", nullptr};
+
+    for (auto pattern = patterns; *pattern; ++pattern) {
+        GlobMatcher matcher(*pattern);
+        for (auto str = strings; *str; ++str) {
+            bool expected = fnmatch(*pattern, *str, 0) == 0;
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(std::string(*pattern) + " " + *str, expected,
+                matcher.match(*str));
+        }
+    }
+}
+
+void GlobMatcherTest::testMatchIcase()
+{
+    CPPUNIT_ASSERT(GlobMatcher("PENNY*", true).match("penny-lib"));
+    CPPUNIT_ASSERT(GlobMatcher("*-LIB", true).match("Penny-lib"));
+    CPPUNIT_ASSERT(GlobMatcher("*NY-l*", true).match("penny-lib"));
+    CPPUNIT_ASSERT(GlobMatcher("p*N*B", true).match("penny-lib"));
+    CPPUNIT_ASSERT(GlobMatcher("P?NNY", true).match("penny"));
+    CPPUNIT_ASSERT(!GlobMatcher("PENNY*").match("penny-lib"));
+    CPPUNIT_ASSERT(!GlobMatcher("*NY-x*", true).match("penny-lib"));
+}
+
+void GlobMatcherTest::testLiteralAndSubstring()
+{
+    CPPUNIT_ASSERT(GlobMatcher::literal("pen*").match("pen*"));
+    CPPUNIT_ASSERT(!GlobMatcher::literal("pen*").match("penny"));
+    CPPUNIT_ASSERT(GlobMatcher::literal("PENNY", true).match("penny"));
+    CPPUNIT_ASSERT(!GlobMatcher::literal("PENNY").match("penny"));
+
+    CPPUNIT_ASSERT(GlobMatcher::substring("").match("penny"));
+    CPPUNIT_ASSERT(GlobMatcher::substring("nny-l").match("penny-lib"));
+    CPPUNIT_ASSERT(!GlobMatcher::substring("?").match("penny"));
+    CPPUNIT_ASSERT(GlobMatcher::substring("NNY-L", true).match("penny-lib"));
+    CPPUNIT_ASSERT(GlobMatcher::substring("-1.", true).match("penny-1.2"));
+    CPPUNIT_ASSERT(!GlobMatcher::substring("-3.", true).match("penny-1.2"));
+}
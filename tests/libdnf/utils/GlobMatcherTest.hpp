@@ -0,0 +1,23 @@
+#ifndef LIBDNF_GLOBMATCHERTEST_HPP
+#define LIBDNF_GLOBMATCHERTEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class GlobMatcherTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(GlobMatcherTest);
+        CPPUNIT_TEST(testKind);
+        CPPUNIT_TEST(testMatch);
+        CPPUNIT_TEST(testMatchIcase);
+        CPPUNIT_TEST(testLiteralAndSubstring);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testKind();
+    void testMatch();
+    void testMatchIcase();
+    void testLiteralAndSubstring();
+};
+
+#endif //LIBDNF_GLOBMATCHERTEST_HPP
@@ -0,0 +1,194 @@
+#include "Sqlite3Test.hpp"
+
+#include "libdnf/utils/sqlite3/Sqlite3.hpp"
+#include "libdnf/utils/utils.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Sqlite3Test);
+
+namespace {
+
+/// Exposes the statement cache of the connection
+class CachingSQLite3 : public SQLite3 {
+public:
+    using SQLite3::SQLite3;
+
+    std::size_t getCacheLimit() const { return STATEMENT_CACHE_SIZE; }
+    std::size_t getCachedCount() const { return statementCache.size(); }
+};
+
+void
+createTable(SQLite3 &db)
+{
+    db.exec("CREATE TABLE numbers (value INTEGER)");
+}
+
+void
+insert(SQLite3 &db, int value)
+{
+    SQLite3::Statement stmt(db, "INSERT INTO numbers VALUES (?)");
+    stmt.bindv(value);
+    stmt.step();
+}
+
+std::vector< int >
+values(SQLite3 &db)
+{
+    SQLite3::Query query(db, "SELECT value FROM numbers ORDER BY value");
+    std::vector< int > result;
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        result.push_back(query.get< int >("value"));
+    }
+    return result;
+}
+
+int
+getSynchronous(SQLite3 &db)
+{
+    SQLite3::Statement stmt(db, "PRAGMA synchronous");
+    stmt.step();
+    return stmt.get< int >(0);
+}
+
+}
+
+void
+Sqlite3Test::setUp()
+{
+    char tmpl[] = "/tmp/libdnf-sqlite3-XXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(tmpl) != nullptr);
+    tmpDir = tmpl;
+}
+
+void
+Sqlite3Test::tearDown()
+{
+    for (const auto &path : libdnf::filesystem::getDirContent(tmpDir)) {
+        std::remove(path.c_str());
+    }
+    rmdir(tmpDir.c_str());
+}
+
+void
+Sqlite3Test::testSavepointCommit()
+{
+    SQLite3 db(":memory:");
+    createTable(db);
+    {
+        SQLite3::Savepoint savepoint(db);
+        insert(db, 1);
+        insert(db, 2);
+        savepoint.commit();
+    }
+    CPPUNIT_ASSERT(values(db) == std::vector< int >({1, 2}));
+}
+
+void
+Sqlite3Test::testSavepointRollback()
+{
+    SQLite3 db(":memory:");
+    createTable(db);
+    insert(db, 1);
+    {
+        SQLite3::Savepoint savepoint(db);
+        insert(db, 2);
+    }
+    CPPUNIT_ASSERT(values(db) == std::vector< int >({1}));
+
+    // the connection is usable after the rollback
+    insert(db, 3);
+    CPPUNIT_ASSERT(values(db) == std::vector< int >({1, 3}));
+}
+
+void
+Sqlite3Test::testNestedSavepoints()
+{
+    SQLite3 db(":memory:");
+    createTable(db);
+
+    // the inner savepoint is rolled back, the outer one keeps its changes
+    {
+        SQLite3::Savepoint outer(db);
+        insert(db, 1);
+        {
+            SQLite3::Savepoint inner(db);
+            insert(db, 2);
+        }
+        insert(db, 3);
+        outer.commit();
+    }
+    CPPUNIT_ASSERT(values(db) == std::vector< int >({1, 3}));
+
+    // rolling back the outer savepoint drops the committed inner one too
+    {
+        SQLite3::Savepoint outer(db);
+        insert(db, 4);
+        {
+            SQLite3::Savepoint inner(db);
+            insert(db, 5);
+            inner.commit();
+        }
+    }
+    CPPUNIT_ASSERT(values(db) == std::vector< int >({1, 3}));
+}
+
+void
+Sqlite3Test::testStatementCache()
+{
+    CachingSQLite3 db(":memory:");
+    auto limit = db.getCacheLimit();
+    CPPUNIT_ASSERT_EQUAL((std::size_t)0, db.getCachedCount());
+
+    // a released statement is kept for reuse and taken back when the same SQL runs again
+    {
+        SQLite3::Statement stmt(db, "SELECT 0");
+        CPPUNIT_ASSERT_EQUAL((std::size_t)0, db.getCachedCount());
+    }
+    CPPUNIT_ASSERT_EQUAL((std::size_t)1, db.getCachedCount());
+    {
+        SQLite3::Statement stmt(db, "SELECT 0");
+        stmt.step();
+        CPPUNIT_ASSERT_EQUAL(0, stmt.get< int >(0));
+        CPPUNIT_ASSERT_EQUAL((std::size_t)0, db.getCachedCount());
+    }
+    CPPUNIT_ASSERT_EQUAL((std::size_t)1, db.getCachedCount());
+
+    // statements released over the limit are finalized
+    {
+        std::vector< std::unique_ptr< SQLite3::Statement > > statements;
+        for (std::size_t i = 1; i <= limit + 10; ++i) {
+            statements.emplace_back(new SQLite3::Statement(db, "SELECT " + std::to_string(i)));
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(limit, db.getCachedCount());
+
+    // cached statements still run
+    for (std::size_t i = 1; i <= limit + 10; ++i) {
+        SQLite3::Statement stmt(db, "SELECT " + std::to_string(i));
+        stmt.step();
+        CPPUNIT_ASSERT_EQUAL((int)i, stmt.get< int >(0));
+    }
+    CPPUNIT_ASSERT_EQUAL(limit, db.getCachedCount());
+
+    db.close();
+    CPPUNIT_ASSERT_EQUAL((std::size_t)0, db.getCachedCount());
+}
+
+void
+Sqlite3Test::testSynchronous()
+{
+    // the sqlite default synchronous=FULL (2) is kept unless relaxed sync is requested
+    {
+        SQLite3 db(tmpDir + "/default.sqlite");
+        CPPUNIT_ASSERT_EQUAL(2, getSynchronous(db));
+    }
+    {
+        SQLite3 db(tmpDir + "/relaxed.sqlite", true);
+        CPPUNIT_ASSERT_EQUAL(1, getSynchronous(db));
+    }
+}
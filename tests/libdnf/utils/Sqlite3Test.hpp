@@ -0,0 +1,33 @@
+#ifndef LIBDNF_SQLITE3TEST_HPP
+#define LIBDNF_SQLITE3TEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class Sqlite3Test : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(Sqlite3Test);
+        CPPUNIT_TEST(testSavepointCommit);
+        CPPUNIT_TEST(testSavepointRollback);
+        CPPUNIT_TEST(testNestedSavepoints);
+        CPPUNIT_TEST(testStatementCache);
+        CPPUNIT_TEST(testSynchronous);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testSavepointCommit();
+    void testSavepointRollback();
+    void testNestedSavepoints();
+    void testStatementCache();
+    void testSynchronous();
+
+private:
+    std::string tmpDir;
+};
+
+#endif //LIBDNF_SQLITE3TEST_HPP